@@ -0,0 +1,20 @@
+{
+  "targets": [
+    {
+      "target_name": "xtest_inject",
+      "type": "executable",
+      "sources": [
+        "xtest_inject.cc"
+      ],
+      "cflags_cc": ["-std=c++17"],
+      "conditions": [
+        ["OS=='linux'", {
+          "libraries": [
+            "-lX11",
+            "-lXtst"
+          ]
+        }]
+      ]
+    }
+  ]
+}
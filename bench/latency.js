@@ -0,0 +1,310 @@
+// End-to-end latency / drop benchmark for the Linux hook.
+//
+// Starts inputhook against an X display (spawning Xvfb when there is none),
+// injects input through bench/build/Release/xtest_inject at controlled rates
+// and pairs each injected event with its JS delivery.
+//
+//   npm run bench:build && npm run bench -- [--xvfb] [--json] [--scenario name]
+//                                          [--backend xi2,xrecord]
+//
+// With several backends every scenario runs once per backend so CPU cost,
+// latency and event fidelity can be compared side by side.
+
+const { spawn } = require('child_process');
+const fs = require('fs');
+const path = require('path');
+const { performance } = require('perf_hooks');
+const readline = require('readline');
+
+const XVFB_DISPLAY = ':99';
+
+// HID usages of the letter keycodes xtest_inject cycles through.
+const LETTER_USAGES = {
+  24: 0x14, 25: 0x1a, 26: 0x08, 27: 0x15, 28: 0x17, 29: 0x1c, 30: 0x18, 31: 0x0c, 32: 0x12, 33: 0x13,
+  38: 0x04, 39: 0x16, 40: 0x07, 41: 0x09, 42: 0x0a, 43: 0x0b, 44: 0x0d, 45: 0x0e, 46: 0x0f,
+  52: 0x1d, 53: 0x1b, 54: 0x06, 55: 0x19, 56: 0x05, 57: 0x11, 58: 0x10
+};
+
+function wheelButton(event) {
+  const dx = event.deltaX || 0;
+  const dy = event.deltaY || 0;
+  if (dx === 0 && (dy === 1 || dy === -1)) {
+    return dy === 1 ? 4 : 5;
+  }
+  if (dy === 0 && (dx === 1 || dx === -1)) {
+    return dx === 1 ? 6 : 7;
+  }
+  return null;
+}
+
+// `marker` reads back the marker xtest_inject reports for each injected event
+// (null when the event does not carry one); markers repeat every `period`
+// injections, or never when `period` is 0.
+const scenarios = [
+  {
+    name: 'typing-storm',
+    args: ['--kind', 'key', '--rate', '250', '--count', '2000'],
+    match: (event) => event.type === 'keydown',
+    marker: (event) => event.keycode,
+    period: Object.keys(LETTER_USAGES).length,
+    faithful: (event) => LETTER_USAGES[event.keycode] === event.hidUsage
+  },
+  {
+    name: 'motion-1000hz',
+    args: ['--kind', 'motion', '--rate', '1000', '--count', '5000'],
+    match: (event) => event.type === 'mousemove',
+    marker: (event) => (Number.isFinite(event.x) && Number.isFinite(event.y) ? event.x * 65536 + event.y : null),
+    period: 0,
+    // Every X11 backend reports the position and both deltas.
+    faithful: (event) => Number.isFinite(event.x) && Number.isFinite(event.y) &&
+      Number.isFinite(event.deltaX) && Number.isFinite(event.deltaY)
+  },
+  {
+    name: 'scroll-bursts',
+    args: ['--kind', 'scroll', '--rate', '2000', '--count', '1000', '--burst', '50', '--pause', '200'],
+    match: (event) => event.type === 'wheel',
+    marker: wheelButton,
+    period: 4,
+    faithful: (event) => wheelButton(event) !== null
+  }
+];
+
+function parseArgs(argv) {
+  const options = { xvfb: false, json: false, scenario: null, settleMs: 500, backends: [undefined] };
+  for (let i = 0; i < argv.length; i += 1) {
+    switch (argv[i]) {
+      case '--xvfb':
+        options.xvfb = true;
+        break;
+      case '--json':
+        options.json = true;
+        break;
+      case '--scenario':
+        options.scenario = argv[++i];
+        break;
+      case '--settle':
+        options.settleMs = Number(argv[++i]);
+        break;
+      case '--backend':
+        options.backends = argv[++i].split(',');
+        break;
+      default:
+        throw new Error(`unknown option ${argv[i]}`);
+    }
+  }
+  return options;
+}
+
+function nowMs() {
+  return performance.timeOrigin + performance.now();
+}
+
+function sleep(ms) {
+  return new Promise((resolve) => setTimeout(resolve, ms));
+}
+
+function percentile(sorted, p) {
+  if (!sorted.length) {
+    return NaN;
+  }
+  const index = Math.min(sorted.length - 1, Math.ceil((p / 100) * sorted.length) - 1);
+  return sorted[Math.max(0, index)];
+}
+
+function summarize(values) {
+  const sorted = values.slice().sort((a, b) => a - b);
+  return {
+    p50: percentile(sorted, 50),
+    p90: percentile(sorted, 90),
+    p99: percentile(sorted, 99),
+    max: sorted.length ? sorted[sorted.length - 1] : NaN
+  };
+}
+
+async function startXvfb() {
+  const socket = `/tmp/.X11-unix/X${XVFB_DISPLAY.slice(1)}`;
+  const xvfb = spawn('Xvfb', [XVFB_DISPLAY, '-screen', '0', '1920x1080x24', '-nolisten', 'tcp'], {
+    stdio: 'ignore'
+  });
+  for (let waited = 0; waited < 5000; waited += 50) {
+    if (fs.existsSync(socket)) {
+      process.env.DISPLAY = XVFB_DISPLAY;
+      return xvfb;
+    }
+    await sleep(50);
+  }
+  xvfb.kill();
+  throw new Error('Xvfb did not come up within 5s');
+}
+
+function runInjector(injector, args) {
+  return new Promise((resolve, reject) => {
+    const child = spawn(injector, args, { stdio: ['ignore', 'pipe', 'inherit'] });
+    let result = null;
+    readline.createInterface({ input: child.stdout }).on('line', (line) => {
+      if (line.startsWith('{')) {
+        result = JSON.parse(line);
+      }
+    });
+    child.on('error', reject);
+    child.on('exit', (code) => {
+      if (code !== 0 || !result) {
+        reject(new Error(`xtest_inject exited with ${code}`));
+        return;
+      }
+      resolve(result);
+    });
+  });
+}
+
+// Walks injected and delivered events in step. A delivered event whose
+// marker belongs to an injection shortly ahead means the current injection was
+// dropped; any other mismatch (a repeat, stray input or a misreported field)
+// is a surplus delivery. With repeating markers the lookahead stops two short
+// of the period so a repeat of the previous marker still reads as surplus,
+// which limits detection to period - 2 consecutive drops.
+function pairEvents(markers, delivered, period) {
+  const firstIndex = new Map();
+  if (!period) {
+    markers.forEach((marker, index) => firstIndex.set(marker, index));
+  }
+  const upcoming = (marker, index) => {
+    if (!period) {
+      return firstIndex.get(marker) > index;
+    }
+    const end = Math.min(markers.length, index + period - 1);
+    for (let j = index + 1; j < end; j += 1) {
+      if (markers[j] === marker) {
+        return true;
+      }
+    }
+    return false;
+  };
+
+  const pairs = [];
+  let next = 0;
+  let surplus = 0;
+  markers.forEach((marker, injectedIndex) => {
+    while (next < delivered.length) {
+      const seen = delivered[next].marker;
+      if (seen === marker) {
+        pairs.push([injectedIndex, next]);
+        next += 1;
+        return;
+      }
+      if (seen !== null && upcoming(seen, injectedIndex)) {
+        return;
+      }
+      surplus += 1;
+      next += 1;
+    }
+  });
+  surplus += delivered.length - next;
+  return { pairs, surplus };
+}
+
+async function runScenario(inputhook, injector, scenario, backend, options) {
+  const received = [];
+  let faithful = 0;
+  inputhook.onEvent((event) => {
+    if (scenario.match(event)) {
+      const marker = scenario.marker(event);
+      received.push({ at: nowMs(), time: event.time, marker: marker === undefined ? null : marker });
+      if (scenario.faithful(event)) {
+        faithful += 1;
+      }
+    }
+  });
+  // Resolves once the backend is live, so no warm-up sleep is needed.
+  await inputhook.startAsync({ backend });
+  const activeBackend = inputhook.getStats().backend;
+
+  const cpuBefore = process.cpuUsage();
+  const wallBefore = nowMs();
+  const injected = await runInjector(injector, scenario.args);
+  await sleep(options.settleMs);
+  const cpu = process.cpuUsage(cpuBefore);
+  const wallMs = nowMs() - wallBefore;
+  await inputhook.stopAsync();
+
+  const { pairs, surplus } = pairEvents(injected.markers, received, scenario.period);
+  const jsLatency = [];
+  const hookLatency = [];
+  for (const [injectedIndex, receivedIndex] of pairs) {
+    jsLatency.push(received[receivedIndex].at - injected.times[injectedIndex]);
+    hookLatency.push(received[receivedIndex].time - injected.times[injectedIndex]);
+  }
+  const injectedCount = injected.times.length;
+
+  return {
+    scenario: scenario.name,
+    backend: activeBackend,
+    injected: injectedCount,
+    delivered: received.length,
+    // Injected events with no delivered match, and deliveries matching no
+    // injected event (duplicates, stray input or misreported fields).
+    missing: injectedCount - pairs.length,
+    surplus,
+    dropRate: injectedCount ? (injectedCount - pairs.length) / injectedCount : 0,
+    // Share of delivered events carrying the expected fields and values.
+    fidelity: received.length ? faithful / received.length : 0,
+    latencyMs: summarize(jsLatency),
+    hookLatencyMs: summarize(hookLatency),
+    cpuPercent: ((cpu.user + cpu.system) / 1000 / wallMs) * 100
+  };
+}
+
+function printResult(result) {
+  const fmt = (value) => (Number.isFinite(value) ? value.toFixed(2) : '-');
+  console.log(`${result.scenario} [${result.backend}]`);
+  console.log(`  delivered ${result.delivered}/${result.injected} (drop ${(result.dropRate * 100).toFixed(2)}%, ` +
+              `surplus ${result.surplus}), fidelity ${(result.fidelity * 100).toFixed(2)}%`);
+  console.log(`  inject->JS   p50 ${fmt(result.latencyMs.p50)} p90 ${fmt(result.latencyMs.p90)} ` +
+              `p99 ${fmt(result.latencyMs.p99)} max ${fmt(result.latencyMs.max)} ms`);
+  console.log(`  inject->hook p50 ${fmt(result.hookLatencyMs.p50)} p90 ${fmt(result.hookLatencyMs.p90)} ` +
+              `p99 ${fmt(result.hookLatencyMs.p99)} max ${fmt(result.hookLatencyMs.max)} ms`);
+  console.log(`  cpu ${fmt(result.cpuPercent)}% of one core`);
+}
+
+async function main() {
+  const options = parseArgs(process.argv.slice(2));
+  const injector = path.join(__dirname, 'build', 'Release', 'xtest_inject');
+  if (!fs.existsSync(injector)) {
+    throw new Error('xtest_inject not built. Run `npm run bench:build` first.');
+  }
+
+  let xvfb = null;
+  if (options.xvfb || !process.env.DISPLAY) {
+    xvfb = await startXvfb();
+  }
+
+  const inputhook = require('..');
+  const results = [];
+  try {
+    for (const scenario of scenarios) {
+      if (options.scenario && options.scenario !== scenario.name) {
+        continue;
+      }
+      for (const backend of options.backends) {
+        const result = await runScenario(inputhook, injector, scenario, backend, options);
+        results.push(result);
+        if (!options.json) {
+          printResult(result);
+        }
+      }
+    }
+  } finally {
+    if (xvfb) {
+      xvfb.kill();
+    }
+  }
+
+  if (options.json) {
+    console.log(JSON.stringify(results, null, 2));
+  }
+}
+
+main().catch((error) => {
+  console.error(error.message);
+  process.exit(1);
+});
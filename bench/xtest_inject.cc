@@ -0,0 +1,167 @@
+// Injects synthetic input through XTest at a controlled rate and reports the
+// injection timestamps so bench/latency.js can pair them with delivered events.
+//
+//   xtest_inject --kind key|motion|scroll --rate <hz> --count <n>
+//                [--burst <n> --pause <ms>]
+//
+// Prints "ready" once connected, then a single JSON line
+// {"kind":...,"times":[epoch ms...],"markers":[...]} after the last event has
+// been flushed. Each event carries a marker the consumer can read back from
+// the delivered event: the keycode for keys, the button for scroll and
+// x * 65536 + y for motion, which moves to a position unique per event.
+
+#include <X11/Xlib.h>
+#include <X11/extensions/XTest.h>
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <time.h>
+#include <vector>
+
+namespace {
+
+// The letter keys, cycled so consecutive keystrokes differ.
+constexpr unsigned int kLetterKeycodes[] = {
+    24, 25, 26, 27, 28, 29, 30, 31, 32, 33,  // q..p
+    38, 39, 40, 41, 42, 43, 44, 45, 46,      // a..l
+    52, 53, 54, 55, 56, 57, 58               // z..m
+};
+constexpr long kLetterCount = sizeof(kLetterKeycodes) / sizeof(kLetterKeycodes[0]);
+// Wheel up, down, left and right.
+constexpr unsigned int kWheelButtons[] = {4, 5, 6, 7};
+// Motion walks a kMotionColumns x kMotionRows grid starting at kMotionOrigin.
+constexpr int kMotionOrigin = 100;
+constexpr long kMotionColumns = 1600;
+constexpr long kMotionRows = 800;
+
+struct Options {
+  std::string kind = "key";
+  double rate = 1000.0;
+  long count = 1000;
+  long burst = 0;
+  long pauseMs = 0;
+};
+
+double EpochMs() {
+  struct timespec now;
+  clock_gettime(CLOCK_REALTIME, &now);
+  return now.tv_sec * 1000.0 + now.tv_nsec / 1e6;
+}
+
+void AddNanos(struct timespec& deadline, long long nanos) {
+  long long total = deadline.tv_nsec + nanos;
+  deadline.tv_sec += total / 1000000000LL;
+  deadline.tv_nsec = total % 1000000000LL;
+}
+
+bool ParseOptions(int argc, char** argv, Options& options) {
+  for (int i = 1; i + 1 < argc; i += 2) {
+    if (!std::strcmp(argv[i], "--kind")) {
+      options.kind = argv[i + 1];
+    } else if (!std::strcmp(argv[i], "--rate")) {
+      options.rate = std::atof(argv[i + 1]);
+    } else if (!std::strcmp(argv[i], "--count")) {
+      options.count = std::atol(argv[i + 1]);
+    } else if (!std::strcmp(argv[i], "--burst")) {
+      options.burst = std::atol(argv[i + 1]);
+    } else if (!std::strcmp(argv[i], "--pause")) {
+      options.pauseMs = std::atol(argv[i + 1]);
+    } else {
+      return false;
+    }
+  }
+  return options.rate > 0 && options.count > 0 &&
+         (options.kind == "key" || options.kind == "motion" || options.kind == "scroll");
+}
+
+// Queues the index-th event and returns its marker.
+long Inject(Display* display, const Options& options, long index) {
+  if (options.kind == "key") {
+    unsigned int keycode = kLetterKeycodes[index % kLetterCount];
+    XTestFakeKeyEvent(display, keycode, True, CurrentTime);
+    XTestFakeKeyEvent(display, keycode, False, CurrentTime);
+    return keycode;
+  }
+  if (options.kind == "motion") {
+    int x = kMotionOrigin + static_cast<int>(index % kMotionColumns);
+    int y = kMotionOrigin + static_cast<int>((index / kMotionColumns) % kMotionRows);
+    XTestFakeMotionEvent(display, -1, x, y, CurrentTime);
+    return x * 65536L + y;
+  }
+  unsigned int button = kWheelButtons[index % 4];
+  XTestFakeButtonEvent(display, button, True, CurrentTime);
+  XTestFakeButtonEvent(display, button, False, CurrentTime);
+  return button;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+  Options options;
+  if (!ParseOptions(argc, argv, options)) {
+    std::fprintf(stderr,
+                 "usage: xtest_inject --kind key|motion|scroll --rate <hz> --count <n> "
+                 "[--burst <n> --pause <ms>]\n");
+    return 2;
+  }
+
+  Display* display = XOpenDisplay(nullptr);
+  if (!display) {
+    std::fprintf(stderr, "xtest_inject: unable to open display\n");
+    return 1;
+  }
+  int eventBase = 0;
+  int errorBase = 0;
+  int major = 0;
+  int minor = 0;
+  if (!XTestQueryExtension(display, &eventBase, &errorBase, &major, &minor)) {
+    std::fprintf(stderr, "xtest_inject: XTEST extension not available\n");
+    XCloseDisplay(display);
+    return 1;
+  }
+
+  std::printf("ready\n");
+  std::fflush(stdout);
+
+  // Give the consumer a moment to observe "ready" before the first event.
+  struct timespec deadline;
+  clock_gettime(CLOCK_MONOTONIC, &deadline);
+  AddNanos(deadline, 200000000LL);
+
+  const long long intervalNs = static_cast<long long>(1e9 / options.rate);
+  std::vector<double> times;
+  std::vector<long> markers;
+  times.reserve(static_cast<size_t>(options.count));
+  markers.reserve(static_cast<size_t>(options.count));
+
+  for (long i = 0; i < options.count; ++i) {
+    clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &deadline, nullptr);
+    markers.push_back(Inject(display, options, i));
+    // Stamp before the flush: the server may deliver the event to the hook
+    // before XFlush returns.
+    times.push_back(EpochMs());
+    XFlush(display);
+
+    AddNanos(deadline, intervalNs);
+    if (options.burst > 0 && (i + 1) % options.burst == 0) {
+      AddNanos(deadline, options.pauseMs * 1000000LL);
+    }
+  }
+  XSync(display, False);
+
+  std::printf("{\"kind\":\"%s\",\"times\":[", options.kind.c_str());
+  for (size_t i = 0; i < times.size(); ++i) {
+    std::printf(i == 0 ? "%.3f" : ",%.3f", times[i]);
+  }
+  std::printf("],\"markers\":[");
+  for (size_t i = 0; i < markers.size(); ++i) {
+    std::printf(i == 0 ? "%ld" : ",%ld", markers[i]);
+  }
+  std::printf("]}\n");
+  std::fflush(stdout);
+
+  XCloseDisplay(display);
+  return 0;
+}
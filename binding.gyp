@@ -4,7 +4,18 @@
       "target_name": "inputhook",
       "sources": [
         "src/addon.cc",
-        "src/common/emitter.cc"
+        "src/common/app_usage.cc",
+        "src/common/emitter.cc",
+        "src/common/event_broadcast.cc",
+        "src/common/event_stream.cc",
+        "src/common/frame_writer.cc",
+        "src/common/gestures.cc",
+        "src/common/heatmap.cc",
+        "src/common/hotkeys.cc",
+        "src/common/kinematics.cc",
+        "src/common/mapped_file.cc",
+        "src/common/timeline.cc",
+        "src/common/typing.cc"
       ],
       "include_dirs": [
         "<!(node -p \"require('node-addon-api').include.slice(1, -1)\")"
@@ -16,10 +27,12 @@
       "conditions": [
         ["OS=='win'", {
           "sources": [
-            "src/platform/win/hook_win.cc"
+            "src/platform/win/hook_win.cc",
+            "src/platform/win/idle_win.cc"
           ],
           "libraries": [
-            "-luser32"
+            "-luser32",
+            "-lwtsapi32"
           ],
           "msvs_settings": {
             "VCCLCompilerTool": {
@@ -29,7 +42,8 @@
         }],
         ["OS=='mac'", {
           "sources": [
-            "src/platform/mac/hook_mac.mm"
+            "src/platform/mac/hook_mac.mm",
+            "src/platform/mac/idle_mac.mm"
           ],
           "xcode_settings": {
             "OTHER_LDFLAGS": [
@@ -44,11 +58,24 @@
         }],
         ["OS=='linux'", {
           "sources": [
-            "src/platform/linux/hook_x11.cc"
+            "src/platform/linux/hook_evdev.cc",
+            "src/platform/linux/hook_x11.cc",
+            "src/platform/linux/hook_xrecord.cc",
+            "src/platform/linux/idle_x11.cc"
+          ],
+          "defines": [
+            "INPUTHOOK_X11_IOERROR_EXIT=<!(pkg-config --atleast-version=1.7.0 x11 && echo 1 || echo 0)"
           ],
           "libraries": [
             "-lX11",
-            "-lXi"
+            "-lX11-xcb",
+            "-lXi",
+            "-lXext",
+            "-lXrandr",
+            "-lXss",
+            "-lXtst",
+            "-lrt",
+            "-lxcb"
           ]
         }]
       ]
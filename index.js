@@ -1,5 +1,6 @@
 const path = require('path');
 const fs = require('fs');
+const { Readable } = require('stream');
 
 function resolveBinding() {
   const releasePath = path.join(__dirname, 'build', 'Release', 'inputhook.node');
@@ -17,10 +18,297 @@ function resolveBinding() {
 
 const binding = require(resolveBinding());
 
+function buildHidUsages() {
+  const usages = {
+    Enter: 0x28,
+    Escape: 0x29,
+    Backspace: 0x2a,
+    Tab: 0x2b,
+    Space: 0x2c,
+    Minus: 0x2d,
+    Equal: 0x2e,
+    BracketLeft: 0x2f,
+    BracketRight: 0x30,
+    Backslash: 0x31,
+    Semicolon: 0x33,
+    Quote: 0x34,
+    Backquote: 0x35,
+    Comma: 0x36,
+    Period: 0x37,
+    Slash: 0x38,
+    CapsLock: 0x39,
+    PrintScreen: 0x46,
+    ScrollLock: 0x47,
+    Pause: 0x48,
+    Insert: 0x49,
+    Home: 0x4a,
+    PageUp: 0x4b,
+    Delete: 0x4c,
+    End: 0x4d,
+    PageDown: 0x4e,
+    ArrowRight: 0x4f,
+    ArrowLeft: 0x50,
+    ArrowDown: 0x51,
+    ArrowUp: 0x52,
+    NumLock: 0x53,
+    ContextMenu: 0x65
+  };
+  for (let i = 0; i < 26; i += 1) {
+    usages[String.fromCharCode(65 + i)] = 0x04 + i;
+  }
+  for (let i = 1; i <= 9; i += 1) {
+    usages[String(i)] = 0x1e + i - 1;
+  }
+  usages['0'] = 0x27;
+  for (let i = 1; i <= 12; i += 1) {
+    usages[`F${i}`] = 0x3a + i - 1;
+  }
+  for (let i = 13; i <= 24; i += 1) {
+    usages[`F${i}`] = 0x68 + i - 13;
+  }
+  return Object.freeze(usages);
+}
+
+const HidUsage = buildHidUsages();
+
+const modifierNames = {
+  shift: 'shift',
+  ctrl: 'ctrl',
+  control: 'ctrl',
+  alt: 'alt',
+  option: 'alt',
+  meta: 'meta',
+  cmd: 'meta',
+  command: 'meta',
+  super: 'meta',
+  win: 'meta'
+};
+
+function parseChord(chord) {
+  const parsed = { usages: [], shift: false, ctrl: false, alt: false, meta: false };
+  for (const part of chord.split('+')) {
+    const name = part.trim();
+    const modifier = modifierNames[name.toLowerCase()];
+    if (modifier) {
+      parsed[modifier] = true;
+      continue;
+    }
+    const usage = HidUsage[name.length === 1 ? name.toUpperCase() : name];
+    if (usage === undefined) {
+      throw new TypeError(`unknown key "${name}" in hotkey "${chord}"`);
+    }
+    parsed.usages.push(usage);
+  }
+  return parsed;
+}
+
+function registerHotkeys(hotkeys, callback) {
+  const definitions = hotkeys.map((hotkey) => ({
+    id: String(hotkey.id),
+    timeout: hotkey.timeout,
+    sequence: typeof hotkey.keys === 'string'
+      ? hotkey.keys.trim().split(/\s+/).map(parseChord)
+      : hotkey.keys
+  }));
+  binding.registerHotkeys(definitions, callback);
+}
+
+// Layout of the records produced by stream({ binary: true }); see
+// src/common/event_codec.h.
+const EVENT_RECORD_SIZE = 48;
+const encodedTypes = [
+  'other', 'keydown', 'keyup', 'mousedown', 'mouseup', 'mousemove', 'wheel',
+  'focus', 'lock', 'unlock', 'click', 'dragstart', 'dragend'
+];
+
+// [presence flag, property, reader] for the optional fields of a record.
+const encodedFields = [
+  [0x001, 'keycode', (view, offset) => view.getUint32(offset + 12, true)],
+  [0x002, 'scancode', (view, offset) => view.getUint32(offset + 16, true)],
+  [0x004, 'hidUsage', (view, offset) => view.getUint16(offset + 20, true)],
+  [0x008, 'button', (view, offset) => view.getUint8(offset + 22)],
+  [0x010, 'clicks', (view, offset) => view.getUint8(offset + 23)],
+  [0x020, 'x', (view, offset) => view.getInt32(offset + 24, true)],
+  [0x020, 'y', (view, offset) => view.getInt32(offset + 28, true)],
+  [0x040, 'deltaX', (view, offset) => view.getInt32(offset + 32, true)],
+  [0x080, 'deltaY', (view, offset) => view.getInt32(offset + 36, true)],
+  [0x100, 'window', (view, offset) => Number(view.getBigUint64(offset + 40, true))]
+];
+
+function decodeEvents(buffer) {
+  const view = new DataView(buffer.buffer, buffer.byteOffset, buffer.byteLength);
+  const events = [];
+  for (let offset = 0; offset + EVENT_RECORD_SIZE <= buffer.byteLength; offset += EVENT_RECORD_SIZE) {
+    const event = {
+      type: encodedTypes[view.getUint8(offset + 8)] || 'other',
+      time: view.getFloat64(offset, true)
+    };
+    const fields = view.getUint16(offset + 10, true);
+    for (const [flag, name, read] of encodedFields) {
+      if (fields & flag) {
+        event[name] = read(view, offset);
+      }
+    }
+    const modifiers = view.getUint8(offset + 9);
+    event.modifiers = {
+      shift: (modifiers & 1) !== 0,
+      ctrl: (modifiers & 2) !== 0,
+      alt: (modifiers & 4) !== 0,
+      meta: (modifiers & 8) !== 0
+    };
+    events.push(event);
+  }
+  return events;
+}
+
+// The Readable pulls from the native queue only when it wants more data, so a
+// slow consumer leaves events in that bounded queue (where motion coalesces)
+// rather than in an ever-growing callback queue.
+function stream(options = {}) {
+  const binary = Boolean(options.binary);
+  const batchSize = options.batchSize || 256;
+  let waiting = false;
+  let readable = null;
+  // Events of the last batch that did not fit under highWaterMark.
+  let pending = [];
+  let next = 0;
+
+  function pull() {
+    if (next === pending.length) {
+      const chunk = binding.readStream(batchSize, binary);
+      if (chunk.length === 0) {
+        // The native side calls back once the next event is queued.
+        waiting = true;
+        return;
+      }
+      if (binary) {
+        readable.push(chunk);
+        return;
+      }
+      pending = chunk;
+      next = 0;
+    }
+    while (next < pending.length) {
+      if (!readable.push(pending[next++])) {
+        return;
+      }
+    }
+  }
+
+  readable = new Readable({
+    objectMode: !binary,
+    highWaterMark: options.highWaterMark || (binary ? 64 * EVENT_RECORD_SIZE : 64),
+    read: pull,
+    destroy(error, callback) {
+      binding.closeStream();
+      callback(error);
+    }
+  });
+
+  binding.openStream({ capacity: options.capacity }, () => {
+    if (waiting && !readable.destroyed) {
+      waiting = false;
+      pull();
+    }
+  });
+  return readable;
+}
+
+// Reads a shared-memory broadcast published by configureBroadcast(), possibly
+// in another process. There is nothing to wake a reader across processes, so
+// an empty ring is polled every `interval` ms; a reader that falls more than
+// the ring's capacity behind skips ahead, and stats().lost counts what it
+// missed. A segment replaced by one of another capacity fails the stream
+// once it is drained.
+function subscribe(name, options = {}) {
+  const binary = Boolean(options.binary);
+  const batchSize = options.batchSize || 256;
+  const interval = options.interval || 16;
+  const id = binding.openSubscription(name, Boolean(options.fromStart));
+  let timer = null;
+  let readable = null;
+  // Events of the last batch that did not fit under highWaterMark.
+  let pending = [];
+  let next = 0;
+
+  function pull() {
+    timer = null;
+    if (next === pending.length) {
+      const chunk = binding.readSubscription(id, batchSize);
+      if (chunk.length === 0) {
+        if (binding.getSubscriptionStats(id).replaced) {
+          readable.destroy(new Error(`broadcast ${name} was replaced; subscribe again`));
+          return;
+        }
+        timer = setTimeout(pull, interval);
+        return;
+      }
+      if (binary) {
+        readable.push(chunk);
+        return;
+      }
+      pending = decodeEvents(chunk);
+      next = 0;
+    }
+    while (next < pending.length) {
+      if (!readable.push(pending[next++])) {
+        return;
+      }
+    }
+  }
+
+  readable = new Readable({
+    objectMode: !binary,
+    highWaterMark: options.highWaterMark || (binary ? 64 * EVENT_RECORD_SIZE : 64),
+    read() {
+      if (!timer) {
+        pull();
+      }
+    },
+    destroy(error, callback) {
+      clearTimeout(timer);
+      timer = null;
+      binding.closeSubscription(id);
+      callback(error);
+    }
+  });
+  readable.stats = () => binding.getSubscriptionStats(id);
+  return readable;
+}
+
 module.exports = {
   start: binding.start,
   stop: binding.stop,
+  startAsync: binding.startAsync,
+  stopAsync: binding.stopAsync,
+  pause: binding.pause,
+  resume: binding.resume,
   onEvent: binding.onEvent,
+  stream,
+  subscribe,
+  decodeEvents,
+  EVENT_RECORD_SIZE,
+  registerHotkeys,
+  unregisterHotkeys: binding.unregisterHotkeys,
+  configureOutput: binding.configureOutput,
+  configureBroadcast: binding.configureBroadcast,
+  configurePipeline: binding.configurePipeline,
+  configureGestures: binding.configureGestures,
+  configureHeatmap: binding.configureHeatmap,
+  getHeatmap: binding.getHeatmap,
+  resetHeatmap: binding.resetHeatmap,
+  configureTypingStats: binding.configureTypingStats,
+  getTypingStats: binding.getTypingStats,
+  configureMouseStats: binding.configureMouseStats,
+  getMouseStats: binding.getMouseStats,
+  configureTimeline: binding.configureTimeline,
+  getTimeline: binding.getTimeline,
+  configureAppUsage: binding.configureAppUsage,
+  getAppUsage: binding.getAppUsage,
   getFailureReason: binding.getFailureReason,
-  getLastError: binding.getLastError
+  getLastError: binding.getLastError,
+  getStats: binding.getStats,
+  listBackends: binding.listBackends,
+  getIdleTime: binding.getIdleTime,
+  HidUsage
 };
@@ -1,11 +1,32 @@
+#include <algorithm>
 #include <atomic>
+#include <chrono>
+#include <future>
+#include <map>
 #include <memory>
+#include <mutex>
+#include <optional>
 #include <string>
+#include <utility>
+#include <vector>
 
 #include <napi.h>
 
+#include "common/app_usage.h"
 #include "common/emitter.h"
 #include "common/event.h"
+#include "common/event_broadcast.h"
+#include "common/event_codec.h"
+#include "common/event_stream.h"
+#include "common/frame_writer.h"
+#include "common/gestures.h"
+#include "common/heatmap.h"
+#include "common/hotkeys.h"
+#include "common/idle.h"
+#include "common/kinematics.h"
+#include "common/pipeline.h"
+#include "common/timeline.h"
+#include "common/typing.h"
 
 namespace {
 
@@ -14,27 +35,280 @@ void CallJsEvent(Napi::Env env,
                  void* /*context*/,
                  inputhook::InputEvent* event);
 
+void CallJsHotkey(Napi::Env env,
+                  Napi::Function callback,
+                  void* /*context*/,
+                  inputhook::HotkeyMatch* match);
+
+void CallJsMouseStats(Napi::Env env,
+                      Napi::Function callback,
+                      void* /*context*/,
+                      inputhook::MouseStatsSnapshot* snapshot);
+
+void CallJsStreamWake(Napi::Env env, Napi::Function callback, void* /*context*/, void* /*data*/);
+
 using EventTsfn =
     Napi::TypedThreadSafeFunction<void, inputhook::InputEvent, CallJsEvent>;
+using HotkeyTsfn =
+    Napi::TypedThreadSafeFunction<void, inputhook::HotkeyMatch, CallJsHotkey>;
+using MouseStatsTsfn =
+    Napi::TypedThreadSafeFunction<void, inputhook::MouseStatsSnapshot, CallJsMouseStats>;
+using StreamTsfn = Napi::TypedThreadSafeFunction<void, void, CallJsStreamWake>;
+
+// Hands a threadsafe function to the hook thread. Callers there take their
+// own reference for the duration of a call, so replacing or releasing it on
+// the JS thread never frees it under a NonBlockingCall().
+template <typename Tsfn>
+class TsfnSlot {
+ public:
+  std::shared_ptr<Tsfn> Get() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return tsfn_;
+  }
+
+  // Lock-free, for the per-event checks.
+  explicit operator bool() const { return published_.load(std::memory_order_acquire); }
+
+  void Publish(Tsfn&& tsfn) {
+    auto published = std::make_shared<Tsfn>(std::move(tsfn));
+    std::lock_guard<std::mutex> lock(mutex_);
+    tsfn_ = std::move(published);
+    published_.store(true, std::memory_order_release);
+  }
 
-std::atomic<EventTsfn*> g_tsfnPointer{nullptr};
+  // Aborts the published function; the last reference frees it.
+  void Retire() {
+    std::shared_ptr<Tsfn> previous;
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      previous = std::move(tsfn_);
+      published_.store(false, std::memory_order_release);
+    }
+    if (previous) {
+      previous->Abort();
+    }
+  }
+
+ private:
+  mutable std::mutex mutex_;
+  std::shared_ptr<Tsfn> tsfn_;
+  std::atomic<bool> published_{false};
+};
+
+// The hook, its callbacks and the files it writes are process-wide, while
+// worker threads load the addon into environments of their own. They belong
+// to the first environment that sets any of them up; the others get an error
+// until the owner exits, and only the owner's exit tears them down.
+std::mutex g_hookEnvMutex;
+napi_env g_hookEnv = nullptr;
+TsfnSlot<EventTsfn> g_tsfn;
+TsfnSlot<HotkeyTsfn> g_hotkeyTsfn;
+TsfnSlot<MouseStatsTsfn> g_mouseStatsTsfn;
+TsfnSlot<StreamTsfn> g_streamTsfn;
 std::atomic<bool> g_running{false};
+std::atomic<uint64_t> g_eventCount{0};
+std::atomic<uint64_t> g_droppedCount{0};
+// Set while a startAsync/stopAsync worker owns the emitter.
+bool g_transitioning = false;
+// Ready once the running startAsync worker is done with g_emitter, so Cleanup
+// never frees the hook under it.
+std::shared_future<void> g_startExecuted;
 std::unique_ptr<inputhook::InputEmitter> g_emitter;
-std::unique_ptr<EventTsfn> g_tsfnHolder;
+// Survives stop/start so a hook started during a pause starts paused.
+bool g_paused = false;
+// Failure reason of the last start attempt, kept after its emitter is gone.
+std::string g_failureReason;
+inputhook::EventStream g_stream;
+inputhook::FrameWriter g_output;
+inputhook::BroadcastPublisher g_broadcast;
+// Worker threads load the addon into the same process, so broadcast state is
+// kept per environment: each has its own subscriptions, and the publisher
+// belongs to the environment that configured it. Only the map itself is
+// shared; an environment's entry is only touched on its own thread.
+struct EnvBroadcast {
+  // Readers attached with openSubscription(), by the id handed back to JS.
+  std::map<uint32_t, std::unique_ptr<inputhook::BroadcastSubscriber>> subscriptions;
+  uint32_t nextSubscriptionId = 1;
+};
+std::mutex g_envBroadcastMutex;
+std::map<napi_env, EnvBroadcast> g_envBroadcasts;
+napi_env g_broadcastEnv = nullptr;
+inputhook::HotkeyMatcher g_hotkeys;
+inputhook::GestureTracker g_gestures;
+inputhook::HeatmapAggregator g_heatmap;
+inputhook::TypingStats g_typing;
+inputhook::MouseKinematics g_mouseStats;
+inputhook::ActivityTimeline g_timeline;
+inputhook::AppUsageLedger g_appUsage;
+
+double NowMs() {
+  using namespace std::chrono;
+  return duration<double, std::milli>(system_clock::now().time_since_epoch()).count();
+}
+
+// Aggregators are pull-based, so an enabled one is reason enough to run the hook.
+bool HasConsumers() {
+  return g_tsfn || g_hotkeyTsfn || g_streamTsfn ||
+         g_heatmap.Options().enabled || g_typing.Options().enabled ||
+         g_mouseStats.Options().enabled || g_timeline.Options().enabled ||
+         g_appUsage.Options().enabled || g_output.IsOpen() || g_broadcast.IsOpen();
+}
 
-void EventDispatcher(inputhook::InputEvent&& event) {
-  EventTsfn* tsfn = g_tsfnPointer.load(std::memory_order_acquire);
+void DispatchHotkeys(const inputhook::InputEvent& event) {
+  std::shared_ptr<HotkeyTsfn> tsfn = g_hotkeyTsfn.Get();
   if (!tsfn) {
     return;
   }
 
+  thread_local std::vector<inputhook::HotkeyMatch> matches;
+  matches.clear();
+  g_hotkeys.Process(event, &matches);
+  for (auto& match : matches) {
+    auto* matchCopy = new inputhook::HotkeyMatch(std::move(match));
+    napi_status status = tsfn->NonBlockingCall(matchCopy);
+    if (status != napi_ok) {
+      delete matchCopy;
+    }
+  }
+}
+
+void DispatchMouseStats(const inputhook::InputEvent& event) {
+  std::shared_ptr<MouseStatsTsfn> tsfn = g_mouseStatsTsfn.Get();
+  std::optional<inputhook::MouseStatsSnapshot> summary;
+  g_mouseStats.Process(event, tsfn ? &summary : nullptr);
+  if (!summary) {
+    return;
+  }
+
+  auto* summaryCopy = new inputhook::MouseStatsSnapshot(std::move(*summary));
+  napi_status status = tsfn->NonBlockingCall(summaryCopy);
+  if (status != napi_ok) {
+    delete summaryCopy;
+  }
+}
+
+void PostEvent(EventTsfn* tsfn, inputhook::InputEvent&& event) {
   auto* eventCopy = new inputhook::InputEvent(std::move(event));
   napi_status status = tsfn->NonBlockingCall(eventCopy);
   if (status != napi_ok) {
+    g_droppedCount.fetch_add(1, std::memory_order_relaxed);
     delete eventCopy;
   }
 }
 
+// Only an empty-to-non-empty transition while the reader waits costs a
+// threadsafe-function call; otherwise the reader pulls on its own.
+void StreamEvent(const inputhook::InputEvent& event) {
+  std::shared_ptr<StreamTsfn> tsfn = g_streamTsfn.Get();
+  if (tsfn && g_stream.Push(event)) {
+    tsfn->NonBlockingCall();
+  }
+}
+
+// Forgets held keys and buttons. Used wherever releases can go unseen: a
+// pause, a lost connection, a lock (Win+L never delivers its keyups) and
+// stop.
+void ResetKeyState() {
+  g_hotkeys.Reset();
+  g_gestures.Reset();
+  g_typing.ResetKeys();
+  g_timeline.ResetKeys();
+  g_appUsage.ResetKeys();
+}
+
+// True when something past the aggregators takes events: onEvent, the
+// stream, the output or the broadcast ring.
+bool HasDeliveryTargets() {
+  return g_tsfn || g_stream.IsOpen() ||
+         g_output.IsOpen() || g_broadcast.IsOpen();
+}
+
+struct CountStage : inputhook::UnbufferedStage {
+  template <typename Next>
+  void Process(inputhook::InputEvent&& event, Next&& next) {
+    g_eventCount.fetch_add(1, std::memory_order_relaxed);
+    next(std::move(event));
+  }
+};
+
+// Feeds hotkeys and the aggregators, which see every event that passes the
+// filter whether or not anything else is listening.
+struct AggregateStage : inputhook::UnbufferedStage {
+  template <typename Next>
+  void Process(inputhook::InputEvent&& event, Next&& next) {
+    if (event.typeBit == inputhook::kLockBit && event.type == "lock") {
+      ResetKeyState();
+    }
+    DispatchHotkeys(event);
+    g_heatmap.Process(event);
+    g_typing.Process(event);
+    g_timeline.Process(event);
+    g_appUsage.Process(event);
+    DispatchMouseStats(event);
+    next(std::move(event));
+  }
+
+  void Reset() {
+    ResetKeyState();
+  }
+};
+
+// Derives click and drag events, which follow their source event on to the
+// delivery targets. Without targets the chain ends here.
+struct GestureStage : inputhook::UnbufferedStage {
+  template <typename Next>
+  void Process(inputhook::InputEvent&& event, Next&& next) {
+    if (!HasDeliveryTargets()) {
+      return;
+    }
+    thread_local std::vector<inputhook::InputEvent> derived;
+    derived.clear();
+    g_gestures.Process(event, &derived);
+    next(std::move(event));
+    for (auto& derivedEvent : derived) {
+      next(std::move(derivedEvent));
+    }
+  }
+};
+
+struct DeliverStage : inputhook::UnbufferedStage {
+  template <typename Next>
+  void Process(inputhook::InputEvent&& event, Next&&) {
+    if (g_stream.IsOpen()) {
+      StreamEvent(event);
+    }
+    if (g_output.IsOpen()) {
+      g_output.Push(event);
+    }
+    if (g_broadcast.IsOpen()) {
+      g_broadcast.Publish(event);
+    }
+    std::shared_ptr<EventTsfn> tsfn = g_tsfn.Get();
+    if (tsfn) {
+      PostEvent(tsfn.get(), std::move(event));
+    }
+  }
+};
+
+// Dedupe and motion coalescing are either compiled into the chain or left
+// out; configurePipeline() picks the composition.
+template <typename... Optional>
+using EventPipeline = inputhook::Pipeline<CountStage,
+                                          inputhook::TypeFilterStage,
+                                          Optional...,
+                                          AggregateStage,
+                                          GestureStage,
+                                          DeliverStage>;
+using PlainPipeline = EventPipeline<>;
+using DedupePipeline = EventPipeline<inputhook::DedupeStage>;
+using CoalescePipeline = EventPipeline<inputhook::MotionCoalesceStage>;
+using DedupeCoalescePipeline =
+    EventPipeline<inputhook::DedupeStage, inputhook::MotionCoalesceStage>;
+inputhook::PipelineSwitch<PlainPipeline, DedupePipeline, CoalescePipeline, DedupeCoalescePipeline>
+    g_pipeline;
+bool g_dedupe = false;
+bool g_coalesceMotion = false;
+
 void CallJsEvent(Napi::Env env,
                  Napi::Function callback,
                  void* /*context*/,
@@ -42,18 +316,101 @@ void CallJsEvent(Napi::Env env,
   if (!event) {
     return;
   }
+  // Abort() drains what is still queued with a null env.
+  if (env == nullptr) {
+    delete event;
+    return;
+  }
 
   Napi::HandleScope scope(env);
   callback.Call({inputhook::ToJsObject(env, *event)});
   delete event;
 }
 
-void ResetThreadSafeFunction() {
-  EventTsfn* previous = g_tsfnPointer.exchange(nullptr, std::memory_order_acq_rel);
-  if (previous) {
-    previous->Abort();
+void CallJsStreamWake(Napi::Env env, Napi::Function callback, void* /*context*/, void* /*data*/) {
+  if (env == nullptr) {
+    return;
+  }
+  Napi::HandleScope scope(env);
+  callback.Call({});
+}
+
+void CallJsHotkey(Napi::Env env,
+                  Napi::Function callback,
+                  void* /*context*/,
+                  inputhook::HotkeyMatch* match) {
+  if (!match) {
+    return;
+  }
+  if (env == nullptr) {
+    delete match;
+    return;
   }
-  g_tsfnHolder.reset();
+
+  Napi::HandleScope scope(env);
+  Napi::Object output = Napi::Object::New(env);
+  output.Set("id", match->id);
+  output.Set("time", match->time);
+  callback.Call({output});
+  delete match;
+}
+
+Napi::Object MouseStatsToJs(Napi::Env env, const inputhook::MouseStatsSnapshot& snapshot) {
+  Napi::Uint32Array speedHistogram =
+      Napi::Uint32Array::New(env, snapshot.speedHistogram.size());
+  std::copy(snapshot.speedHistogram.begin(), snapshot.speedHistogram.end(),
+            speedHistogram.Data());
+  Napi::Uint32Array accelHistogram =
+      Napi::Uint32Array::New(env, snapshot.accelHistogram.size());
+  std::copy(snapshot.accelHistogram.begin(), snapshot.accelHistogram.end(),
+            accelHistogram.Data());
+
+  Napi::Object speed = Napi::Object::New(env);
+  speed.Set("mean", snapshot.meanSpeed);
+  speed.Set("max", snapshot.maxSpeed);
+  speed.Set("bucketSize", snapshot.speedBucket);
+  speed.Set("histogram", speedHistogram);
+
+  Napi::Object acceleration = Napi::Object::New(env);
+  acceleration.Set("mean", snapshot.meanAccel);
+  acceleration.Set("max", snapshot.maxAccel);
+  acceleration.Set("bucketSize", snapshot.accelBucket);
+  acceleration.Set("histogram", accelHistogram);
+
+  Napi::Object episodes = Napi::Object::New(env);
+  episodes.Set("count", snapshot.episodes);
+  episodes.Set("moveTime", snapshot.moveTimeMs);
+  episodes.Set("longest", snapshot.longestEpisodeMs);
+
+  Napi::Object output = Napi::Object::New(env);
+  output.Set("start", snapshot.start);
+  output.Set("end", snapshot.end);
+  output.Set("distance", snapshot.distance);
+  output.Set("speed", speed);
+  output.Set("acceleration", acceleration);
+  output.Set("episodes", episodes);
+  return output;
+}
+
+void CallJsMouseStats(Napi::Env env,
+                      Napi::Function callback,
+                      void* /*context*/,
+                      inputhook::MouseStatsSnapshot* snapshot) {
+  if (!snapshot) {
+    return;
+  }
+  if (env == nullptr) {
+    delete snapshot;
+    return;
+  }
+
+  Napi::HandleScope scope(env);
+  callback.Call({MouseStatsToJs(env, *snapshot)});
+  delete snapshot;
+}
+
+void ResetThreadSafeFunction() {
+  g_tsfn.Retire();
 }
 
 void RegisterEventCallback(Napi::Env env, Napi::Function callback) {
@@ -65,35 +422,270 @@ void RegisterEventCallback(Napi::Env env, Napi::Function callback) {
                                   0,
                                   1,
                                   nullptr);
-  g_tsfnHolder = std::make_unique<EventTsfn>(std::move(tsfn));
-  g_tsfnPointer.store(g_tsfnHolder.get(), std::memory_order_release);
+  g_tsfn.Publish(std::move(tsfn));
 }
 
+void ResetHotkeyThreadSafeFunction() {
+  g_hotkeyTsfn.Retire();
+}
+
+void ResetMouseStatsThreadSafeFunction() {
+  g_mouseStatsTsfn.Retire();
+}
+
+void ResetStreamThreadSafeFunction() {
+  g_stream.Close();
+  g_streamTsfn.Retire();
+}
+
+bool ParseHotkeyChord(const Napi::Value& value,
+                      inputhook::HotkeyChord* chord,
+                      std::string* error) {
+  if (!value.IsObject()) {
+    *error = "hotkey chords must be objects";
+    return false;
+  }
+  Napi::Object object = value.As<Napi::Object>();
+  Napi::Value usages = object.Get("usages");
+  if (!usages.IsArray()) {
+    *error = "hotkey chord usages must be an array";
+    return false;
+  }
+  Napi::Array usageArray = usages.As<Napi::Array>();
+  for (uint32_t i = 0; i < usageArray.Length(); ++i) {
+    Napi::Value usage = usageArray.Get(i);
+    if (!usage.IsNumber()) {
+      *error = "hotkey chord usages must be numbers";
+      return false;
+    }
+    chord->usages.push_back(usage.As<Napi::Number>().Uint32Value());
+  }
+  chord->modifiers.shift = object.Get("shift").ToBoolean();
+  chord->modifiers.ctrl = object.Get("ctrl").ToBoolean();
+  chord->modifiers.alt = object.Get("alt").ToBoolean();
+  chord->modifiers.meta = object.Get("meta").ToBoolean();
+  return true;
+}
+
+bool ParseHotkeyDefinitions(const Napi::Array& array,
+                            std::vector<inputhook::HotkeyDefinition>* definitions,
+                            std::string* error) {
+  for (uint32_t i = 0; i < array.Length(); ++i) {
+    Napi::Value entry = array.Get(i);
+    if (!entry.IsObject()) {
+      *error = "hotkey definitions must be objects";
+      return false;
+    }
+    Napi::Object object = entry.As<Napi::Object>();
+    Napi::Value id = object.Get("id");
+    Napi::Value sequence = object.Get("sequence");
+    if (!id.IsString() || !sequence.IsArray()) {
+      *error = "hotkey definitions need a string id and a sequence array";
+      return false;
+    }
+
+    inputhook::HotkeyDefinition definition;
+    definition.id = id.As<Napi::String>().Utf8Value();
+    Napi::Value timeout = object.Get("timeout");
+    if (timeout.IsNumber()) {
+      definition.sequenceTimeoutMs = timeout.As<Napi::Number>().DoubleValue();
+    }
+
+    Napi::Array steps = sequence.As<Napi::Array>();
+    for (uint32_t step = 0; step < steps.Length(); ++step) {
+      inputhook::HotkeyChord chord;
+      if (!ParseHotkeyChord(steps.Get(step), &chord, error)) {
+        return false;
+      }
+      definition.sequence.push_back(std::move(chord));
+    }
+    definitions->push_back(std::move(definition));
+  }
+  return true;
+}
+
+// True when `env` may drive the hook: it owns it, or nobody does. Otherwise
+// throws.
+bool ClaimHook(Napi::Env env) {
+  std::lock_guard<std::mutex> lock(g_hookEnvMutex);
+  if (g_hookEnv && g_hookEnv != static_cast<napi_env>(env)) {
+    Napi::Error::New(env, "the hook is owned by another thread").ThrowAsJavaScriptException();
+    return false;
+  }
+  g_hookEnv = env;
+  return true;
+}
+
+// Checks that a start may begin and prepares the emitter. Returns false with
+// a JS exception pending when the caller should bail out.
+bool PrepareStart(const Napi::CallbackInfo& info) {
+  Napi::Env env = info.Env();
+  if (g_transitioning) {
+    Napi::Error::New(env, "a start or stop is already in progress")
+        .ThrowAsJavaScriptException();
+    return false;
+  }
+  if (!HasConsumers()) {
+    Napi::TypeError::New(env,
+                         "onEvent callback, hotkeys or an aggregator must be set up before starting")
+        .ThrowAsJavaScriptException();
+    return false;
+  }
+
+  inputhook::EmitterOptions emitterOptions;
+  if (info.Length() > 0 && info[0].IsObject()) {
+    Napi::Object options = info[0].As<Napi::Object>();
+    Napi::Value backendValue = options.Get("backend");
+    if (backendValue.IsString()) {
+      emitterOptions.backend = backendValue.As<Napi::String>().Utf8Value();
+    } else if (!backendValue.IsUndefined()) {
+      Napi::TypeError::New(env, "backend must be a string").ThrowAsJavaScriptException();
+      return false;
+    }
+    Napi::Value devicesValue = options.Get("devices");
+    if (devicesValue.IsArray()) {
+      Napi::Array devices = devicesValue.As<Napi::Array>();
+      for (uint32_t i = 0; i < devices.Length(); ++i) {
+        Napi::Value device = devices.Get(i);
+        if (!device.IsString()) {
+          Napi::TypeError::New(env, "devices must be an array of paths")
+              .ThrowAsJavaScriptException();
+          return false;
+        }
+        emitterOptions.devices.push_back(device.As<Napi::String>().Utf8Value());
+      }
+    } else if (!devicesValue.IsUndefined()) {
+      Napi::TypeError::New(env, "devices must be an array of paths").ThrowAsJavaScriptException();
+      return false;
+    }
+  }
+
+  g_failureReason.clear();
+  g_eventCount.store(0, std::memory_order_relaxed);
+  g_droppedCount.store(0, std::memory_order_relaxed);
+  g_pipeline.Reset();
+  g_emitter = std::make_unique<inputhook::InputEmitter>(&g_pipeline, emitterOptions);
+  g_emitter->SetPaused(g_paused);
+  return true;
+}
+
+void FinishStart(bool started) {
+  if (!started) {
+    g_failureReason = g_emitter->GetFailureReason();
+    g_emitter.reset();
+    return;
+  }
+  g_running.store(true, std::memory_order_release);
+  // A pause() or resume() during startAsync() was only recorded.
+  if (g_emitter->IsPaused() != g_paused && !g_emitter->SetPaused(g_paused)) {
+    g_paused = true;
+  }
+}
+
+class StartWorker : public Napi::AsyncWorker {
+ public:
+  StartWorker(Napi::Env env, Napi::Promise::Deferred deferred, inputhook::InputEmitter* emitter)
+      : Napi::AsyncWorker(env), deferred_(deferred), emitter_(emitter) {}
+
+  std::shared_future<void> Executed() { return executed_.get_future().share(); }
+
+ protected:
+  void Execute() override {
+    started_ = emitter_->Start();
+    executed_.set_value();
+  }
+
+  void OnOK() override {
+    Napi::Env env = Env();
+    g_transitioning = false;
+    g_startExecuted = std::shared_future<void>();
+    FinishStart(started_);
+    if (started_) {
+      deferred_.Resolve(env.Undefined());
+      return;
+    }
+    std::string reason = g_failureReason.empty() ? "input hook failed to start" : g_failureReason;
+    deferred_.Reject(Napi::Error::New(env, reason).Value());
+  }
+
+ private:
+  Napi::Promise::Deferred deferred_;
+  inputhook::InputEmitter* emitter_;
+  std::promise<void> executed_;
+  bool started_ = false;
+};
+
+class StopWorker : public Napi::AsyncWorker {
+ public:
+  StopWorker(Napi::Env env,
+             Napi::Promise::Deferred deferred,
+             std::unique_ptr<inputhook::InputEmitter> emitter)
+      : Napi::AsyncWorker(env), deferred_(deferred), emitter_(std::move(emitter)) {}
+
+ protected:
+  void Execute() override {
+    emitter_->Stop();
+    emitter_.reset();
+  }
+
+  void OnOK() override {
+    g_transitioning = false;
+    ResetKeyState();
+    deferred_.Resolve(Env().Undefined());
+  }
+
+ private:
+  Napi::Promise::Deferred deferred_;
+  std::unique_ptr<inputhook::InputEmitter> emitter_;
+};
+
 Napi::Value Start(const Napi::CallbackInfo& info) {
   Napi::Env env = info.Env();
+  if (!ClaimHook(env)) {
+    return env.Undefined();
+  }
   if (g_running.load(std::memory_order_acquire)) {
     return Napi::Boolean::New(env, false);
   }
-
-  if (!g_tsfnHolder) {
-    Napi::TypeError::New(env, "onEvent callback must be registered before starting")
-        .ThrowAsJavaScriptException();
+  if (!PrepareStart(info)) {
     return env.Undefined();
   }
 
-  g_emitter = std::make_unique<inputhook::InputEmitter>(EventDispatcher);
   bool started = g_emitter->Start();
-  if (!started) {
-    g_emitter.reset();
-    return Napi::Boolean::New(env, false);
+  FinishStart(started);
+  return Napi::Boolean::New(env, started);
+}
+
+Napi::Value StartAsync(const Napi::CallbackInfo& info) {
+  Napi::Env env = info.Env();
+  auto deferred = Napi::Promise::Deferred::New(env);
+  if (!ClaimHook(env)) {
+    deferred.Reject(env.GetAndClearPendingException().Value());
+    return deferred.Promise();
+  }
+  if (g_running.load(std::memory_order_acquire)) {
+    deferred.Resolve(env.Undefined());
+    return deferred.Promise();
+  }
+  if (!PrepareStart(info)) {
+    deferred.Reject(env.GetAndClearPendingException().Value());
+    return deferred.Promise();
   }
 
-  g_running.store(true, std::memory_order_release);
-  return Napi::Boolean::New(env, true);
+  // The platform start blocks until the hook is live (or has failed), so it
+  // runs on the libuv pool instead of the JS thread.
+  g_transitioning = true;
+  auto* worker = new StartWorker(env, deferred, g_emitter.get());
+  g_startExecuted = worker->Executed();
+  worker->Queue();
+  return deferred.Promise();
 }
 
 Napi::Value Stop(const Napi::CallbackInfo& info) {
   Napi::Env env = info.Env();
+  if (!ClaimHook(env)) {
+    return env.Undefined();
+  }
   if (!g_running.load(std::memory_order_acquire)) {
     return env.Undefined();
   }
@@ -103,11 +695,40 @@ Napi::Value Stop(const Napi::CallbackInfo& info) {
     g_emitter.reset();
   }
   g_running.store(false, std::memory_order_release);
+  ResetKeyState();
   return env.Undefined();
 }
 
+Napi::Value StopAsync(const Napi::CallbackInfo& info) {
+  Napi::Env env = info.Env();
+  auto deferred = Napi::Promise::Deferred::New(env);
+  if (!ClaimHook(env)) {
+    deferred.Reject(env.GetAndClearPendingException().Value());
+    return deferred.Promise();
+  }
+  if (g_transitioning) {
+    deferred.Reject(Napi::Error::New(env, "a start or stop is already in progress").Value());
+    return deferred.Promise();
+  }
+  if (!g_running.load(std::memory_order_acquire) || !g_emitter) {
+    deferred.Resolve(env.Undefined());
+    return deferred.Promise();
+  }
+
+  // Joining the hook thread can take a while; hand the emitter to a worker
+  // so the JS thread is free immediately. Events already queued may still
+  // arrive until the promise settles.
+  g_running.store(false, std::memory_order_release);
+  g_transitioning = true;
+  (new StopWorker(env, deferred, std::move(g_emitter)))->Queue();
+  return deferred.Promise();
+}
+
 Napi::Value OnEvent(const Napi::CallbackInfo& info) {
   Napi::Env env = info.Env();
+  if (!ClaimHook(env)) {
+    return env.Undefined();
+  }
   if (info.Length() < 1 || !info[0].IsFunction()) {
     Napi::TypeError::New(env, "callback function required")
         .ThrowAsJavaScriptException();
@@ -118,10 +739,815 @@ Napi::Value OnEvent(const Napi::CallbackInfo& info) {
   return env.Undefined();
 }
 
+Napi::Value OpenStream(const Napi::CallbackInfo& info) {
+  Napi::Env env = info.Env();
+  if (!ClaimHook(env)) {
+    return env.Undefined();
+  }
+  if (info.Length() < 2 || !info[0].IsObject() || !info[1].IsFunction()) {
+    Napi::TypeError::New(env, "stream options object and wakeup callback required")
+        .ThrowAsJavaScriptException();
+    return env.Undefined();
+  }
+  if (g_streamTsfn) {
+    Napi::Error::New(env, "a stream is already open").ThrowAsJavaScriptException();
+    return env.Undefined();
+  }
+
+  double capacity = inputhook::EventStream::kDefaultCapacity;
+  Napi::Value capacityValue = info[0].As<Napi::Object>().Get("capacity");
+  if (capacityValue.IsNumber()) {
+    capacity = capacityValue.As<Napi::Number>().DoubleValue();
+    if (!(capacity >= 1 && capacity <= 1048576)) {
+      Napi::RangeError::New(env, "capacity must be between 1 and 1048576")
+          .ThrowAsJavaScriptException();
+      return env.Undefined();
+    }
+  }
+
+  StreamTsfn tsfn = StreamTsfn::New(env,
+                                    info[1].As<Napi::Function>(),
+                                    "inputhook-stream",
+                                    0,
+                                    1,
+                                    nullptr);
+  g_stream.Open(static_cast<std::size_t>(capacity));
+  g_streamTsfn.Publish(std::move(tsfn));
+  return env.Undefined();
+}
+
+// Returns up to `max` queued events, as objects or as one Buffer of
+// kEncodedEventSize records. An empty result arms the wakeup callback.
+Napi::Value ReadStream(const Napi::CallbackInfo& info) {
+  Napi::Env env = info.Env();
+  if (!ClaimHook(env)) {
+    return env.Undefined();
+  }
+  if (info.Length() < 1 || !info[0].IsNumber()) {
+    Napi::TypeError::New(env, "maximum event count required").ThrowAsJavaScriptException();
+    return env.Undefined();
+  }
+  double max = info[0].As<Napi::Number>().DoubleValue();
+  bool binary = info.Length() > 1 && info[1].ToBoolean().Value();
+  if (!(max >= 1)) {
+    Napi::RangeError::New(env, "maximum event count must be positive")
+        .ThrowAsJavaScriptException();
+    return env.Undefined();
+  }
+
+  thread_local std::vector<inputhook::InputEvent> events;
+  events.clear();
+  g_stream.Pop(static_cast<std::size_t>(std::min(max, 65536.0)), &events);
+  if (binary) {
+    auto buffer = Napi::Buffer<uint8_t>::New(env, events.size() * inputhook::kEncodedEventSize);
+    for (std::size_t i = 0; i < events.size(); ++i) {
+      inputhook::EncodeEvent(events[i], buffer.Data() + i * inputhook::kEncodedEventSize);
+    }
+    return buffer;
+  }
+  Napi::Array result = Napi::Array::New(env, events.size());
+  for (uint32_t i = 0; i < events.size(); ++i) {
+    result.Set(i, inputhook::ToJsObject(env, events[i]));
+  }
+  return result;
+}
+
+Napi::Value CloseStream(const Napi::CallbackInfo& info) {
+  if (!ClaimHook(info.Env())) {
+    return info.Env().Undefined();
+  }
+  ResetStreamThreadSafeFunction();
+  return info.Env().Undefined();
+}
+
+Napi::Value RegisterHotkeys(const Napi::CallbackInfo& info) {
+  Napi::Env env = info.Env();
+  if (!ClaimHook(env)) {
+    return env.Undefined();
+  }
+  if (info.Length() < 2 || !info[0].IsArray() || !info[1].IsFunction()) {
+    Napi::TypeError::New(env, "hotkey array and callback function required")
+        .ThrowAsJavaScriptException();
+    return env.Undefined();
+  }
+
+  std::vector<inputhook::HotkeyDefinition> definitions;
+  std::string error;
+  if (!ParseHotkeyDefinitions(info[0].As<Napi::Array>(), &definitions, &error) ||
+      !g_hotkeys.SetHotkeys(definitions, &error)) {
+    Napi::TypeError::New(env, error).ThrowAsJavaScriptException();
+    return env.Undefined();
+  }
+
+  ResetHotkeyThreadSafeFunction();
+  HotkeyTsfn tsfn = HotkeyTsfn::New(env,
+                                    info[1].As<Napi::Function>(),
+                                    "inputhook-hotkeys",
+                                    0,
+                                    1,
+                                    nullptr);
+  g_hotkeyTsfn.Publish(std::move(tsfn));
+  return env.Undefined();
+}
+
+Napi::Value UnregisterHotkeys(const Napi::CallbackInfo& info) {
+  if (!ClaimHook(info.Env())) {
+    return info.Env().Undefined();
+  }
+  ResetHotkeyThreadSafeFunction();
+  g_hotkeys.Clear();
+  return info.Env().Undefined();
+}
+
+Napi::Value ConfigureGestures(const Napi::CallbackInfo& info) {
+  Napi::Env env = info.Env();
+  if (!ClaimHook(env)) {
+    return env.Undefined();
+  }
+  if (info.Length() < 1 || !info[0].IsObject()) {
+    Napi::TypeError::New(env, "gesture options object required")
+        .ThrowAsJavaScriptException();
+    return env.Undefined();
+  }
+
+  Napi::Object object = info[0].As<Napi::Object>();
+  inputhook::GestureOptions options = g_gestures.Options();
+  Napi::Value enabled = object.Get("enabled");
+  options.enabled = enabled.IsUndefined() ? true : enabled.ToBoolean().Value();
+  Napi::Value interval = object.Get("multiClickInterval");
+  if (interval.IsNumber()) {
+    options.multiClickIntervalMs = interval.As<Napi::Number>().DoubleValue();
+  }
+  Napi::Value distance = object.Get("multiClickDistance");
+  if (distance.IsNumber()) {
+    options.multiClickDistance = distance.As<Napi::Number>().DoubleValue();
+  }
+  Napi::Value threshold = object.Get("dragThreshold");
+  if (threshold.IsNumber()) {
+    options.dragThreshold = threshold.As<Napi::Number>().DoubleValue();
+  }
+  g_gestures.Configure(options);
+  return env.Undefined();
+}
+
+Napi::Value ConfigureHeatmap(const Napi::CallbackInfo& info) {
+  Napi::Env env = info.Env();
+  if (!ClaimHook(env)) {
+    return env.Undefined();
+  }
+  if (info.Length() < 1 || !info[0].IsObject()) {
+    Napi::TypeError::New(env, "heatmap options object required")
+        .ThrowAsJavaScriptException();
+    return env.Undefined();
+  }
+
+  Napi::Object object = info[0].As<Napi::Object>();
+  inputhook::HeatmapOptions options = g_heatmap.Options();
+  Napi::Value enabled = object.Get("enabled");
+  options.enabled = enabled.IsUndefined() ? true : enabled.ToBoolean().Value();
+  auto readDimension = [&](const char* name, uint32_t* target) {
+    Napi::Value value = object.Get(name);
+    if (!value.IsNumber()) {
+      return true;
+    }
+    double number = value.As<Napi::Number>().DoubleValue();
+    if (!(number >= 1 && number <= 65535)) {
+      Napi::RangeError::New(env, std::string(name) + " must be between 1 and 65535")
+          .ThrowAsJavaScriptException();
+      return false;
+    }
+    *target = static_cast<uint32_t>(number);
+    return true;
+  };
+  if (!readDimension("columns", &options.columns) || !readDimension("rows", &options.rows) ||
+      !readDimension("width", &options.width) || !readDimension("height", &options.height)) {
+    return env.Undefined();
+  }
+  if (static_cast<uint64_t>(options.columns) * options.rows > (1u << 20)) {
+    Napi::RangeError::New(env, "heatmap grid may not exceed 1048576 cells")
+        .ThrowAsJavaScriptException();
+    return env.Undefined();
+  }
+  Napi::Value maxDwell = object.Get("maxDwell");
+  if (maxDwell.IsNumber()) {
+    options.maxDwellMs = maxDwell.As<Napi::Number>().DoubleValue();
+  }
+  g_heatmap.Configure(options);
+  return env.Undefined();
+}
+
+Napi::Value GetHeatmap(const Napi::CallbackInfo& info) {
+  Napi::Env env = info.Env();
+  bool reset = info.Length() > 0 && info[0].IsObject() &&
+               info[0].As<Napi::Object>().Get("reset").ToBoolean().Value();
+  inputhook::HeatmapSnapshot snapshot = g_heatmap.Snapshot(reset);
+
+  Napi::Float64Array dwell = Napi::Float64Array::New(env, snapshot.dwell.size());
+  std::copy(snapshot.dwell.begin(), snapshot.dwell.end(), dwell.Data());
+  Napi::Uint32Array clicks = Napi::Uint32Array::New(env, snapshot.clicks.size());
+  std::copy(snapshot.clicks.begin(), snapshot.clicks.end(), clicks.Data());
+
+  Napi::Object result = Napi::Object::New(env);
+  result.Set("columns", Napi::Number::New(env, snapshot.columns));
+  result.Set("rows", Napi::Number::New(env, snapshot.rows));
+  result.Set("duration", Napi::Number::New(env, snapshot.durationMs));
+  result.Set("dwell", dwell);
+  result.Set("clicks", clicks);
+  return result;
+}
+
+Napi::Value ResetHeatmap(const Napi::CallbackInfo& info) {
+  if (!ClaimHook(info.Env())) {
+    return info.Env().Undefined();
+  }
+  g_heatmap.Clear();
+  return info.Env().Undefined();
+}
+
+Napi::Value ConfigureTypingStats(const Napi::CallbackInfo& info) {
+  Napi::Env env = info.Env();
+  if (!ClaimHook(env)) {
+    return env.Undefined();
+  }
+  if (info.Length() < 1 || !info[0].IsObject()) {
+    Napi::TypeError::New(env, "typing stats options object required")
+        .ThrowAsJavaScriptException();
+    return env.Undefined();
+  }
+
+  Napi::Object object = info[0].As<Napi::Object>();
+  inputhook::TypingStatsOptions options = g_typing.Options();
+  Napi::Value enabled = object.Get("enabled");
+  options.enabled = enabled.IsUndefined() ? true : enabled.ToBoolean().Value();
+  Napi::Value window = object.Get("window");
+  if (window.IsNumber()) {
+    options.windowMs = window.As<Napi::Number>().DoubleValue();
+  }
+  Napi::Value pauseThreshold = object.Get("pauseThreshold");
+  if (pauseThreshold.IsNumber()) {
+    options.pauseThresholdMs = pauseThreshold.As<Napi::Number>().DoubleValue();
+  }
+  Napi::Value bucketSize = object.Get("bucketSize");
+  if (bucketSize.IsNumber()) {
+    options.bucketMs = bucketSize.As<Napi::Number>().DoubleValue();
+  }
+  Napi::Value buckets = object.Get("buckets");
+  if (buckets.IsNumber()) {
+    double count = buckets.As<Napi::Number>().DoubleValue();
+    if (!(count >= 1 && count <= 1024)) {
+      Napi::RangeError::New(env, "buckets must be between 1 and 1024")
+          .ThrowAsJavaScriptException();
+      return env.Undefined();
+    }
+    options.bucketCount = static_cast<uint32_t>(count);
+  }
+  if (!(options.windowMs > 0.0) || !(options.bucketMs > 0.0)) {
+    Napi::RangeError::New(env, "window and bucketSize must be positive")
+        .ThrowAsJavaScriptException();
+    return env.Undefined();
+  }
+  g_typing.Configure(options);
+  return env.Undefined();
+}
+
+Napi::Value GetTypingStats(const Napi::CallbackInfo& info) {
+  Napi::Env env = info.Env();
+  inputhook::TypingStatsSnapshot snapshot = g_typing.Snapshot(NowMs());
+  double backspaceRatio =
+      snapshot.keys ? static_cast<double>(snapshot.backspaces) / snapshot.keys : 0.0;
+
+  Napi::Uint32Array histogram = Napi::Uint32Array::New(env, snapshot.histogram.size());
+  std::copy(snapshot.histogram.begin(), snapshot.histogram.end(), histogram.Data());
+
+  Napi::Object intervals = Napi::Object::New(env);
+  intervals.Set("mean", Napi::Number::New(env, snapshot.meanIntervalMs));
+  intervals.Set("bucketSize", Napi::Number::New(env, snapshot.bucketMs));
+  intervals.Set("histogram", histogram);
+
+  Napi::Object bursts = Napi::Object::New(env);
+  bursts.Set("count", Napi::Number::New(env, snapshot.bursts));
+  bursts.Set("meanKeys", Napi::Number::New(env, snapshot.meanBurstKeys));
+  bursts.Set("meanDuration", Napi::Number::New(env, snapshot.meanBurstMs));
+  bursts.Set("currentKeys", Napi::Number::New(env, snapshot.currentBurstKeys));
+
+  Napi::Object pauses = Napi::Object::New(env);
+  pauses.Set("count", Napi::Number::New(env, snapshot.pauses));
+  pauses.Set("total", Napi::Number::New(env, snapshot.pauseMs));
+
+  Napi::Object result = Napi::Object::New(env);
+  result.Set("window", Napi::Number::New(env, snapshot.windowMs));
+  result.Set("keys", Napi::Number::New(env, snapshot.keys));
+  result.Set("keysPerMinute", Napi::Number::New(env, snapshot.keysPerMinute));
+  result.Set("backspaces", Napi::Number::New(env, snapshot.backspaces));
+  result.Set("backspaceRatio", Napi::Number::New(env, backspaceRatio));
+  result.Set("intervals", intervals);
+  result.Set("bursts", bursts);
+  result.Set("pauses", pauses);
+  return result;
+}
+
+Napi::Value ConfigureMouseStats(const Napi::CallbackInfo& info) {
+  Napi::Env env = info.Env();
+  if (!ClaimHook(env)) {
+    return env.Undefined();
+  }
+  if (info.Length() < 1 || !info[0].IsObject() ||
+      (info.Length() > 1 && !info[1].IsFunction() && !info[1].IsUndefined())) {
+    Napi::TypeError::New(env, "mouse stats options object and optional callback required")
+        .ThrowAsJavaScriptException();
+    return env.Undefined();
+  }
+
+  Napi::Object object = info[0].As<Napi::Object>();
+  inputhook::MouseStatsOptions options = g_mouseStats.Options();
+  Napi::Value enabled = object.Get("enabled");
+  options.enabled = enabled.IsUndefined() ? true : enabled.ToBoolean().Value();
+  auto readNumber = [&](const char* name, double* target) {
+    Napi::Value value = object.Get(name);
+    if (value.IsNumber()) {
+      *target = value.As<Napi::Number>().DoubleValue();
+    }
+  };
+  readNumber("interval", &options.intervalMs);
+  readNumber("episodeGap", &options.episodeGapMs);
+  readNumber("sampleInterval", &options.sampleMs);
+  readNumber("speedBucketSize", &options.speedBucket);
+  readNumber("accelerationBucketSize", &options.accelBucket);
+  double buckets = options.bucketCount;
+  readNumber("buckets", &buckets);
+  if (!(buckets >= 1 && buckets <= 1024)) {
+    Napi::RangeError::New(env, "buckets must be between 1 and 1024")
+        .ThrowAsJavaScriptException();
+    return env.Undefined();
+  }
+  options.bucketCount = static_cast<uint32_t>(buckets);
+  if (!(options.sampleMs > 0.0) || !(options.speedBucket > 0.0) ||
+      !(options.accelBucket > 0.0) || options.intervalMs < 0.0) {
+    Napi::RangeError::New(env, "mouse stats intervals and bucket sizes must be positive")
+        .ThrowAsJavaScriptException();
+    return env.Undefined();
+  }
+
+  ResetMouseStatsThreadSafeFunction();
+  g_mouseStats.Configure(options);
+  if (options.enabled && info.Length() > 1 && info[1].IsFunction()) {
+    MouseStatsTsfn tsfn = MouseStatsTsfn::New(env,
+                                              info[1].As<Napi::Function>(),
+                                              "inputhook-mousestats",
+                                              0,
+                                              1,
+                                              nullptr);
+    g_mouseStatsTsfn.Publish(std::move(tsfn));
+  }
+  return env.Undefined();
+}
+
+Napi::Value GetMouseStats(const Napi::CallbackInfo& info) {
+  Napi::Env env = info.Env();
+  bool reset = info.Length() > 0 && info[0].IsObject() &&
+               info[0].As<Napi::Object>().Get("reset").ToBoolean().Value();
+  return MouseStatsToJs(env, g_mouseStats.Snapshot(NowMs(), reset));
+}
+
+Napi::Value ConfigureTimeline(const Napi::CallbackInfo& info) {
+  Napi::Env env = info.Env();
+  if (!ClaimHook(env)) {
+    return env.Undefined();
+  }
+  if (info.Length() < 1 || !info[0].IsObject()) {
+    Napi::TypeError::New(env, "timeline options object required")
+        .ThrowAsJavaScriptException();
+    return env.Undefined();
+  }
+
+  Napi::Object object = info[0].As<Napi::Object>();
+  inputhook::TimelineOptions options;
+  Napi::Value enabled = object.Get("enabled");
+  options.enabled = enabled.IsUndefined() ? true : enabled.ToBoolean().Value();
+  Napi::Value path = object.Get("path");
+  if (path.IsString()) {
+    options.path = path.As<Napi::String>().Utf8Value();
+  } else if (options.enabled) {
+    Napi::TypeError::New(env, "path must be a string").ThrowAsJavaScriptException();
+    return env.Undefined();
+  }
+  Napi::Value interval = object.Get("interval");
+  if (interval.IsNumber()) {
+    double ms = interval.As<Napi::Number>().DoubleValue();
+    if (!(ms >= 1000 && ms <= 86400000) || ms != static_cast<uint32_t>(ms)) {
+      Napi::RangeError::New(env, "interval must be a whole number of ms between 1000 and 86400000")
+          .ThrowAsJavaScriptException();
+      return env.Undefined();
+    }
+    options.intervalMs = static_cast<uint32_t>(ms);
+  }
+
+  std::string error;
+  if (!g_timeline.Configure(options, &error)) {
+    Napi::Error::New(env, error).ThrowAsJavaScriptException();
+  }
+  return env.Undefined();
+}
+
+Napi::Value GetTimeline(const Napi::CallbackInfo& info) {
+  Napi::Env env = info.Env();
+  if (info.Length() < 1 || !info[0].IsObject()) {
+    Napi::TypeError::New(env, "timeline query object required").ThrowAsJavaScriptException();
+    return env.Undefined();
+  }
+
+  Napi::Object object = info[0].As<Napi::Object>();
+  Napi::Value from = object.Get("from");
+  Napi::Value to = object.Get("to");
+  if (!from.IsNumber() || !to.IsNumber()) {
+    Napi::TypeError::New(env, "from and to must be timestamps in ms")
+        .ThrowAsJavaScriptException();
+    return env.Undefined();
+  }
+  double resolutionMs = g_timeline.Options().intervalMs;
+  Napi::Value resolution = object.Get("resolution");
+  if (resolution.IsString()) {
+    std::string name = resolution.As<Napi::String>().Utf8Value();
+    if (name == "minute") {
+      resolutionMs = 60000.0;
+    } else if (name == "hour") {
+      resolutionMs = 3600000.0;
+    } else if (name == "day") {
+      resolutionMs = 86400000.0;
+    } else {
+      Napi::TypeError::New(env, "resolution must be 'minute', 'hour', 'day' or ms")
+          .ThrowAsJavaScriptException();
+      return env.Undefined();
+    }
+  } else if (resolution.IsNumber()) {
+    resolutionMs = resolution.As<Napi::Number>().DoubleValue();
+  }
+  double offsetMs = 0.0;
+  Napi::Value utcOffset = object.Get("utcOffset");
+  if (utcOffset.IsNumber()) {
+    offsetMs = utcOffset.As<Napi::Number>().DoubleValue();
+  } else if (!utcOffset.IsUndefined()) {
+    Napi::TypeError::New(env, "utcOffset must be a number of ms").ThrowAsJavaScriptException();
+    return env.Undefined();
+  }
+
+  inputhook::TimelineRange range;
+  std::string error;
+  if (!g_timeline.Query(from.As<Napi::Number>().DoubleValue(), to.As<Napi::Number>().DoubleValue(),
+                        resolutionMs, offsetMs, &range, &error)) {
+    Napi::Error::New(env, error).ThrowAsJavaScriptException();
+    return env.Undefined();
+  }
+
+  auto toArray = [&](const std::vector<uint32_t>& column) {
+    Napi::Uint32Array array = Napi::Uint32Array::New(env, column.size());
+    std::copy(column.begin(), column.end(), array.Data());
+    return array;
+  };
+  Napi::Object result = Napi::Object::New(env);
+  result.Set("start", Napi::Number::New(env, range.startMs));
+  result.Set("resolution", Napi::Number::New(env, range.resolutionMs));
+  result.Set("keys", toArray(range.keys));
+  result.Set("clicks", toArray(range.clicks));
+  result.Set("moves", toArray(range.moves));
+  result.Set("wheel", toArray(range.wheel));
+  result.Set("active", toArray(range.active));
+  return result;
+}
+
+Napi::Value ConfigureAppUsage(const Napi::CallbackInfo& info) {
+  Napi::Env env = info.Env();
+  if (!ClaimHook(env)) {
+    return env.Undefined();
+  }
+  if (info.Length() < 1 || !info[0].IsObject()) {
+    Napi::TypeError::New(env, "app usage options object required")
+        .ThrowAsJavaScriptException();
+    return env.Undefined();
+  }
+
+  Napi::Object object = info[0].As<Napi::Object>();
+  inputhook::AppUsageOptions options = g_appUsage.Options();
+  Napi::Value enabled = object.Get("enabled");
+  options.enabled = enabled.IsUndefined() ? true : enabled.ToBoolean().Value();
+  Napi::Value idleThreshold = object.Get("idleThreshold");
+  if (idleThreshold.IsNumber()) {
+    options.idleThresholdMs = idleThreshold.As<Napi::Number>().DoubleValue();
+    if (!(options.idleThresholdMs > 0.0)) {
+      Napi::RangeError::New(env, "idleThreshold must be positive").ThrowAsJavaScriptException();
+      return env.Undefined();
+    }
+  }
+  // A hook that is still starting reports the initial focus on its own.
+  if (g_appUsage.Configure(options) && g_emitter && !g_transitioning) {
+    g_emitter->RequestFocus();
+  }
+  return env.Undefined();
+}
+
+Napi::Object UsageTotalsToJs(Napi::Env env, const inputhook::UsageTotals& totals) {
+  Napi::Object result = Napi::Object::New(env);
+  result.Set("activeTime", Napi::Number::New(env, totals.activeMs));
+  result.Set("keys", Napi::Number::New(env, totals.keys));
+  result.Set("clicks", Napi::Number::New(env, totals.clicks));
+  result.Set("scrolls", Napi::Number::New(env, totals.scrolls));
+  result.Set("moves", Napi::Number::New(env, totals.moves));
+  return result;
+}
+
+Napi::Value GetAppUsage(const Napi::CallbackInfo& info) {
+  Napi::Env env = info.Env();
+  bool reset = info.Length() > 0 && info[0].IsObject() &&
+               info[0].As<Napi::Object>().Get("reset").ToBoolean().Value();
+  inputhook::AppUsageSnapshot snapshot = g_appUsage.Snapshot(NowMs(), reset);
+
+  Napi::Array apps = Napi::Array::New(env, snapshot.apps.size());
+  for (uint32_t i = 0; i < snapshot.apps.size(); ++i) {
+    const inputhook::AppUsage& usage = snapshot.apps[i];
+    Napi::Array windows = Napi::Array::New(env, usage.windows.size());
+    for (uint32_t j = 0; j < usage.windows.size(); ++j) {
+      Napi::Object window = UsageTotalsToJs(env, usage.windows[j].totals);
+      window.Set("window", Napi::Number::New(env, static_cast<double>(usage.windows[j].window)));
+      windows.Set(j, window);
+    }
+    Napi::Object app = UsageTotalsToJs(env, usage.totals);
+    app.Set("app", usage.app);
+    app.Set("pid", Napi::Number::New(env, usage.pid));
+    app.Set("focusCount", Napi::Number::New(env, usage.focusCount));
+    app.Set("windows", windows);
+    apps.Set(i, app);
+  }
+
+  Napi::Object result = Napi::Object::New(env);
+  result.Set("since", Napi::Number::New(env, snapshot.sinceMs));
+  if (snapshot.currentWindow || !snapshot.currentApp.empty()) {
+    Napi::Object current = Napi::Object::New(env);
+    current.Set("app", snapshot.currentApp);
+    current.Set("window", Napi::Number::New(env, static_cast<double>(snapshot.currentWindow)));
+    result.Set("current", current);
+  } else {
+    result.Set("current", env.Null());
+  }
+  result.Set("apps", apps);
+  return result;
+}
+
+Napi::Value ConfigureOutput(const Napi::CallbackInfo& info) {
+  Napi::Env env = info.Env();
+  if (!ClaimHook(env)) {
+    return env.Undefined();
+  }
+  if (info.Length() < 1 || !info[0].IsObject()) {
+    Napi::TypeError::New(env, "output options object required").ThrowAsJavaScriptException();
+    return env.Undefined();
+  }
+
+  Napi::Object object = info[0].As<Napi::Object>();
+  Napi::Value enabled = object.Get("enabled");
+  if (!enabled.IsUndefined() && !enabled.ToBoolean().Value()) {
+    g_output.Close();
+    return env.Undefined();
+  }
+  double capacity = inputhook::EventStream::kDefaultCapacity;
+  Napi::Value capacityValue = object.Get("capacity");
+  if (capacityValue.IsNumber()) {
+    capacity = capacityValue.As<Napi::Number>().DoubleValue();
+    if (!(capacity >= 1 && capacity <= 1048576)) {
+      Napi::RangeError::New(env, "capacity must be between 1 and 1048576")
+          .ThrowAsJavaScriptException();
+      return env.Undefined();
+    }
+  }
+
+  Napi::Value path = object.Get("path");
+  Napi::Value fd = object.Get("fd");
+  std::string error;
+  bool opened = false;
+  if (path.IsString()) {
+    opened = g_output.OpenPath(path.As<Napi::String>().Utf8Value(),
+                               static_cast<std::size_t>(capacity), &error);
+  } else if (fd.IsNumber()) {
+    opened = g_output.OpenFd(fd.As<Napi::Number>().Int32Value(),
+                             static_cast<std::size_t>(capacity), &error);
+  } else {
+    Napi::TypeError::New(env, "output needs a socket path or an fd").ThrowAsJavaScriptException();
+    return env.Undefined();
+  }
+  if (!opened) {
+    Napi::Error::New(env, error).ThrowAsJavaScriptException();
+  }
+  return env.Undefined();
+}
+
+// References stay valid after the lock is released: other environments only
+// add their own entries, and an entry is erased by its own cleanup.
+EnvBroadcast& BroadcastFor(napi_env env) {
+  std::lock_guard<std::mutex> lock(g_envBroadcastMutex);
+  return g_envBroadcasts[env];
+}
+
+// True when `env` may configure the publisher: it owns it, or nobody does.
+bool ClaimBroadcast(napi_env env) {
+  std::lock_guard<std::mutex> lock(g_envBroadcastMutex);
+  if (g_broadcastEnv && g_broadcastEnv != env) {
+    return false;
+  }
+  g_broadcastEnv = env;
+  return true;
+}
+
+void ReleaseBroadcast(napi_env env) {
+  std::lock_guard<std::mutex> lock(g_envBroadcastMutex);
+  if (g_broadcastEnv == env) {
+    g_broadcast.Close();
+    g_broadcastEnv = nullptr;
+  }
+}
+
+Napi::Value ConfigureBroadcast(const Napi::CallbackInfo& info) {
+  Napi::Env env = info.Env();
+  if (info.Length() < 1 || !info[0].IsObject()) {
+    Napi::TypeError::New(env, "broadcast options object required").ThrowAsJavaScriptException();
+    return env.Undefined();
+  }
+
+  Napi::Object object = info[0].As<Napi::Object>();
+  Napi::Value enabled = object.Get("enabled");
+  if (!enabled.IsUndefined() && !enabled.ToBoolean().Value()) {
+    ReleaseBroadcast(env);
+    return env.Undefined();
+  }
+  Napi::Value name = object.Get("name");
+  if (!name.IsString()) {
+    Napi::TypeError::New(env, "broadcast name required").ThrowAsJavaScriptException();
+    return env.Undefined();
+  }
+  double capacity = inputhook::EventStream::kDefaultCapacity;
+  Napi::Value capacityValue = object.Get("capacity");
+  if (capacityValue.IsNumber()) {
+    capacity = capacityValue.As<Napi::Number>().DoubleValue();
+    if (!(capacity >= 1 && capacity <= 1048576)) {
+      Napi::RangeError::New(env, "capacity must be between 1 and 1048576")
+          .ThrowAsJavaScriptException();
+      return env.Undefined();
+    }
+  }
+
+  if (!ClaimBroadcast(env)) {
+    Napi::Error::New(env, "the broadcast is configured by another thread")
+        .ThrowAsJavaScriptException();
+    return env.Undefined();
+  }
+  std::string error;
+  if (!g_broadcast.Open(name.As<Napi::String>().Utf8Value(), static_cast<uint32_t>(capacity),
+                        &error)) {
+    ReleaseBroadcast(env);
+    Napi::Error::New(env, error).ThrowAsJavaScriptException();
+  }
+  return env.Undefined();
+}
+
+inputhook::BroadcastSubscriber* FindSubscription(const Napi::CallbackInfo& info) {
+  Napi::Env env = info.Env();
+  if (info.Length() < 1 || !info[0].IsNumber()) {
+    Napi::TypeError::New(env, "subscription id required").ThrowAsJavaScriptException();
+    return nullptr;
+  }
+  EnvBroadcast& broadcast = BroadcastFor(env);
+  auto it = broadcast.subscriptions.find(info[0].As<Napi::Number>().Uint32Value());
+  if (it == broadcast.subscriptions.end()) {
+    Napi::Error::New(env, "subscription is closed").ThrowAsJavaScriptException();
+    return nullptr;
+  }
+  return it->second.get();
+}
+
+// Attaches to a broadcast published by this or another process. Needs no
+// hook of its own, so it works without start().
+Napi::Value OpenSubscription(const Napi::CallbackInfo& info) {
+  Napi::Env env = info.Env();
+  if (info.Length() < 1 || !info[0].IsString()) {
+    Napi::TypeError::New(env, "broadcast name required").ThrowAsJavaScriptException();
+    return env.Undefined();
+  }
+  bool fromStart = info.Length() > 1 && info[1].ToBoolean().Value();
+
+  auto subscriber = std::make_unique<inputhook::BroadcastSubscriber>();
+  std::string error;
+  if (!subscriber->Open(info[0].As<Napi::String>().Utf8Value(), fromStart, &error)) {
+    Napi::Error::New(env, error).ThrowAsJavaScriptException();
+    return env.Undefined();
+  }
+  EnvBroadcast& broadcast = BroadcastFor(env);
+  uint32_t id = broadcast.nextSubscriptionId++;
+  broadcast.subscriptions[id] = std::move(subscriber);
+  return Napi::Number::New(env, id);
+}
+
+// Returns one Buffer of up to `max` kEncodedEventSize records.
+Napi::Value ReadSubscription(const Napi::CallbackInfo& info) {
+  Napi::Env env = info.Env();
+  inputhook::BroadcastSubscriber* subscriber = FindSubscription(info);
+  if (!subscriber) {
+    return env.Undefined();
+  }
+  double max = info.Length() > 1 && info[1].IsNumber() ? info[1].As<Napi::Number>().DoubleValue()
+                                                       : 4096.0;
+  if (!(max >= 1)) {
+    Napi::RangeError::New(env, "maximum event count must be positive")
+        .ThrowAsJavaScriptException();
+    return env.Undefined();
+  }
+
+  thread_local std::vector<uint8_t> records;
+  records.clear();
+  subscriber->Read(static_cast<std::size_t>(std::min(max, 65536.0)), &records);
+  return Napi::Buffer<uint8_t>::Copy(env, records.data(), records.size());
+}
+
+Napi::Value GetSubscriptionStats(const Napi::CallbackInfo& info) {
+  Napi::Env env = info.Env();
+  inputhook::BroadcastSubscriber* subscriber = FindSubscription(info);
+  if (!subscriber) {
+    return env.Undefined();
+  }
+  Napi::Object result = Napi::Object::New(env);
+  result.Set("sequence", static_cast<double>(subscriber->Sequence()));
+  result.Set("lost", static_cast<double>(subscriber->Lost()));
+  result.Set("publisher", static_cast<double>(subscriber->PublisherPid()));
+  result.Set("replaced", Napi::Boolean::New(env, subscriber->Replaced()));
+  return result;
+}
+
+Napi::Value CloseSubscription(const Napi::CallbackInfo& info) {
+  Napi::Env env = info.Env();
+  if (info.Length() > 0 && info[0].IsNumber()) {
+    BroadcastFor(env).subscriptions.erase(info[0].As<Napi::Number>().Uint32Value());
+  }
+  return env.Undefined();
+}
+
+Napi::Value ConfigurePipeline(const Napi::CallbackInfo& info) {
+  Napi::Env env = info.Env();
+  if (!ClaimHook(env)) {
+    return env.Undefined();
+  }
+  if (info.Length() < 1 || !info[0].IsObject()) {
+    Napi::TypeError::New(env, "pipeline options object required")
+        .ThrowAsJavaScriptException();
+    return env.Undefined();
+  }
+
+  Napi::Object object = info[0].As<Napi::Object>();
+  Napi::Value types = object.Get("types");
+  if (types.IsArray()) {
+    Napi::Array typeArray = types.As<Napi::Array>();
+    uint32_t mask = 0;
+    for (uint32_t i = 0; i < typeArray.Length(); ++i) {
+      Napi::Value type = typeArray.Get(i);
+      uint32_t bit = type.IsString()
+                         ? inputhook::TypeBitFor(type.As<Napi::String>().Utf8Value())
+                         : inputhook::kOtherTypeBit;
+      if (bit == inputhook::kOtherTypeBit) {
+        Napi::TypeError::New(env, "types may only contain keydown, keyup, mousedown, "
+                                  "mouseup, mousemove, wheel, focus, lock and unlock")
+            .ThrowAsJavaScriptException();
+        return env.Undefined();
+      }
+      mask |= bit;
+    }
+    g_pipeline.ForEach([mask](auto& pipeline) {
+      pipeline.template Get<inputhook::TypeFilterStage>().SetMask(mask);
+    });
+  } else if (types.IsNull()) {
+    g_pipeline.ForEach([](auto& pipeline) {
+      pipeline.template Get<inputhook::TypeFilterStage>().SetMask(inputhook::kAllTypeBits);
+    });
+  }
+  Napi::Value dedupe = object.Get("dedupe");
+  if (!dedupe.IsUndefined()) {
+    g_dedupe = dedupe.ToBoolean().Value();
+  }
+  Napi::Value coalesce = object.Get("coalesceMotion");
+  if (!coalesce.IsUndefined()) {
+    g_coalesceMotion = coalesce.ToBoolean().Value();
+  }
+  if (g_dedupe && g_coalesceMotion) {
+    g_pipeline.Select<DedupeCoalescePipeline>();
+  } else if (g_dedupe) {
+    g_pipeline.Select<DedupePipeline>();
+  } else if (g_coalesceMotion) {
+    g_pipeline.Select<CoalescePipeline>();
+  } else {
+    g_pipeline.Select<PlainPipeline>();
+  }
+  return env.Undefined();
+}
+
 Napi::Value GetFailureReason(const Napi::CallbackInfo& info) {
   Napi::Env env = info.Env();
-  std::string reason;
-  if (g_emitter) {
+  std::string reason = g_failureReason;
+  if (g_emitter && !g_transitioning) {
     reason = g_emitter->GetFailureReason();
   }
   return Napi::String::New(env, reason);
@@ -136,22 +1562,176 @@ Napi::Value GetLastError(const Napi::CallbackInfo& info) {
   return Napi::String::New(env, error);
 }
 
-void Cleanup() {
+Napi::Value GetStats(const Napi::CallbackInfo& info) {
+  Napi::Env env = info.Env();
+  inputhook::HookStats hookStats;
+  std::string backend;
+  if (g_emitter) {
+    hookStats = g_emitter->GetStats();
+    backend = g_emitter->Backend();
+  }
+
+  Napi::Object stats = Napi::Object::New(env);
+  stats.Set("running", Napi::Boolean::New(env, g_running.load(std::memory_order_acquire)));
+  stats.Set("paused", Napi::Boolean::New(env, g_paused));
+  stats.Set("backend", backend);
+  stats.Set("events", static_cast<double>(g_eventCount.load(std::memory_order_relaxed)));
+  stats.Set("dropped", static_cast<double>(g_droppedCount.load(std::memory_order_relaxed)));
+  stats.Set("reconnects", static_cast<double>(hookStats.reconnects));
+  inputhook::EventStreamStats streamStats = g_stream.Stats();
+  Napi::Object stream = Napi::Object::New(env);
+  stream.Set("queued", static_cast<double>(streamStats.queued));
+  stream.Set("coalesced", static_cast<double>(streamStats.coalesced));
+  stream.Set("dropped", static_cast<double>(streamStats.dropped));
+  stream.Set("depth", static_cast<double>(streamStats.depth));
+  stream.Set("highWater", static_cast<double>(streamStats.highWater));
+  stats.Set("stream", stream);
+  inputhook::FrameWriterStats outputStats = g_output.Stats();
+  Napi::Object output = Napi::Object::New(env);
+  output.Set("open", Napi::Boolean::New(env, g_output.IsOpen()));
+  output.Set("frames", static_cast<double>(outputStats.frames));
+  output.Set("events", static_cast<double>(outputStats.events));
+  output.Set("bytes", static_cast<double>(outputStats.bytes));
+  output.Set("coalesced", static_cast<double>(outputStats.coalesced));
+  output.Set("dropped", static_cast<double>(outputStats.dropped));
+  output.Set("error", outputStats.error);
+  stats.Set("output", output);
+  Napi::Object broadcast = Napi::Object::New(env);
+  broadcast.Set("open", Napi::Boolean::New(env, g_broadcast.IsOpen()));
+  broadcast.Set("sequence", static_cast<double>(g_broadcast.Sequence()));
+  stats.Set("broadcast", broadcast);
+  return stats;
+}
+
+// Pausing keeps the hook thread and its connection, so resume() takes effect
+// at once. While a startAsync() or stopAsync() worker owns the emitter its
+// hook thread is still being set up or torn down; the flag is only recorded
+// then and FinishStart() applies it. Returns false when resuming failed.
+bool SetPaused(bool paused) {
+  g_paused = paused;
+  if (g_emitter && !g_transitioning && !g_emitter->SetPaused(paused)) {
+    g_paused = true;
+  }
+  // Keys released while paused are never seen.
+  ResetKeyState();
+  return g_paused == paused;
+}
+
+Napi::Value Pause(const Napi::CallbackInfo& info) {
+  if (!ClaimHook(info.Env())) {
+    return info.Env().Undefined();
+  }
+  SetPaused(true);
+  return info.Env().Undefined();
+}
+
+Napi::Value Resume(const Napi::CallbackInfo& info) {
+  Napi::Env env = info.Env();
+  if (!ClaimHook(env)) {
+    return env.Undefined();
+  }
+  if (!SetPaused(false)) {
+    std::string reason = g_emitter->GetFailureReason();
+    Napi::Error::New(env, reason.empty() ? "input hook failed to resume" : reason)
+        .ThrowAsJavaScriptException();
+  }
+  return env.Undefined();
+}
+
+Napi::Value ListBackends(const Napi::CallbackInfo& info) {
+  Napi::Env env = info.Env();
+  std::vector<std::string> backends = inputhook::InputEmitter::AvailableBackends();
+  Napi::Array result = Napi::Array::New(env, backends.size());
+  for (uint32_t i = 0; i < backends.size(); ++i) {
+    result.Set(i, backends[i]);
+  }
+  return result;
+}
+
+Napi::Value GetIdleTime(const Napi::CallbackInfo& info) {
+  Napi::Env env = info.Env();
+  double idleMs = 0.0;
+  std::string error;
+  if (!inputhook::QueryIdleTime(&idleMs, &error)) {
+    Napi::Error::New(env, error).ThrowAsJavaScriptException();
+    return env.Undefined();
+  }
+  return Napi::Number::New(env, idleMs);
+}
+
+void Cleanup(napi_env env) {
+  {
+    std::lock_guard<std::mutex> lock(g_hookEnvMutex);
+    if (g_hookEnv != env) {
+      return;
+    }
+  }
+  // A startAsync still blocked in the platform start must finish with the
+  // emitter before it is stopped and freed; its OnOK never runs after this.
+  if (g_startExecuted.valid()) {
+    g_startExecuted.wait();
+    g_startExecuted = std::shared_future<void>();
+  }
   if (g_emitter) {
     g_emitter->Stop();
     g_emitter.reset();
   }
   ResetThreadSafeFunction();
+  ResetHotkeyThreadSafeFunction();
+  ResetMouseStatsThreadSafeFunction();
+  ResetStreamThreadSafeFunction();
   g_running.store(false, std::memory_order_release);
+  g_timeline.Close();
+  g_output.Close();
+  std::lock_guard<std::mutex> lock(g_hookEnvMutex);
+  g_hookEnv = nullptr;
+}
+
+void CleanupBroadcast(napi_env env) {
+  ReleaseBroadcast(env);
+  std::lock_guard<std::mutex> lock(g_envBroadcastMutex);
+  g_envBroadcasts.erase(env);
 }
 
 Napi::Object Init(Napi::Env env, Napi::Object exports) {
   exports.Set("start", Napi::Function::New(env, Start));
   exports.Set("stop", Napi::Function::New(env, Stop));
+  exports.Set("startAsync", Napi::Function::New(env, StartAsync));
+  exports.Set("stopAsync", Napi::Function::New(env, StopAsync));
+  exports.Set("pause", Napi::Function::New(env, Pause));
+  exports.Set("resume", Napi::Function::New(env, Resume));
   exports.Set("onEvent", Napi::Function::New(env, OnEvent));
+  exports.Set("openStream", Napi::Function::New(env, OpenStream));
+  exports.Set("readStream", Napi::Function::New(env, ReadStream));
+  exports.Set("closeStream", Napi::Function::New(env, CloseStream));
+  exports.Set("registerHotkeys", Napi::Function::New(env, RegisterHotkeys));
+  exports.Set("unregisterHotkeys", Napi::Function::New(env, UnregisterHotkeys));
+  exports.Set("configureGestures", Napi::Function::New(env, ConfigureGestures));
+  exports.Set("configureHeatmap", Napi::Function::New(env, ConfigureHeatmap));
+  exports.Set("getHeatmap", Napi::Function::New(env, GetHeatmap));
+  exports.Set("resetHeatmap", Napi::Function::New(env, ResetHeatmap));
+  exports.Set("configureTypingStats", Napi::Function::New(env, ConfigureTypingStats));
+  exports.Set("getTypingStats", Napi::Function::New(env, GetTypingStats));
+  exports.Set("configureMouseStats", Napi::Function::New(env, ConfigureMouseStats));
+  exports.Set("getMouseStats", Napi::Function::New(env, GetMouseStats));
+  exports.Set("configureTimeline", Napi::Function::New(env, ConfigureTimeline));
+  exports.Set("getTimeline", Napi::Function::New(env, GetTimeline));
+  exports.Set("configureAppUsage", Napi::Function::New(env, ConfigureAppUsage));
+  exports.Set("getAppUsage", Napi::Function::New(env, GetAppUsage));
+  exports.Set("configureOutput", Napi::Function::New(env, ConfigureOutput));
+  exports.Set("configureBroadcast", Napi::Function::New(env, ConfigureBroadcast));
+  exports.Set("openSubscription", Napi::Function::New(env, OpenSubscription));
+  exports.Set("readSubscription", Napi::Function::New(env, ReadSubscription));
+  exports.Set("getSubscriptionStats", Napi::Function::New(env, GetSubscriptionStats));
+  exports.Set("closeSubscription", Napi::Function::New(env, CloseSubscription));
+  exports.Set("configurePipeline", Napi::Function::New(env, ConfigurePipeline));
   exports.Set("getFailureReason", Napi::Function::New(env, GetFailureReason));
   exports.Set("getLastError", Napi::Function::New(env, GetLastError));
-  env.AddCleanupHook(Cleanup);
+  exports.Set("getStats", Napi::Function::New(env, GetStats));
+  exports.Set("listBackends", Napi::Function::New(env, ListBackends));
+  exports.Set("getIdleTime", Napi::Function::New(env, GetIdleTime));
+  env.AddCleanupHook(Cleanup, static_cast<napi_env>(env));
+  env.AddCleanupHook(CleanupBroadcast, static_cast<napi_env>(env));
   return exports;
 }
 
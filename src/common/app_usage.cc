@@ -0,0 +1,195 @@
+#include "app_usage.h"
+
+#include <algorithm>
+
+namespace inputhook {
+
+bool AppUsageLedger::Configure(const AppUsageOptions& options) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  bool wasEnabled = options_.enabled;
+  options_ = options;
+  if (!(options_.idleThresholdMs > 0.0)) {
+    options_.idleThresholdMs = 60000.0;
+  }
+  if (wasEnabled && options_.enabled) {
+    // Only thresholds changed; the totals and the focused app stay.
+    return false;
+  }
+  apps_.clear();
+  pressed_.reset();
+  current_ = nullptr;
+  currentApp_.clear();
+  currentWindow_ = 0;
+  lastActivity_ = 0.0;
+  creditedUntil_ = 0.0;
+  since_ = 0.0;
+  return options_.enabled;
+}
+
+AppUsageOptions AppUsageLedger::Options() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return options_;
+}
+
+void AppUsageLedger::ResetKeys() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  pressed_.reset();
+}
+
+UsageTotals* AppUsageLedger::CurrentWindowTotals() {
+  if (!current_ || !currentWindow_) {
+    return nullptr;
+  }
+  auto found = current_->windows.find(currentWindow_);
+  if (found != current_->windows.end()) {
+    return &found->second;
+  }
+  if (current_->windows.size() >= kMaxWindowsPerApp) {
+    return nullptr;
+  }
+  return &current_->windows[currentWindow_];
+}
+
+void AppUsageLedger::CreditActiveTime(double now) {
+  if (lastActivity_ > 0.0 && now - lastActivity_ <= options_.idleThresholdMs) {
+    double credit = now - std::max(lastActivity_, creditedUntil_);
+    if (credit > 0.0 && current_) {
+      current_->totals.activeMs += credit;
+      if (UsageTotals* window = CurrentWindowTotals()) {
+        window->activeMs += credit;
+      }
+    }
+  }
+  lastActivity_ = now;
+  creditedUntil_ = std::max(creditedUntil_, now);
+}
+
+void AppUsageLedger::Process(const InputEvent& event) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (!options_.enabled) {
+    return;
+  }
+  if (since_ == 0.0) {
+    since_ = event.time;
+  }
+
+  if (event.type == "focus") {
+    // Time up to the switch belongs to the previous window; switching is
+    // itself activity for the next one.
+    CreditActiveTime(event.time);
+    currentApp_ = event.app.value_or(std::string());
+    currentWindow_ = event.window.value_or(0);
+    if (!event.window && !event.app) {
+      // Focus was lost; input until the next focus is not attributed.
+      current_ = nullptr;
+      return;
+    }
+    current_ = &apps_[currentApp_];
+    current_->focusCount++;
+    if (event.pid) {
+      current_->pid = *event.pid;
+    }
+    return;
+  }
+
+  uint32_t UsageTotals::*counter = nullptr;
+  uint32_t usage = event.hidUsage.value_or(0);
+  if (event.type == "keydown") {
+    if (usage > 0 && usage < pressed_.size()) {
+      if (pressed_.test(usage)) {
+        return;  // autorepeat
+      }
+      pressed_.set(usage);
+    }
+    counter = &UsageTotals::keys;
+  } else if (event.type == "keyup") {
+    if (usage > 0 && usage < pressed_.size()) {
+      pressed_.reset(usage);
+    }
+    return;
+  } else if (event.type == "mousedown") {
+    counter = &UsageTotals::clicks;
+  } else if (event.type == "wheel") {
+    counter = &UsageTotals::scrolls;
+  } else if (event.type == "mousemove") {
+    counter = &UsageTotals::moves;
+  } else {
+    return;
+  }
+
+  CreditActiveTime(event.time);
+  if (!current_) {
+    return;
+  }
+  current_->totals.*counter += 1;
+  if (UsageTotals* window = CurrentWindowTotals()) {
+    window->*counter += 1;
+  }
+}
+
+void AppUsageLedger::ResetTotals(double now) {
+  for (auto& entry : apps_) {
+    entry.second.totals = UsageTotals();
+    entry.second.focusCount = 0;
+    entry.second.windows.clear();
+  }
+  // Keep only the focused app so its next activity has an entry to land in.
+  for (auto it = apps_.begin(); it != apps_.end();) {
+    it = &it->second == current_ ? std::next(it) : apps_.erase(it);
+  }
+  creditedUntil_ = std::max(creditedUntil_, now);
+  since_ = now;
+}
+
+AppUsageSnapshot AppUsageLedger::Snapshot(double now, bool reset) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  AppUsageSnapshot snapshot;
+  snapshot.sinceMs = since_;
+  snapshot.currentApp = currentApp_;
+  snapshot.currentWindow = currentWindow_;
+
+  // The stretch since the last input counts while it is shorter than the
+  // idle threshold, without committing it.
+  double pending = 0.0;
+  if (current_ && lastActivity_ > 0.0 && now - lastActivity_ <= options_.idleThresholdMs) {
+    pending = std::max(0.0, now - std::max(lastActivity_, creditedUntil_));
+  }
+
+  for (const auto& entry : apps_) {
+    const AppEntry& app = entry.second;
+    if (app.focusCount == 0 && app.totals.activeMs == 0.0 && &app != current_) {
+      continue;
+    }
+    AppUsage usage;
+    usage.app = entry.first;
+    usage.pid = app.pid;
+    usage.focusCount = app.focusCount;
+    usage.totals = app.totals;
+    for (const auto& window : app.windows) {
+      usage.windows.push_back({window.first, window.second});
+    }
+    if (&app == current_ && pending > 0.0) {
+      usage.totals.activeMs += pending;
+      for (WindowUsage& window : usage.windows) {
+        if (window.window == currentWindow_) {
+          window.totals.activeMs += pending;
+        }
+      }
+    }
+    std::sort(usage.windows.begin(), usage.windows.end(),
+              [](const WindowUsage& a, const WindowUsage& b) {
+                return a.totals.activeMs > b.totals.activeMs;
+              });
+    snapshot.apps.push_back(std::move(usage));
+  }
+  std::sort(snapshot.apps.begin(), snapshot.apps.end(), [](const AppUsage& a, const AppUsage& b) {
+    return a.totals.activeMs > b.totals.activeMs;
+  });
+
+  if (reset) {
+    ResetTotals(now);
+  }
+  return snapshot;
+}
+
+} // namespace inputhook
@@ -0,0 +1,96 @@
+#pragma once
+
+#include <bitset>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "event.h"
+
+namespace inputhook {
+
+struct AppUsageOptions {
+  bool enabled = false;
+  // Gaps between consecutive inputs longer than this count as idle, not as
+  // active time.
+  double idleThresholdMs = 60000.0;
+};
+
+struct UsageTotals {
+  double activeMs = 0.0;
+  uint32_t keys = 0;
+  uint32_t clicks = 0;
+  uint32_t scrolls = 0;
+  uint32_t moves = 0;
+};
+
+struct WindowUsage {
+  uint64_t window = 0;
+  UsageTotals totals;
+};
+
+struct AppUsage {
+  std::string app;
+  uint32_t pid = 0;
+  uint32_t focusCount = 0;
+  UsageTotals totals;
+  std::vector<WindowUsage> windows;
+};
+
+struct AppUsageSnapshot {
+  double sinceMs = 0.0;
+  std::vector<AppUsage> apps;
+  // The focused application, empty before the first focus event.
+  std::string currentApp;
+  uint64_t currentWindow = 0;
+};
+
+// Per-application and per-window usage totals delimited by "focus" events
+// and the idle threshold, so app reports need neither the raw event stream
+// nor focus history in JS.
+class AppUsageLedger {
+ public:
+  // Windows beyond this many per app only count toward the app totals.
+  static constexpr std::size_t kMaxWindowsPerApp = 256;
+
+  // Reconfiguring an enabled ledger keeps its totals. Returns true when it
+  // starts from scratch and needs the focused window reported again.
+  bool Configure(const AppUsageOptions& options);
+  AppUsageOptions Options() const;
+  AppUsageSnapshot Snapshot(double now, bool reset);
+  // Forgets held keys, for when their releases may have been missed.
+  void ResetKeys();
+
+  void Process(const InputEvent& event);
+
+ private:
+  struct AppEntry {
+    uint32_t pid = 0;
+    uint32_t focusCount = 0;
+    UsageTotals totals;
+    std::unordered_map<uint64_t, UsageTotals> windows;
+  };
+
+  // Credits the stretch since the last activity to the focused window when
+  // it is within the idle threshold.
+  void CreditActiveTime(double now);
+  UsageTotals* CurrentWindowTotals();
+  void ResetTotals(double now);
+
+  mutable std::mutex mutex_;
+  AppUsageOptions options_;
+  std::map<std::string, AppEntry> apps_;
+  std::bitset<256> pressed_;
+  AppEntry* current_ = nullptr;
+  std::string currentApp_;
+  uint64_t currentWindow_ = 0;
+  double lastActivity_ = 0.0;
+  // Active time up to here is already in the totals (or was reset away).
+  double creditedUntil_ = 0.0;
+  double since_ = 0.0;
+};
+
+} // namespace inputhook
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <algorithm>
+
+#include "event.h"
+
+namespace inputhook {
+
+// Follows the absolute pointer position across backends. Events with x/y
+// resynchronize it. Backends that only report device deltas (evdev) are
+// integrated instead; once an absolute position has been seen, delta-only
+// motion is ignored so it cannot drift the cursor away from the real one.
+struct CursorTracker {
+  double x = 0.0;
+  double y = 0.0;
+  bool known = false;
+  bool absolute = false;
+  // Screen extent that integrated deltas are clamped to, the way the real
+  // cursor stops at the edges. Integration starts at its centre; zero leaves
+  // integration unclamped and the position unknown.
+  double width = 0.0;
+  double height = 0.0;
+
+  // Returns true when the event moved or located the cursor.
+  bool Update(const InputEvent& event) {
+    if (event.x && event.y) {
+      x = *event.x;
+      y = *event.y;
+      known = true;
+      absolute = true;
+      return true;
+    }
+    if (event.type == "mousemove" && (event.deltaX || event.deltaY)) {
+      if (absolute) {
+        return false;
+      }
+      if (!known && width > 0.0 && height > 0.0) {
+        x = width / 2.0;
+        y = height / 2.0;
+        known = true;
+      }
+      x += event.deltaX.value_or(0);
+      y += event.deltaY.value_or(0);
+      if (width > 0.0 && height > 0.0) {
+        x = std::clamp(x, 0.0, width - 1.0);
+        y = std::clamp(y, 0.0, height - 1.0);
+      }
+      return true;
+    }
+    return false;
+  }
+};
+
+} // namespace inputhook
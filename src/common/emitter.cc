@@ -1,3 +1,4 @@
+#include <iterator>
 #include <string>
 #include <utility>
 
@@ -8,13 +9,15 @@
 #elif defined(__APPLE__)
 #include "../platform/mac/hook_mac.h"
 #elif defined(__linux__)
+#include "../platform/linux/hook_evdev.h"
 #include "../platform/linux/hook_x11.h"
+#include "../platform/linux/hook_xrecord.h"
 #endif
 
 namespace inputhook {
 
-PlatformHook::PlatformHook(EventCallback callback)
-    : callback_(std::move(callback)) {}
+PlatformHook::PlatformHook(EventSink* sink)
+    : sink_(sink) {}
 
 PlatformHook::~PlatformHook() = default;
 
@@ -26,22 +29,103 @@ std::string PlatformHook::GetLastError() const {
   return {};
 }
 
-void PlatformHook::Dispatch(InputEvent event) {
-  if (callback_) {
-    callback_(std::move(event));
+HookStats PlatformHook::GetStats() const {
+  return {};
+}
+
+bool PlatformHook::SetPaused(bool paused) {
+  if (paused_.exchange(paused, std::memory_order_acq_rel) == paused || OnPauseChanged()) {
+    return true;
+  }
+  // Only a resume can fail; let the backend drop whatever it set up.
+  paused_.store(true, std::memory_order_release);
+  OnPauseChanged();
+  return false;
+}
+
+bool PlatformHook::IsPaused() const {
+  return paused_.load(std::memory_order_acquire);
+}
+
+void PlatformHook::RequestFocus() {
+  focusRequested_.store(true, std::memory_order_release);
+  OnFocusRequested();
+}
+
+bool PlatformHook::TakeFocusRequest() {
+  return focusRequested_.exchange(false, std::memory_order_acq_rel);
+}
+
+void PlatformHook::Dispatch(InputEvent&& event) {
+  if (sink_ && !paused_.load(std::memory_order_acquire)) {
+    sink_->OnEvent(std::move(event));
   }
 }
 
-InputEmitter::InputEmitter(EventCallback callback) {
+void PlatformHook::FlushSink() {
+  if (sink_) {
+    sink_->Flush();
+  }
+}
+
+void PlatformHook::ResetSink() {
+  if (sink_) {
+    sink_->Reset();
+  }
+}
+
+namespace {
+
+// Backend names in preference order; the first one is the platform default.
 #if defined(_WIN32)
-  platformHook_ = std::make_unique<platform::win::WinPlatformHook>(std::move(callback));
+const char* const kBackends[] = {"llhook"};
 #elif defined(__APPLE__)
-  platformHook_ = std::make_unique<platform::mac::MacPlatformHook>(std::move(callback));
+const char* const kBackends[] = {"eventtap"};
 #elif defined(__linux__)
-  platformHook_ = std::make_unique<platform::linux::LinuxPlatformHook>(std::move(callback));
+const char* const kBackends[] = {"xi2", "xrecord", "evdev"};
 #else
-  (void)callback;
+const char* const kBackends[] = {"none"};
 #endif
+
+std::unique_ptr<PlatformHook> CreatePlatformHook(const std::string& backend,
+                                                 const EmitterOptions& options,
+                                                 EventSink* sink) {
+#if defined(_WIN32)
+  if (backend == "llhook") {
+    return std::make_unique<platform::win::WinPlatformHook>(sink);
+  }
+#elif defined(__APPLE__)
+  if (backend == "eventtap") {
+    return std::make_unique<platform::mac::MacPlatformHook>(sink);
+  }
+#elif defined(__linux__)
+  if (backend == "xi2") {
+    return std::make_unique<platform::linux::LinuxPlatformHook>(sink);
+  }
+  if (backend == "xrecord") {
+    return std::make_unique<platform::linux::XRecordPlatformHook>(sink);
+  }
+  if (backend == "evdev") {
+    return std::make_unique<platform::linux::EvdevPlatformHook>(sink, options.devices);
+  }
+#endif
+  (void)options;
+  (void)sink;
+  return nullptr;
+}
+
+} // namespace
+
+std::vector<std::string> InputEmitter::AvailableBackends() {
+  return std::vector<std::string>(std::begin(kBackends), std::end(kBackends));
+}
+
+InputEmitter::InputEmitter(EventSink* sink, const EmitterOptions& options)
+    : sink_(sink), backend_(options.backend.empty() ? kBackends[0] : options.backend) {
+  platformHook_ = CreatePlatformHook(backend_, options, sink);
+  if (!platformHook_) {
+    creationError_ = "unknown input backend '" + backend_ + "'";
+  }
 }
 
 InputEmitter::~InputEmitter() {
@@ -55,15 +139,36 @@ bool InputEmitter::Start() {
 void InputEmitter::Stop() {
   if (platformHook_) {
     platformHook_->Stop();
+    // The hook thread is gone, so release whatever buffering stages still
+    // hold (a coalesced motion) instead of losing it.
+    sink_->Flush();
   }
 }
 
 std::string InputEmitter::GetFailureReason() const {
-  return platformHook_ ? platformHook_->GetFailureReason() : std::string();
+  return platformHook_ ? platformHook_->GetFailureReason() : creationError_;
 }
 
 std::string InputEmitter::GetLastError() const {
   return platformHook_ ? platformHook_->GetLastError() : std::string();
 }
 
+HookStats InputEmitter::GetStats() const {
+  return platformHook_ ? platformHook_->GetStats() : HookStats();
+}
+
+bool InputEmitter::SetPaused(bool paused) {
+  return !platformHook_ || platformHook_->SetPaused(paused);
+}
+
+bool InputEmitter::IsPaused() const {
+  return platformHook_ && platformHook_->IsPaused();
+}
+
+void InputEmitter::RequestFocus() {
+  if (platformHook_) {
+    platformHook_->RequestFocus();
+  }
+}
+
 } // namespace inputhook
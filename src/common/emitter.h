@@ -1,8 +1,10 @@
 #pragma once
 
+#include <atomic>
+#include <cstdint>
 #include <string>
-#include <functional>
 #include <memory>
+#include <vector>
 
 #include "event.h"
 
@@ -10,11 +12,35 @@ namespace inputhook {
 
 class PlatformHook;
 
-class InputEmitter {
+struct HookStats {
+  uint64_t reconnects = 0;
+};
+
+// Receives events on the hook thread. Flush() marks the end of a batch the
+// platform read in one go so buffering stages can release what they hold.
+// Reset() says key and button releases may have been missed (the connection
+// was lost), so anything tracking held keys must forget them.
+class EventSink {
  public:
-  using EventCallback = std::function<void(InputEvent&&)>;
+  virtual ~EventSink() = default;
+  virtual void OnEvent(InputEvent&& event) = 0;
+  virtual void Flush() {}
+  virtual void Reset() {}
+};
+
+struct EmitterOptions {
+  // One of InputEmitter::AvailableBackends(); empty selects the default.
+  std::string backend;
+  // evdev only: read exactly these paths (devices, FIFOs or recordings of
+  // struct input_event) instead of scanning /dev/input.
+  std::vector<std::string> devices;
+};
 
-  explicit InputEmitter(EventCallback callback);
+class InputEmitter {
+ public:
+  // `sink` must outlive the emitter. An unknown backend leaves the emitter
+  // without a hook and Start() fails with a reason.
+  explicit InputEmitter(EventSink* sink, const EmitterOptions& options = EmitterOptions());
   ~InputEmitter();
 
   InputEmitter(const InputEmitter&) = delete;
@@ -24,16 +50,27 @@ class InputEmitter {
   void Stop();
   std::string GetFailureReason() const;
   std::string GetLastError() const;
+  HookStats GetStats() const;
+  const std::string& Backend() const { return backend_; }
+  // Safe to call from any thread, before or after Start(). Returns false
+  // when resuming failed; the emitter then stays paused.
+  bool SetPaused(bool paused);
+  bool IsPaused() const;
+  // Safe to call from any thread. See PlatformHook::RequestFocus().
+  void RequestFocus();
+
+  static std::vector<std::string> AvailableBackends();
 
  private:
+  EventSink* sink_;
   std::unique_ptr<PlatformHook> platformHook_;
+  std::string backend_;
+  std::string creationError_;
 };
 
 class PlatformHook {
  public:
-  using EventCallback = InputEmitter::EventCallback;
-
-  explicit PlatformHook(EventCallback callback);
+  explicit PlatformHook(EventSink* sink);
   virtual ~PlatformHook();
 
   PlatformHook(const PlatformHook&) = delete;
@@ -43,12 +80,38 @@ class PlatformHook {
   virtual void Stop() = 0;
   virtual std::string GetFailureReason() const;
   virtual std::string GetLastError() const;
+  virtual HookStats GetStats() const;
+
+  // Stops delivering input while the thread and connection stay up, so
+  // resuming is immediate. Events that still arrive are dropped in Dispatch().
+  // Returns false when the backend could not resume capture, which leaves the
+  // hook paused.
+  bool SetPaused(bool paused);
+  bool IsPaused() const;
+
+  // Asks the hook thread to report the focused window again, for a consumer
+  // that just started tracking focus. Backends without focus tracking ignore
+  // it.
+  void RequestFocus();
 
 protected:
-  void Dispatch(InputEvent event);
+  void Dispatch(InputEvent&& event);
+  void FlushSink();
+  void ResetSink();
+  // Runs on the SetPaused() caller's thread after the flag changed; backends
+  // that can stop capture at the source wake their hook thread here. Returns
+  // false when capture could not be resumed.
+  virtual bool OnPauseChanged() { return true; }
+  // Runs on the RequestFocus() caller's thread; backends that track focus
+  // wake their hook thread, which then calls TakeFocusRequest().
+  virtual void OnFocusRequested() {}
+  // True once per RequestFocus() call that has not been served yet.
+  bool TakeFocusRequest();
 
  private:
-  EventCallback callback_;
+  EventSink* sink_;
+  std::atomic<bool> paused_{false};
+  std::atomic<bool> focusRequested_{false};
 };
 
 } // namespace inputhook
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <napi.h>
+#include <cstdint>
 #include <optional>
 #include <string>
 
@@ -13,16 +14,86 @@ struct InputModifiers {
   bool meta = false;
 };
 
+// Box covered by the pointer, in the same coordinates as x/y.
+struct InputBounds {
+  int32_t left = 0;
+  int32_t top = 0;
+  int32_t right = 0;
+  int32_t bottom = 0;
+};
+
+enum EventTypeBit : uint32_t {
+  kKeyDownBit = 1u << 0,
+  kKeyUpBit = 1u << 1,
+  kMouseDownBit = 1u << 2,
+  kMouseUpBit = 1u << 3,
+  kMouseMoveBit = 1u << 4,
+  kWheelBit = 1u << 5,
+  kFocusBit = 1u << 6,
+  // "lock" and "unlock" only make sense together, so they share a bit.
+  kLockBit = 1u << 7,
+  kOtherTypeBit = 1u << 31,
+  kAllTypeBits = 0xFFFFFFFFu,
+};
+
+inline uint32_t TypeBitFor(const std::string& type) {
+  if (type == "mousemove") {
+    return kMouseMoveBit;
+  }
+  if (type == "keydown") {
+    return kKeyDownBit;
+  }
+  if (type == "keyup") {
+    return kKeyUpBit;
+  }
+  if (type == "mousedown") {
+    return kMouseDownBit;
+  }
+  if (type == "mouseup") {
+    return kMouseUpBit;
+  }
+  if (type == "wheel") {
+    return kWheelBit;
+  }
+  if (type == "focus") {
+    return kFocusBit;
+  }
+  if (type == "lock" || type == "unlock") {
+    return kLockBit;
+  }
+  return kOtherTypeBit;
+}
+
 struct InputEvent {
   std::string type;
+  // TypeBitFor(type), filled in once when the event enters the pipeline so
+  // stages test a bit instead of comparing strings; 0 before that.
+  uint32_t typeBit = 0;
   double time = 0.0;
   std::optional<uint32_t> keycode;
   std::optional<uint32_t> scancode;
+  std::optional<uint32_t> hidUsage;
   std::optional<uint32_t> button;
   std::optional<int32_t> x;
   std::optional<int32_t> y;
+  // Monitor containing x/y and the position relative to it (X11 only).
+  std::optional<uint32_t> monitor;
+  std::optional<int32_t> monitorX;
+  std::optional<int32_t> monitorY;
   std::optional<int32_t> deltaX;
   std::optional<int32_t> deltaY;
+  std::optional<uint32_t> clicks;
+  std::optional<double> distance;
+  std::optional<double> duration;
+  // Extent of a drag's path ("dragstart" so far, "dragend" in total).
+  std::optional<InputBounds> bounds;
+  // Focused top-level window. "focus" events also carry the application
+  // (WM_CLASS class or executable name) and its process id.
+  std::optional<uint64_t> window;
+  std::optional<std::string> app;
+  std::optional<uint32_t> pid;
+  // What caused a "lock" event: "screensaver", "dpms" or "session".
+  std::optional<std::string> reason;
   InputModifiers modifiers;
 };
 
@@ -37,6 +108,9 @@ inline Napi::Object ToJsObject(Napi::Env env, const InputEvent& event) {
   if (event.scancode) {
     output.Set("scancode", *event.scancode);
   }
+  if (event.hidUsage) {
+    output.Set("hidUsage", *event.hidUsage);
+  }
   if (event.button) {
     output.Set("button", *event.button);
   }
@@ -46,12 +120,46 @@ inline Napi::Object ToJsObject(Napi::Env env, const InputEvent& event) {
   if (event.y) {
     output.Set("y", *event.y);
   }
+  if (event.monitor) {
+    output.Set("monitor", *event.monitor);
+    output.Set("monitorX", event.monitorX.value_or(0));
+    output.Set("monitorY", event.monitorY.value_or(0));
+  }
   if (event.deltaX) {
     output.Set("deltaX", *event.deltaX);
   }
   if (event.deltaY) {
     output.Set("deltaY", *event.deltaY);
   }
+  if (event.clicks) {
+    output.Set("clicks", *event.clicks);
+  }
+  if (event.distance) {
+    output.Set("distance", *event.distance);
+  }
+  if (event.duration) {
+    output.Set("duration", *event.duration);
+  }
+  if (event.bounds) {
+    Napi::Object bounds = Napi::Object::New(env);
+    bounds.Set("left", event.bounds->left);
+    bounds.Set("top", event.bounds->top);
+    bounds.Set("right", event.bounds->right);
+    bounds.Set("bottom", event.bounds->bottom);
+    output.Set("bounds", bounds);
+  }
+  if (event.window) {
+    output.Set("window", static_cast<double>(*event.window));
+  }
+  if (event.app) {
+    output.Set("app", *event.app);
+  }
+  if (event.pid) {
+    output.Set("pid", *event.pid);
+  }
+  if (event.reason) {
+    output.Set("reason", *event.reason);
+  }
 
   Napi::Object modifierObj = Napi::Object::New(env);
   modifierObj.Set("shift", event.modifiers.shift);
@@ -0,0 +1,395 @@
+#include "event_broadcast.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+
+#if !defined(_WIN32)
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "event_codec.h"
+
+namespace inputhook {
+
+namespace {
+
+constexpr char kMagic[8] = {'I', 'H', 'B', 'C', 'A', 'S', 'T', '1'};
+constexpr uint32_t kVersion = 1;
+constexpr uint32_t kMaxCapacity = 1u << 20;
+
+struct Header {
+  char magic[8];
+  uint32_t version;
+  uint32_t recordSize;
+  uint32_t capacity;
+  uint32_t publisherPid;
+  // Records published so far; the next one gets this sequence number + 1.
+  uint64_t writeSequence;
+  // Set to 1 before the segment is unlinked for one of another capacity, so
+  // readers still mapping it learn that nothing more will arrive.
+  uint64_t replaced;
+  uint8_t reserved[24];
+};
+
+struct Slot {
+  // 1-based sequence of the record held, 0 while it is being written.
+  uint64_t sequence;
+  uint8_t record[kEncodedEventSize];
+  uint8_t reserved[64 - sizeof(uint64_t) - kEncodedEventSize];
+};
+
+static_assert(sizeof(Header) == 64, "broadcast header must stay 64 bytes");
+static_assert(sizeof(Slot) == 64, "broadcast slots must stay one cache line");
+static_assert(std::atomic<uint64_t>::is_always_lock_free,
+              "sequence numbers are shared across processes and must be lock-free");
+
+// Both sides address the same memory; lock-free atomics are address-free,
+// so they work across mappings.
+std::atomic<uint64_t>* AtomicAt(const uint64_t* value) {
+  return reinterpret_cast<std::atomic<uint64_t>*>(const_cast<uint64_t*>(value));
+}
+
+std::string SegmentName(const std::string& name) {
+  return name.empty() || name[0] == '/' ? name : "/" + name;
+}
+
+#if !defined(_WIN32)
+std::string ErrnoMessage(const char* what, const std::string& name) {
+  return std::string(what) + " " + name + " failed: " + std::strerror(errno);
+}
+
+// The ring carries every keystroke, so a segment is only used when it
+// belongs to this user and nobody else can open it. Otherwise another user
+// could read the input, or plant a ring for subscribers to follow.
+bool CheckSegmentAccess(const struct stat& info, const std::string& segment, std::string* error) {
+  if (info.st_uid != geteuid()) {
+    *error = "broadcast " + segment + " belongs to another user";
+    return false;
+  }
+  if (info.st_mode & (S_IRWXG | S_IRWXO)) {
+    char mode[8];
+    std::snprintf(mode, sizeof(mode), "%04o", static_cast<unsigned>(info.st_mode & 07777));
+    *error = "broadcast " + segment + " is accessible to other users (mode " + mode + ")";
+    return false;
+  }
+  return true;
+}
+#endif
+
+} // namespace
+
+BroadcastPublisher::~BroadcastPublisher() {
+  Close();
+}
+
+BroadcastSubscriber::~BroadcastSubscriber() {
+  Close();
+}
+
+#if defined(_WIN32)
+
+bool BroadcastPublisher::Open(const std::string&, uint32_t, std::string* error) {
+  *error = "event broadcast is not supported on Windows";
+  return false;
+}
+
+void BroadcastPublisher::Close() {}
+
+bool BroadcastSubscriber::Open(const std::string&, bool, std::string* error) {
+  *error = "event broadcast is not supported on Windows";
+  return false;
+}
+
+void BroadcastSubscriber::Close() {}
+
+#else
+
+namespace {
+
+// Flags a segment that is about to be unlinked, for readers still mapping it.
+void MarkReplaced(int fd, std::size_t size) {
+  if (size < sizeof(Header)) {
+    return;
+  }
+  void* mapping = mmap(nullptr, sizeof(Header), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  if (mapping == MAP_FAILED) {
+    return;
+  }
+  auto* header = static_cast<Header*>(mapping);
+  if (std::memcmp(header->magic, kMagic, sizeof(kMagic)) == 0) {
+    AtomicAt(&header->replaced)->store(1, std::memory_order_release);
+  }
+  munmap(mapping, sizeof(Header));
+}
+
+// Opens the segment and takes the publisher lock. A segment of another size
+// is replaced rather than resized: readers still mapping the old size would
+// fault on a shrunk one, so they keep the orphaned copy, marked replaced,
+// until they reattach.
+int OpenSegment(const std::string& segment, std::size_t size, std::string* error) {
+  for (int attempt = 0; attempt < 2; ++attempt) {
+    int fd = shm_open(segment.c_str(), O_RDWR | O_CREAT, 0600);
+    if (fd < 0) {
+      *error = ErrnoMessage("shm_open", segment);
+      return -1;
+    }
+    struct stat info;
+    if (fstat(fd, &info) != 0) {
+      *error = ErrnoMessage("fstat", segment);
+      close(fd);
+      return -1;
+    }
+    if (!CheckSegmentAccess(info, segment, error)) {
+      close(fd);
+      return -1;
+    }
+    // Two publishers would interleave sequence numbers. The lock is advisory
+    // and not every platform supports it on shared memory, so only an actual
+    // conflict is an error.
+    if (flock(fd, LOCK_EX | LOCK_NB) != 0 && errno == EWOULDBLOCK) {
+      *error = "broadcast " + segment + " is already published by another process";
+      close(fd);
+      return -1;
+    }
+    if (fstat(fd, &info) != 0) {
+      *error = ErrnoMessage("fstat", segment);
+      close(fd);
+      return -1;
+    }
+    if (static_cast<std::size_t>(info.st_size) == size) {
+      return fd;
+    }
+    if (info.st_size == 0 || attempt > 0) {
+      if (ftruncate(fd, static_cast<off_t>(size)) != 0) {
+        *error = ErrnoMessage("ftruncate", segment);
+        close(fd);
+        return -1;
+      }
+      return fd;
+    }
+    MarkReplaced(fd, static_cast<std::size_t>(info.st_size));
+    shm_unlink(segment.c_str());
+    close(fd);
+  }
+  return -1;
+}
+
+} // namespace
+
+bool BroadcastPublisher::Open(const std::string& name, uint32_t capacity, std::string* error) {
+  Close();
+  if (capacity < 1 || capacity > kMaxCapacity) {
+    *error = "capacity must be between 1 and " + std::to_string(kMaxCapacity);
+    return false;
+  }
+  uint32_t slots = 1;
+  while (slots < capacity) {
+    slots <<= 1;
+  }
+
+  std::string segment = SegmentName(name);
+  std::size_t size = sizeof(Header) + static_cast<std::size_t>(slots) * sizeof(Slot);
+  int fd = OpenSegment(segment, size, error);
+  if (fd < 0) {
+    return false;
+  }
+  void* mapping = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  if (mapping == MAP_FAILED) {
+    *error = ErrnoMessage("mmap", segment);
+    close(fd);
+    return false;
+  }
+
+  auto* header = static_cast<Header*>(mapping);
+  bool compatible = std::memcmp(header->magic, kMagic, sizeof(kMagic)) == 0 &&
+                    header->version == kVersion && header->recordSize == kEncodedEventSize &&
+                    header->capacity == slots;
+  if (!compatible) {
+    std::memset(mapping, 0, size);
+    header->version = kVersion;
+    header->recordSize = static_cast<uint32_t>(kEncodedEventSize);
+    header->capacity = slots;
+    std::atomic_thread_fence(std::memory_order_release);
+    std::memcpy(header->magic, kMagic, sizeof(kMagic));
+  }
+  header->publisherPid = static_cast<uint32_t>(getpid());
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  fd_ = fd;
+  base_ = static_cast<unsigned char*>(mapping);
+  size_ = size;
+  mask_ = slots - 1;
+  open_.store(true, std::memory_order_release);
+  return true;
+}
+
+void BroadcastPublisher::Close() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  open_.store(false, std::memory_order_release);
+  if (base_) {
+    // The segment outlives the publisher so a restarted one can continue the
+    // sequence readers are following.
+    reinterpret_cast<Header*>(base_)->publisherPid = 0;
+    munmap(base_, size_);
+  }
+  if (fd_ >= 0) {
+    close(fd_);
+  }
+  fd_ = -1;
+  base_ = nullptr;
+  size_ = 0;
+  mask_ = 0;
+}
+
+bool BroadcastSubscriber::Open(const std::string& name, bool fromStart, std::string* error) {
+  Close();
+  std::string segment = SegmentName(name);
+  int fd = shm_open(segment.c_str(), O_RDONLY, 0);
+  if (fd < 0) {
+    *error = errno == ENOENT ? "no broadcast named " + segment
+                             : ErrnoMessage("shm_open", segment);
+    return false;
+  }
+  struct stat info;
+  if (fstat(fd, &info) != 0) {
+    *error = ErrnoMessage("fstat", segment);
+    close(fd);
+    return false;
+  }
+  if (!CheckSegmentAccess(info, segment, error)) {
+    close(fd);
+    return false;
+  }
+  if (static_cast<std::size_t>(info.st_size) < sizeof(Header)) {
+    *error = "broadcast " + segment + " is not initialized";
+    close(fd);
+    return false;
+  }
+  std::size_t size = static_cast<std::size_t>(info.st_size);
+  void* mapping = mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+  close(fd);
+  if (mapping == MAP_FAILED) {
+    *error = ErrnoMessage("mmap", segment);
+    return false;
+  }
+
+  const auto* header = static_cast<const Header*>(mapping);
+  if (std::memcmp(header->magic, kMagic, sizeof(kMagic)) != 0 || header->version != kVersion ||
+      header->recordSize != kEncodedEventSize ||
+      sizeof(Header) + static_cast<std::size_t>(header->capacity) * sizeof(Slot) > size) {
+    *error = "broadcast " + segment + " has an unknown layout";
+    munmap(mapping, size);
+    return false;
+  }
+  base_ = static_cast<const unsigned char*>(mapping);
+  size_ = size;
+  capacity_ = header->capacity;
+  uint64_t written = AtomicAt(&header->writeSequence)->load(std::memory_order_acquire);
+  next_ = written;
+  if (fromStart) {
+    next_ = written > capacity_ ? written - capacity_ : 0;
+  }
+  lost_ = 0;
+  return true;
+}
+
+void BroadcastSubscriber::Close() {
+  if (base_) {
+    munmap(const_cast<unsigned char*>(base_), size_);
+  }
+  base_ = nullptr;
+  size_ = 0;
+  capacity_ = 0;
+}
+
+#endif
+
+void BroadcastPublisher::Publish(const InputEvent& event) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (!base_) {
+    return;
+  }
+  auto* header = reinterpret_cast<Header*>(base_);
+  std::atomic<uint64_t>* written = AtomicAt(&header->writeSequence);
+  uint64_t sequence = written->load(std::memory_order_relaxed) + 1;
+  Slot* slot = reinterpret_cast<Slot*>(base_ + sizeof(Header)) + ((sequence - 1) & mask_);
+
+  std::atomic<uint64_t>* slotSequence = AtomicAt(&slot->sequence);
+  slotSequence->store(0, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+  EncodeEvent(event, slot->record);
+  slotSequence->store(sequence, std::memory_order_release);
+  written->store(sequence, std::memory_order_release);
+}
+
+uint64_t BroadcastPublisher::Sequence() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (!base_) {
+    return 0;
+  }
+  const auto* header = reinterpret_cast<const Header*>(base_);
+  return AtomicAt(&header->writeSequence)->load(std::memory_order_acquire);
+}
+
+BroadcastReadResult BroadcastSubscriber::Read(std::size_t max, std::vector<uint8_t>* out) {
+  BroadcastReadResult result;
+  if (!base_) {
+    return result;
+  }
+  const auto* header = reinterpret_cast<const Header*>(base_);
+  const auto* slots = reinterpret_cast<const Slot*>(base_ + sizeof(Header));
+  uint64_t written = AtomicAt(&header->writeSequence)->load(std::memory_order_acquire);
+  if (written < next_) {
+    // The publisher reinitialized the ring; follow it from here.
+    next_ = written;
+  }
+  if (written - next_ > capacity_) {
+    result.lost += written - next_ - capacity_;
+    next_ = written - capacity_;
+  }
+
+  uint8_t record[kEncodedEventSize];
+  while (next_ < written && result.records < max) {
+    const Slot& slot = slots[next_ % capacity_];
+    uint64_t expected = next_ + 1;
+    next_++;
+    std::atomic<uint64_t>* slotSequence = AtomicAt(&slot.sequence);
+    if (slotSequence->load(std::memory_order_acquire) != expected) {
+      result.lost++;
+      continue;
+    }
+    std::memcpy(record, slot.record, sizeof(record));
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if (slotSequence->load(std::memory_order_relaxed) != expected) {
+      result.lost++;
+      continue;
+    }
+    out->insert(out->end(), record, record + sizeof(record));
+    result.records++;
+  }
+  lost_ += result.lost;
+  // What was published before the replacement is still read out first.
+  result.replaced = next_ == written && Replaced();
+  return result;
+}
+
+uint32_t BroadcastSubscriber::PublisherPid() const {
+  return base_ ? reinterpret_cast<const Header*>(base_)->publisherPid : 0;
+}
+
+bool BroadcastSubscriber::Replaced() const {
+  if (!base_) {
+    return false;
+  }
+  const auto* header = reinterpret_cast<const Header*>(base_);
+  return AtomicAt(&header->replaced)->load(std::memory_order_acquire) != 0;
+}
+
+} // namespace inputhook
@@ -0,0 +1,94 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "event.h"
+
+namespace inputhook {
+
+// Shared-memory ring that one hook process publishes events into and any
+// number of local processes read without a hook or X connection of their own.
+//
+// The segment is a 64-byte header followed by `capacity` 64-byte slots, each
+// holding the slot's sequence number and one kEncodedEventSize record. The
+// publisher clears a slot's sequence, writes the record, then stores the
+// sequence and bumps the header's write sequence; readers copy the record and
+// keep it only if the slot sequence is unchanged afterwards. Readers never
+// write, so they map the segment read-only, and a slow reader only loses the
+// records that were overwritten, which it is told about. The segment is
+// private to the publishing user (mode 0600); both sides refuse one that is
+// not.
+class BroadcastPublisher {
+ public:
+  BroadcastPublisher() = default;
+  ~BroadcastPublisher();
+
+  BroadcastPublisher(const BroadcastPublisher&) = delete;
+  BroadcastPublisher& operator=(const BroadcastPublisher&) = delete;
+
+  // `capacity` is rounded up to a power of two. Reopening a segment of the
+  // same capacity continues its sequence so attached readers carry on; any
+  // other capacity replaces the segment and readers must attach again.
+  bool Open(const std::string& name, uint32_t capacity, std::string* error);
+  void Close();
+  bool IsOpen() const { return open_.load(std::memory_order_acquire); }
+
+  // Called on the hook thread; the mutex only guards against a concurrent
+  // Close(), so it is uncontended in practice.
+  void Publish(const InputEvent& event);
+  uint64_t Sequence() const;
+
+ private:
+  mutable std::mutex mutex_;
+  std::atomic<bool> open_{false};
+  // Held open for the advisory lock that keeps out a second publisher.
+  int fd_ = -1;
+  unsigned char* base_ = nullptr;
+  std::size_t size_ = 0;
+  uint32_t mask_ = 0;
+};
+
+struct BroadcastReadResult {
+  std::size_t records = 0;
+  // Records overwritten before this reader got to them.
+  uint64_t lost = 0;
+  // The segment was replaced by one of another capacity and everything
+  // published into it has been read; the reader must attach again.
+  bool replaced = false;
+};
+
+class BroadcastSubscriber {
+ public:
+  BroadcastSubscriber() = default;
+  ~BroadcastSubscriber();
+
+  BroadcastSubscriber(const BroadcastSubscriber&) = delete;
+  BroadcastSubscriber& operator=(const BroadcastSubscriber&) = delete;
+
+  // Attaches read-only. Reading starts at the oldest record still in the
+  // ring when `fromStart` is set, else at the next one published.
+  bool Open(const std::string& name, bool fromStart, std::string* error);
+  void Close();
+
+  // Appends up to `max` records to `out`.
+  BroadcastReadResult Read(std::size_t max, std::vector<uint8_t>* out);
+  uint64_t Sequence() const { return next_; }
+  uint64_t Lost() const { return lost_; }
+  uint32_t PublisherPid() const;
+  // The publisher moved to a new segment under the same name.
+  bool Replaced() const;
+
+ private:
+  const unsigned char* base_ = nullptr;
+  std::size_t size_ = 0;
+  uint32_t capacity_ = 0;
+  uint64_t next_ = 0;
+  uint64_t lost_ = 0;
+};
+
+} // namespace inputhook
@@ -0,0 +1,128 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+
+#include "event.h"
+
+namespace inputhook {
+
+// Fixed-size binary form of an InputEvent for binary streams, in host byte
+// order (little-endian on every supported platform):
+//
+//   offset  size  field
+//        0     8  time (f64, epoch ms)
+//        8     1  type (EncodedEventType)
+//        9     1  modifiers (shift 1, ctrl 2, alt 4, meta 8)
+//       10     2  presence flags (EncodedField)
+//       12     4  keycode (u32)
+//       16     4  scancode (u32)
+//       20     2  hidUsage (u16)
+//       22     1  button (u8)
+//       23     1  clicks (u8, saturated)
+//       24     4  x (i32)
+//       28     4  y (i32)
+//       32     4  deltaX (i32)
+//       36     4  deltaY (i32)
+//       40     8  window (u64)
+//
+// Strings (app, reason), pid and monitor are not carried; object mode has
+// them.
+constexpr std::size_t kEncodedEventSize = 48;
+
+enum EncodedEventType : uint8_t {
+  kEncodedOther = 0,
+  kEncodedKeyDown = 1,
+  kEncodedKeyUp = 2,
+  kEncodedMouseDown = 3,
+  kEncodedMouseUp = 4,
+  kEncodedMouseMove = 5,
+  kEncodedWheel = 6,
+  kEncodedFocus = 7,
+  kEncodedLock = 8,
+  kEncodedUnlock = 9,
+  kEncodedClick = 10,
+  kEncodedDragStart = 11,
+  kEncodedDragEnd = 12,
+};
+
+enum EncodedField : uint16_t {
+  kEncodedKeycode = 1u << 0,
+  kEncodedScancode = 1u << 1,
+  kEncodedHidUsage = 1u << 2,
+  kEncodedButton = 1u << 3,
+  kEncodedClicks = 1u << 4,
+  kEncodedPosition = 1u << 5,
+  kEncodedDeltaX = 1u << 6,
+  kEncodedDeltaY = 1u << 7,
+  kEncodedWindow = 1u << 8,
+};
+
+inline uint8_t EncodeEventType(const std::string& type) {
+  static const char* const kNames[] = {"keydown", "keyup", "mousedown", "mouseup",
+                                       "mousemove", "wheel", "focus", "lock",
+                                       "unlock", "click", "dragstart", "dragend"};
+  for (std::size_t i = 0; i < sizeof(kNames) / sizeof(kNames[0]); ++i) {
+    if (type == kNames[i]) {
+      return static_cast<uint8_t>(i + 1);
+    }
+  }
+  return kEncodedOther;
+}
+
+// Writes kEncodedEventSize bytes to `out`, which needs no alignment.
+inline void EncodeEvent(const InputEvent& event, uint8_t* out) {
+  std::memset(out, 0, kEncodedEventSize);
+  auto put = [out](std::size_t offset, const auto& value) {
+    std::memcpy(out + offset, &value, sizeof(value));
+  };
+
+  uint16_t fields = 0;
+  uint8_t modifiers = (event.modifiers.shift ? 1 : 0) | (event.modifiers.ctrl ? 2 : 0) |
+                      (event.modifiers.alt ? 4 : 0) | (event.modifiers.meta ? 8 : 0);
+  put(0, event.time);
+  out[8] = EncodeEventType(event.type);
+  out[9] = modifiers;
+  if (event.keycode) {
+    fields |= kEncodedKeycode;
+    put(12, *event.keycode);
+  }
+  if (event.scancode) {
+    fields |= kEncodedScancode;
+    put(16, *event.scancode);
+  }
+  if (event.hidUsage) {
+    fields |= kEncodedHidUsage;
+    put(20, static_cast<uint16_t>(*event.hidUsage));
+  }
+  if (event.button) {
+    fields |= kEncodedButton;
+    out[22] = static_cast<uint8_t>(*event.button);
+  }
+  if (event.clicks) {
+    fields |= kEncodedClicks;
+    out[23] = static_cast<uint8_t>(*event.clicks > 255 ? 255 : *event.clicks);
+  }
+  if (event.x && event.y) {
+    fields |= kEncodedPosition;
+    put(24, *event.x);
+    put(28, *event.y);
+  }
+  if (event.deltaX) {
+    fields |= kEncodedDeltaX;
+    put(32, *event.deltaX);
+  }
+  if (event.deltaY) {
+    fields |= kEncodedDeltaY;
+    put(36, *event.deltaY);
+  }
+  if (event.window) {
+    fields |= kEncodedWindow;
+    put(40, *event.window);
+  }
+  put(10, fields);
+}
+
+} // namespace inputhook
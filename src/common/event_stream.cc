@@ -0,0 +1,76 @@
+#include "event_stream.h"
+
+#include <algorithm>
+#include <utility>
+
+#include "pipeline.h"
+
+namespace inputhook {
+
+void EventStream::Open(std::size_t capacity) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  ring_.assign(std::max<std::size_t>(capacity, 1), InputEvent());
+  head_ = 0;
+  count_ = 0;
+  waiting_ = false;
+  stats_ = EventStreamStats();
+  open_.store(true, std::memory_order_release);
+}
+
+void EventStream::Close() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  open_.store(false, std::memory_order_release);
+  ring_.clear();
+  ring_.shrink_to_fit();
+  head_ = 0;
+  count_ = 0;
+  waiting_ = false;
+}
+
+bool EventStream::Push(const InputEvent& event) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (!open_.load(std::memory_order_relaxed)) {
+    return false;
+  }
+  if (count_ == ring_.size()) {
+    InputEvent& newest = ring_[(head_ + count_ - 1) % ring_.size()];
+    if (event.type == "mousemove" && newest.type == "mousemove") {
+      MergeMotion(newest, event);
+      stats_.coalesced++;
+    } else {
+      stats_.dropped++;
+    }
+    return false;
+  }
+
+  ring_[(head_ + count_) % ring_.size()] = event;
+  count_++;
+  stats_.queued++;
+  stats_.highWater = std::max(stats_.highWater, count_);
+  bool wake = waiting_;
+  waiting_ = false;
+  return wake;
+}
+
+std::size_t EventStream::Pop(std::size_t max, std::vector<InputEvent>* out) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  std::size_t taken = std::min(max, count_);
+  for (std::size_t i = 0; i < taken; ++i) {
+    out->push_back(std::move(ring_[head_]));
+    head_ = (head_ + 1) % ring_.size();
+  }
+  count_ -= taken;
+  if (taken == 0) {
+    waiting_ = open_.load(std::memory_order_relaxed);
+  }
+  return taken;
+}
+
+EventStreamStats EventStream::Stats() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  EventStreamStats stats = stats_;
+  stats.depth = count_;
+  return stats;
+}
+
+} // namespace inputhook
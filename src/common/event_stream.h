@@ -0,0 +1,51 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+#include "event.h"
+
+namespace inputhook {
+
+struct EventStreamStats {
+  uint64_t queued = 0;
+  uint64_t coalesced = 0;
+  uint64_t dropped = 0;
+  std::size_t depth = 0;
+  std::size_t highWater = 0;
+};
+
+// Bounded queue between the hook thread and a pull-based JS reader. The
+// reader takes events only as fast as it consumes them, so a slow consumer
+// fills this queue instead of the unbounded threadsafe-function queue; once
+// full, motion folds into the newest queued motion and anything else is
+// dropped and counted.
+class EventStream {
+ public:
+  static constexpr std::size_t kDefaultCapacity = 8192;
+
+  void Open(std::size_t capacity);
+  void Close();
+  bool IsOpen() const { return open_.load(std::memory_order_acquire); }
+
+  // Hook thread. Returns true when the reader found the queue empty and
+  // must be woken; this happens once per empty read.
+  bool Push(const InputEvent& event);
+  // Moves up to `max` events into `out`. An empty read arms the wakeup.
+  std::size_t Pop(std::size_t max, std::vector<InputEvent>* out);
+  EventStreamStats Stats() const;
+
+ private:
+  mutable std::mutex mutex_;
+  std::atomic<bool> open_{false};
+  std::vector<InputEvent> ring_;
+  std::size_t head_ = 0;
+  std::size_t count_ = 0;
+  bool waiting_ = false;
+  EventStreamStats stats_;
+};
+
+} // namespace inputhook
@@ -0,0 +1,272 @@
+#include "frame_writer.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <climits>
+#include <cstring>
+#include <utility>
+
+#if !defined(_WIN32)
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+// macOS has no MSG_NOSIGNAL; SO_NOSIGPIPE covers the sockets it opens.
+#if !defined(_WIN32) && !defined(MSG_NOSIGNAL)
+#define MSG_NOSIGNAL 0
+#endif
+
+#include "event_codec.h"
+
+namespace inputhook {
+
+FrameWriter::~FrameWriter() {
+  Close();
+}
+
+#if defined(_WIN32)
+
+bool FrameWriter::OpenPath(const std::string&, std::size_t, std::string* error) {
+  *error = "event output is not supported on Windows";
+  return false;
+}
+
+bool FrameWriter::OpenFd(int, std::size_t, std::string* error) {
+  *error = "event output is not supported on Windows";
+  return false;
+}
+
+#else
+
+bool FrameWriter::OpenPath(const std::string& path, std::size_t capacity, std::string* error) {
+  sockaddr_un address{};
+  if (path.size() >= sizeof(address.sun_path)) {
+    *error = "socket path is too long: " + path;
+    return false;
+  }
+  int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+  if (fd < 0) {
+    *error = std::string("socket failed: ") + std::strerror(errno);
+    return false;
+  }
+  address.sun_family = AF_UNIX;
+  std::memcpy(address.sun_path, path.c_str(), path.size() + 1);
+  if (connect(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0) {
+    *error = "cannot connect to " + path + ": " + std::strerror(errno);
+    close(fd);
+    return false;
+  }
+  // The socket is ours, so it can be non-blocking and Close() never waits on
+  // a stuck peer.
+  fcntl(fd, F_SETFD, FD_CLOEXEC);
+#ifdef SO_NOSIGPIPE
+  int one = 1;
+  setsockopt(fd, SOL_SOCKET, SO_NOSIGPIPE, &one, sizeof(one));
+#endif
+  fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+  return Begin(fd, capacity);
+}
+
+bool FrameWriter::OpenFd(int fd, std::size_t capacity, std::string* error) {
+  int copy = fcntl(fd, F_DUPFD_CLOEXEC, 0);
+  if (copy < 0) {
+    *error = "invalid file descriptor " + std::to_string(fd) + ": " + std::strerror(errno);
+    return false;
+  }
+  return Begin(copy, capacity);
+}
+
+#endif
+
+bool FrameWriter::Begin(int fd, std::size_t capacity) {
+  Close();
+  fd_ = fd;
+#if !defined(_WIN32)
+  struct stat info;
+  bool known = fstat(fd, &info) == 0;
+  socket_ = known && S_ISSOCK(info.st_mode);
+  regularFile_ = known && S_ISREG(info.st_mode);
+#endif
+  {
+    std::lock_guard<std::mutex> lock(statsMutex_);
+    stats_ = FrameWriterStats();
+  }
+  {
+    std::lock_guard<std::mutex> lock(wakeMutex_);
+    signaled_ = false;
+    stopping_ = false;
+  }
+  queue_.Open(capacity);
+  open_.store(true, std::memory_order_release);
+  thread_ = std::thread(&FrameWriter::WriterLoop, this);
+  return true;
+}
+
+void FrameWriter::Close() {
+  open_.store(false, std::memory_order_release);
+  if (thread_.joinable()) {
+    {
+      std::lock_guard<std::mutex> lock(wakeMutex_);
+      stopping_ = true;
+    }
+    wakeCondition_.notify_one();
+    thread_.join();
+  }
+  queue_.Close();
+#if !defined(_WIN32)
+  if (fd_ >= 0) {
+    close(fd_);
+  }
+#endif
+  fd_ = -1;
+}
+
+void FrameWriter::Push(const InputEvent& event) {
+  if (!open_.load(std::memory_order_acquire) || !queue_.Push(event)) {
+    return;
+  }
+  {
+    std::lock_guard<std::mutex> lock(wakeMutex_);
+    signaled_ = true;
+  }
+  wakeCondition_.notify_one();
+}
+
+FrameWriterStats FrameWriter::Stats() const {
+  EventStreamStats queueStats = queue_.Stats();
+  std::lock_guard<std::mutex> lock(statsMutex_);
+  FrameWriterStats stats = stats_;
+  stats.coalesced = queueStats.coalesced;
+  stats.dropped = queueStats.dropped;
+  return stats;
+}
+
+void FrameWriter::Fail(std::string error) {
+  open_.store(false, std::memory_order_release);
+  std::lock_guard<std::mutex> lock(statsMutex_);
+  stats_.error = std::move(error);
+}
+
+void FrameWriter::WriterLoop() {
+  std::vector<InputEvent> events;
+  std::vector<uint8_t> records;
+  events.reserve(kMaxFrameEvents);
+  records.resize(kMaxFrameEvents * kEncodedEventSize);
+
+  while (true) {
+    events.clear();
+    // An empty Pop arms the queue, so the next Push signals us.
+    if (queue_.Pop(kMaxFrameEvents, &events) == 0) {
+      std::unique_lock<std::mutex> lock(wakeMutex_);
+      wakeCondition_.wait(lock, [this] { return signaled_ || stopping_; });
+      signaled_ = false;
+      if (stopping_) {
+        return;
+      }
+      continue;
+    }
+
+    for (std::size_t i = 0; i < events.size(); ++i) {
+      EncodeEvent(events[i], records.data() + i * kEncodedEventSize);
+    }
+    uint32_t size = static_cast<uint32_t>(events.size() * kEncodedEventSize);
+    uint8_t header[4] = {static_cast<uint8_t>(size), static_cast<uint8_t>(size >> 8),
+                         static_cast<uint8_t>(size >> 16), static_cast<uint8_t>(size >> 24)};
+    if (!WriteFrame(header, records.data(), size)) {
+      return;
+    }
+    std::lock_guard<std::mutex> lock(statsMutex_);
+    stats_.frames++;
+    stats_.events += events.size();
+    stats_.bytes += sizeof(header) + size;
+  }
+}
+
+bool FrameWriter::WriteFrame(const uint8_t* header, const uint8_t* records, std::size_t size) {
+#if defined(_WIN32)
+  (void)header;
+  (void)records;
+  (void)size;
+  return false;
+#else
+  iovec parts[2];
+  parts[0].iov_base = const_cast<uint8_t*>(header);
+  parts[0].iov_len = 4;
+  parts[1].iov_base = const_cast<uint8_t*>(records);
+  parts[1].iov_len = size;
+  iovec* next = parts;
+  int remaining = 2;
+  // Writes can return short; finish the frame so the peer never sees a torn
+  // one. Nothing here may block for long, or Close() would hang joining this
+  // thread: sockets are sent to with MSG_DONTWAIT, and pipes and devices,
+  // which may be blocking and shared with their owner, are polled for room
+  // and then given at most PIPE_BUF bytes, which a writable pipe takes at
+  // once.
+  while (remaining > 0) {
+    ssize_t written;
+    if (socket_) {
+      msghdr message{};
+      message.msg_iov = next;
+      message.msg_iovlen = static_cast<decltype(message.msg_iovlen)>(remaining);
+      written = sendmsg(fd_, &message, MSG_NOSIGNAL | MSG_DONTWAIT);
+    } else if (regularFile_) {
+      written = writev(fd_, next, remaining);
+    } else {
+      pollfd fd{fd_, POLLOUT, 0};
+      int ready = poll(&fd, 1, 100);
+      if (ready < 0 && errno != EINTR) {
+        Fail(std::string("poll failed: ") + std::strerror(errno));
+        return false;
+      }
+      if (ready <= 0) {
+        if (stopping_.load(std::memory_order_acquire)) {
+          return false;
+        }
+        continue;
+      }
+      iovec chunk[2];
+      int count = 0;
+      std::size_t budget = PIPE_BUF;
+      for (; count < remaining && budget > 0; ++count) {
+        chunk[count].iov_base = next[count].iov_base;
+        chunk[count].iov_len = std::min(next[count].iov_len, budget);
+        budget -= chunk[count].iov_len;
+      }
+      written = writev(fd_, chunk, count);
+    }
+    if (written < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      if (errno == EAGAIN || errno == EWOULDBLOCK) {
+        // Wait for room, checking now and then whether Close() gave up.
+        if (stopping_.load(std::memory_order_acquire)) {
+          return false;
+        }
+        pollfd fd{fd_, POLLOUT, 0};
+        poll(&fd, 1, 100);
+        continue;
+      }
+      Fail(std::string("write failed: ") + std::strerror(errno));
+      return false;
+    }
+    while (remaining > 0 && static_cast<std::size_t>(written) >= next->iov_len) {
+      written -= static_cast<ssize_t>(next->iov_len);
+      ++next;
+      --remaining;
+    }
+    if (remaining > 0) {
+      next->iov_base = static_cast<uint8_t*>(next->iov_base) + written;
+      next->iov_len -= static_cast<std::size_t>(written);
+    }
+  }
+  return true;
+#endif
+}
+
+} // namespace inputhook
@@ -0,0 +1,74 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "event.h"
+#include "event_stream.h"
+
+namespace inputhook {
+
+struct FrameWriterStats {
+  uint64_t frames = 0;
+  uint64_t events = 0;
+  uint64_t bytes = 0;
+  uint64_t coalesced = 0;
+  uint64_t dropped = 0;
+  std::string error;
+};
+
+// Ships events to a file descriptor or Unix domain socket from a writer
+// thread of its own, so neither the hook thread nor the JS thread ever
+// blocks on the peer. Each frame is a little-endian u32 byte length followed
+// by that many bytes of kEncodedEventSize records, written with one writev().
+// Events queue in an EventStream, so a slow peer coalesces motion and drops
+// the rest rather than stalling capture.
+class FrameWriter {
+ public:
+  static constexpr std::size_t kMaxFrameEvents = 1024;
+
+  FrameWriter() = default;
+  ~FrameWriter();
+
+  FrameWriter(const FrameWriter&) = delete;
+  FrameWriter& operator=(const FrameWriter&) = delete;
+
+  // Connects to the Unix socket at `path`.
+  bool OpenPath(const std::string& path, std::size_t capacity, std::string* error);
+  // Writes to a duplicate of `fd`; the caller keeps ownership of `fd`.
+  bool OpenFd(int fd, std::size_t capacity, std::string* error);
+  void Close();
+  bool IsOpen() const { return open_.load(std::memory_order_acquire); }
+
+  // Hook thread; never blocks on I/O.
+  void Push(const InputEvent& event);
+  FrameWriterStats Stats() const;
+
+ private:
+  bool Begin(int fd, std::size_t capacity);
+  void WriterLoop();
+  bool WriteFrame(const uint8_t* header, const uint8_t* records, std::size_t size);
+  void Fail(std::string error);
+
+  std::atomic<bool> open_{false};
+  int fd_ = -1;
+  // Sockets are written with sendmsg(); pipes and devices are polled first.
+  bool socket_ = false;
+  bool regularFile_ = false;
+  std::thread thread_;
+  EventStream queue_;
+  std::mutex wakeMutex_;
+  std::condition_variable wakeCondition_;
+  bool signaled_ = false;
+  std::atomic<bool> stopping_{false};
+  mutable std::mutex statsMutex_;
+  FrameWriterStats stats_;
+};
+
+} // namespace inputhook
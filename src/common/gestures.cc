@@ -0,0 +1,137 @@
+#include "gestures.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace inputhook {
+
+void GestureTracker::Configure(const GestureOptions& options) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  options_ = options;
+  buttons_ = {};
+}
+
+GestureOptions GestureTracker::Options() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return options_;
+}
+
+void GestureTracker::Reset() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  buttons_ = {};
+}
+
+InputEvent GestureTracker::MakeDerived(const char* type,
+                                       const InputEvent& source,
+                                       uint32_t button) const {
+  InputEvent derived;
+  derived.type = type;
+  derived.time = source.time;
+  derived.button = button;
+  derived.x = static_cast<int32_t>(std::lround(cursor_.x));
+  derived.y = static_cast<int32_t>(std::lround(cursor_.y));
+  derived.modifiers = source.modifiers;
+  return derived;
+}
+
+InputBounds GestureTracker::BoundsOf(const ButtonState& state) {
+  InputBounds bounds;
+  bounds.left = static_cast<int32_t>(std::lround(state.minX));
+  bounds.top = static_cast<int32_t>(std::lround(state.minY));
+  bounds.right = static_cast<int32_t>(std::lround(state.maxX));
+  bounds.bottom = static_cast<int32_t>(std::lround(state.maxY));
+  return bounds;
+}
+
+void GestureTracker::Process(InputEvent& event, std::vector<InputEvent>* derived) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (!options_.enabled) {
+    return;
+  }
+
+  cursor_.Update(event);
+
+  if (event.type == "mousemove") {
+    for (uint32_t button = 0; button < kButtonCount; ++button) {
+      ButtonState& state = buttons_[button];
+      if (!state.down) {
+        continue;
+      }
+      state.distance += std::hypot(cursor_.x - state.lastX, cursor_.y - state.lastY);
+      state.lastX = cursor_.x;
+      state.lastY = cursor_.y;
+      state.minX = std::min(state.minX, cursor_.x);
+      state.minY = std::min(state.minY, cursor_.y);
+      state.maxX = std::max(state.maxX, cursor_.x);
+      state.maxY = std::max(state.maxY, cursor_.y);
+      if (!state.dragging &&
+          std::hypot(cursor_.x - state.downX, cursor_.y - state.downY) >= options_.dragThreshold) {
+        state.dragging = true;
+        state.clicks = 0;
+        state.lastClickTime = 0.0;
+        if (derived) {
+          InputEvent dragStart = MakeDerived("dragstart", event, button);
+          dragStart.x = static_cast<int32_t>(std::lround(state.downX));
+          dragStart.y = static_cast<int32_t>(std::lround(state.downY));
+          dragStart.bounds = BoundsOf(state);
+          derived->push_back(std::move(dragStart));
+        }
+      }
+    }
+    return;
+  }
+
+  if (!event.button || *event.button >= kButtonCount) {
+    return;
+  }
+  uint32_t button = *event.button;
+  ButtonState& state = buttons_[button];
+
+  if (event.type == "mousedown") {
+    bool repeated = state.clicks > 0 &&
+                    event.time - state.lastClickTime <= options_.multiClickIntervalMs &&
+                    std::hypot(cursor_.x - state.lastClickX, cursor_.y - state.lastClickY) <=
+                        options_.multiClickDistance;
+    state.clicks = repeated ? state.clicks + 1 : 1;
+    state.lastClickTime = event.time;
+    state.lastClickX = cursor_.x;
+    state.lastClickY = cursor_.y;
+    state.down = true;
+    state.dragging = false;
+    state.downTime = event.time;
+    state.downX = state.lastX = state.minX = state.maxX = cursor_.x;
+    state.downY = state.lastY = state.minY = state.maxY = cursor_.y;
+    state.distance = 0.0;
+    event.clicks = state.clicks;
+    return;
+  }
+
+  if (event.type != "mouseup" || !state.down) {
+    return;
+  }
+
+  state.down = false;
+  state.distance += std::hypot(cursor_.x - state.lastX, cursor_.y - state.lastY);
+  if (!derived) {
+    state.dragging = false;
+    return;
+  }
+
+  if (state.dragging) {
+    state.dragging = false;
+    InputEvent dragEnd = MakeDerived("dragend", event, button);
+    dragEnd.deltaX = static_cast<int32_t>(std::lround(cursor_.x - state.downX));
+    dragEnd.deltaY = static_cast<int32_t>(std::lround(cursor_.y - state.downY));
+    dragEnd.distance = state.distance;
+    dragEnd.duration = event.time - state.downTime;
+    dragEnd.bounds = BoundsOf(state);
+    derived->push_back(std::move(dragEnd));
+    return;
+  }
+
+  InputEvent click = MakeDerived("click", event, button);
+  click.clicks = state.clicks;
+  derived->push_back(std::move(click));
+}
+
+} // namespace inputhook
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+#include "cursor.h"
+#include "event.h"
+
+namespace inputhook {
+
+struct GestureOptions {
+  bool enabled = false;
+  double multiClickIntervalMs = 500.0;
+  double multiClickDistance = 4.0;
+  double dragThreshold = 4.0;
+};
+
+// Derives click counts and drag sessions from the raw button and motion
+// stream. mousedown events are annotated with `clicks`; "click", "dragstart"
+// and "dragend" events are synthesized into `derived`.
+class GestureTracker {
+ public:
+  void Configure(const GestureOptions& options);
+  GestureOptions Options() const;
+  void Reset();
+
+  void Process(InputEvent& event, std::vector<InputEvent>* derived);
+
+ private:
+  static constexpr std::size_t kButtonCount = 8;
+
+  struct ButtonState {
+    bool down = false;
+    bool dragging = false;
+    double downTime = 0.0;
+    double downX = 0.0;
+    double downY = 0.0;
+    double lastX = 0.0;
+    double lastY = 0.0;
+    double minX = 0.0;
+    double minY = 0.0;
+    double maxX = 0.0;
+    double maxY = 0.0;
+    double distance = 0.0;
+    uint32_t clicks = 0;
+    double lastClickTime = 0.0;
+    double lastClickX = 0.0;
+    double lastClickY = 0.0;
+  };
+
+  InputEvent MakeDerived(const char* type, const InputEvent& source, uint32_t button) const;
+  static InputBounds BoundsOf(const ButtonState& state);
+
+  mutable std::mutex mutex_;
+  GestureOptions options_;
+  std::array<ButtonState, kButtonCount> buttons_{};
+  CursorTracker cursor_;
+};
+
+} // namespace inputhook
@@ -0,0 +1,96 @@
+#include "heatmap.h"
+
+#include <algorithm>
+
+namespace inputhook {
+
+void HeatmapAggregator::Configure(const HeatmapOptions& options) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  options_ = options;
+  options_.columns = std::max<uint32_t>(1, options_.columns);
+  options_.rows = std::max<uint32_t>(1, options_.rows);
+  options_.width = std::max<uint32_t>(1, options_.width);
+  options_.height = std::max<uint32_t>(1, options_.height);
+  std::size_t cells = static_cast<std::size_t>(options_.columns) * options_.rows;
+  dwell_.assign(cells, 0.0);
+  clicks_.assign(cells, 0);
+  cursor_ = CursorTracker{};
+  cursor_.width = options_.width;
+  cursor_.height = options_.height;
+  lastTime_ = 0.0;
+  firstTime_ = 0.0;
+}
+
+HeatmapOptions HeatmapAggregator::Options() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return options_;
+}
+
+void HeatmapAggregator::Clear() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  std::fill(dwell_.begin(), dwell_.end(), 0.0);
+  std::fill(clicks_.begin(), clicks_.end(), 0);
+  lastTime_ = 0.0;
+  firstTime_ = 0.0;
+}
+
+HeatmapSnapshot HeatmapAggregator::Snapshot(bool reset) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  HeatmapSnapshot snapshot;
+  snapshot.columns = options_.columns;
+  snapshot.rows = options_.rows;
+  snapshot.durationMs = lastTime_ > firstTime_ ? lastTime_ - firstTime_ : 0.0;
+  snapshot.dwell = dwell_;
+  snapshot.clicks = clicks_;
+  if (reset) {
+    std::fill(dwell_.begin(), dwell_.end(), 0.0);
+    std::fill(clicks_.begin(), clicks_.end(), 0);
+    firstTime_ = lastTime_;
+  }
+  return snapshot;
+}
+
+std::size_t HeatmapAggregator::CellFor(double x, double y) const {
+  double clampedX = std::clamp(x, 0.0, static_cast<double>(options_.width - 1));
+  double clampedY = std::clamp(y, 0.0, static_cast<double>(options_.height - 1));
+  auto column = static_cast<std::size_t>(clampedX * options_.columns / options_.width);
+  auto row = static_cast<std::size_t>(clampedY * options_.rows / options_.height);
+  return row * options_.columns + column;
+}
+
+void HeatmapAggregator::CreditDwell(double now) {
+  if (lastTime_ > 0.0 && cursor_.known) {
+    double elapsed = now - lastTime_;
+    if (elapsed > 0.0 && elapsed <= options_.maxDwellMs) {
+      dwell_[CellFor(cursor_.x, cursor_.y)] += elapsed;
+    }
+  }
+  if (firstTime_ == 0.0) {
+    firstTime_ = now;
+  }
+  lastTime_ = now;
+}
+
+void HeatmapAggregator::Process(const InputEvent& event) {
+  bool pointerEvent = event.type == "mousemove" || event.type == "mousedown" ||
+                      event.type == "mouseup" || event.type == "wheel";
+  if (!pointerEvent) {
+    return;
+  }
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (!options_.enabled) {
+    return;
+  }
+
+  // The time since the previous pointer event was spent at the previous
+  // position, so credit it before moving the cursor.
+  CreditDwell(event.time);
+  cursor_.Update(event);
+
+  if (event.type == "mousedown" && cursor_.known) {
+    ++clicks_[CellFor(cursor_.x, cursor_.y)];
+  }
+}
+
+} // namespace inputhook
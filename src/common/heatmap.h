@@ -0,0 +1,55 @@
+#pragma once
+
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+#include "cursor.h"
+#include "event.h"
+
+namespace inputhook {
+
+struct HeatmapOptions {
+  bool enabled = false;
+  uint32_t columns = 64;
+  uint32_t rows = 36;
+  uint32_t width = 1920;
+  uint32_t height = 1080;
+  // Gaps longer than this are not credited as dwell, so an idle pointer does
+  // not swamp the grid.
+  double maxDwellMs = 5000.0;
+};
+
+struct HeatmapSnapshot {
+  uint32_t columns = 0;
+  uint32_t rows = 0;
+  double durationMs = 0.0;
+  std::vector<double> dwell;
+  std::vector<uint32_t> clicks;
+};
+
+// Bins pointer dwell time and button presses into a fixed screen grid so
+// heatmaps need O(columns * rows) memory regardless of how long it runs.
+class HeatmapAggregator {
+ public:
+  void Configure(const HeatmapOptions& options);
+  HeatmapOptions Options() const;
+  void Clear();
+  HeatmapSnapshot Snapshot(bool reset);
+
+  void Process(const InputEvent& event);
+
+ private:
+  std::size_t CellFor(double x, double y) const;
+  void CreditDwell(double now);
+
+  mutable std::mutex mutex_;
+  HeatmapOptions options_;
+  std::vector<double> dwell_;
+  std::vector<uint32_t> clicks_;
+  CursorTracker cursor_;
+  double lastTime_ = 0.0;
+  double firstTime_ = 0.0;
+};
+
+} // namespace inputhook
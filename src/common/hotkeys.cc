@@ -0,0 +1,167 @@
+#include "hotkeys.h"
+
+#include <utility>
+
+namespace inputhook {
+
+namespace {
+constexpr uint8_t kShiftBit = 1 << 0;
+constexpr uint8_t kCtrlBit = 1 << 1;
+constexpr uint8_t kAltBit = 1 << 2;
+constexpr uint8_t kMetaBit = 1 << 3;
+} // namespace
+
+bool HotkeyMatcher::IsModifierUsage(uint32_t usage) {
+  return usage >= 0xE0 && usage <= 0xE7;
+}
+
+uint8_t HotkeyMatcher::ModifierBits(const InputModifiers& modifiers) {
+  uint8_t bits = 0;
+  if (modifiers.shift) {
+    bits |= kShiftBit;
+  }
+  if (modifiers.ctrl) {
+    bits |= kCtrlBit;
+  }
+  if (modifiers.alt) {
+    bits |= kAltBit;
+  }
+  if (modifiers.meta) {
+    bits |= kMetaBit;
+  }
+  return bits;
+}
+
+bool HotkeyMatcher::SetHotkeys(const std::vector<HotkeyDefinition>& definitions,
+                               std::string* error) {
+  std::vector<CompiledHotkey> compiled;
+  UsageSet watched;
+  compiled.reserve(definitions.size());
+
+  for (const auto& definition : definitions) {
+    if (definition.sequence.empty()) {
+      if (error) {
+        *error = "hotkey '" + definition.id + "' has no keys";
+      }
+      return false;
+    }
+
+    CompiledHotkey hotkey;
+    hotkey.id = definition.id;
+    hotkey.sequenceTimeoutMs = definition.sequenceTimeoutMs;
+    for (const auto& chord : definition.sequence) {
+      CompiledChord step;
+      step.modifiers = ModifierBits(chord.modifiers);
+      for (uint32_t usage : chord.usages) {
+        if (usage == 0 || usage >= kUsageCount || IsModifierUsage(usage)) {
+          if (error) {
+            *error = "hotkey '" + definition.id + "' contains an invalid key usage " +
+                     std::to_string(usage);
+          }
+          return false;
+        }
+        step.keys.set(usage);
+      }
+      if (step.keys.none()) {
+        if (error) {
+          *error = "hotkey '" + definition.id + "' needs a non-modifier key in every chord";
+        }
+        return false;
+      }
+      watched |= step.keys;
+      hotkey.steps.push_back(step);
+    }
+    compiled.push_back(std::move(hotkey));
+  }
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  hotkeys_ = std::move(compiled);
+  watched_ = watched;
+  pressed_.reset();
+  return true;
+}
+
+void HotkeyMatcher::Clear() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  hotkeys_.clear();
+  watched_.reset();
+  pressed_.reset();
+}
+
+void HotkeyMatcher::Reset() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  pressed_.reset();
+  for (auto& hotkey : hotkeys_) {
+    hotkey.progress = 0;
+  }
+}
+
+bool HotkeyMatcher::Empty() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return hotkeys_.empty();
+}
+
+void HotkeyMatcher::Process(const InputEvent& event, std::vector<HotkeyMatch>* matches) {
+  if (!event.hidUsage) {
+    return;
+  }
+  uint32_t usage = *event.hidUsage;
+  if (usage >= kUsageCount || IsModifierUsage(usage)) {
+    return;
+  }
+
+  bool keyDown = event.type == "keydown";
+  if (!keyDown && event.type != "keyup") {
+    return;
+  }
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (!keyDown) {
+    pressed_.reset(usage);
+    return;
+  }
+
+  // Auto-repeat keydowns do not form a new stroke.
+  if (pressed_.test(usage)) {
+    return;
+  }
+  pressed_.set(usage);
+
+  // A stroke on a key no hotkey uses cannot advance anything; it only breaks
+  // pending sequences.
+  if (!watched_.test(usage)) {
+    for (auto& hotkey : hotkeys_) {
+      hotkey.progress = 0;
+    }
+    return;
+  }
+
+  uint8_t modifiers = ModifierBits(event.modifiers);
+  for (auto& hotkey : hotkeys_) {
+    if (hotkey.progress > 0 &&
+        event.time - hotkey.lastStepTime > hotkey.sequenceTimeoutMs) {
+      hotkey.progress = 0;
+    }
+
+    auto matchesStep = [&](std::size_t index) {
+      const CompiledChord& step = hotkey.steps[index];
+      return step.modifiers == modifiers && step.keys == pressed_;
+    };
+
+    if (matchesStep(hotkey.progress)) {
+      ++hotkey.progress;
+    } else {
+      hotkey.progress = matchesStep(0) ? 1 : 0;
+    }
+    hotkey.lastStepTime = event.time;
+
+    if (hotkey.progress == hotkey.steps.size()) {
+      hotkey.progress = 0;
+      if (matches) {
+        matches->push_back({hotkey.id, event.time});
+      }
+    }
+  }
+}
+
+} // namespace inputhook
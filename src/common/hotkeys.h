@@ -0,0 +1,74 @@
+#pragma once
+
+#include <bitset>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "event.h"
+
+namespace inputhook {
+
+// A single key combination: the modifier state plus the set of non-modifier
+// keys (HID usages) that must be held when the last key goes down.
+struct HotkeyChord {
+  InputModifiers modifiers;
+  std::vector<uint32_t> usages;
+};
+
+struct HotkeyDefinition {
+  std::string id;
+  std::vector<HotkeyChord> sequence;
+  double sequenceTimeoutMs = 1000.0;
+};
+
+struct HotkeyMatch {
+  std::string id;
+  double time = 0.0;
+};
+
+// Matches registered key combinations and chord sequences on the hook thread.
+// Chords are compiled into bitsets so each keystroke is checked with a handful
+// of word compares, and only completed matches leave the matcher.
+class HotkeyMatcher {
+ public:
+  static constexpr std::size_t kUsageCount = 256;
+  using UsageSet = std::bitset<kUsageCount>;
+
+  static bool IsModifierUsage(uint32_t usage);
+
+  // Replaces the registered hotkeys. Returns false and fills `error` when a
+  // definition cannot be compiled.
+  bool SetHotkeys(const std::vector<HotkeyDefinition>& definitions, std::string* error);
+  void Clear();
+  void Reset();
+  bool Empty() const;
+
+  // Feeds a single event; appends any completed hotkeys to `matches`.
+  void Process(const InputEvent& event, std::vector<HotkeyMatch>* matches);
+
+ private:
+  struct CompiledChord {
+    uint8_t modifiers = 0;
+    UsageSet keys;
+  };
+
+  struct CompiledHotkey {
+    std::string id;
+    std::vector<CompiledChord> steps;
+    double sequenceTimeoutMs = 0.0;
+    std::size_t progress = 0;
+    double lastStepTime = 0.0;
+  };
+
+  static uint8_t ModifierBits(const InputModifiers& modifiers);
+
+  mutable std::mutex mutex_;
+  std::vector<CompiledHotkey> hotkeys_;
+  UsageSet watched_;
+  UsageSet pressed_;
+};
+
+} // namespace inputhook
@@ -0,0 +1,12 @@
+#pragma once
+
+#include <string>
+
+namespace inputhook {
+
+// Milliseconds since the last user input in the session, as tracked by the
+// OS itself, so no hook has to run. Returns false with a reason when the
+// platform cannot tell (e.g. no X server or no MIT-SCREEN-SAVER extension).
+bool QueryIdleTime(double* idleMs, std::string* error);
+
+} // namespace inputhook
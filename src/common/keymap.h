@@ -0,0 +1,152 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+namespace inputhook {
+namespace keymap {
+
+// Canonical key identifiers are USB HID usage IDs from the Keyboard/Keypad
+// page (0x07). They describe the physical key position, so the same key
+// yields the same value on every backend regardless of layout. 0 means the
+// native code has no mapping.
+constexpr uint16_t kUsageNone = 0x00;
+
+struct KeyMapping {
+  uint16_t native;
+  uint16_t usage;
+};
+
+// Expands a sparse list of mappings into a dense lookup table at compile time.
+template <std::size_t Size, std::size_t Count>
+constexpr std::array<uint16_t, Size> BuildTable(const KeyMapping (&mappings)[Count]) {
+  std::array<uint16_t, Size> table{};
+  for (std::size_t i = 0; i < Count; ++i) {
+    if (mappings[i].native < Size) {
+      table[mappings[i].native] = mappings[i].usage;
+    }
+  }
+  return table;
+}
+
+// Linux input-event-codes.h KEY_* values. X servers using the evdev/libinput
+// drivers report these offset by 8 as X keycodes.
+inline constexpr KeyMapping kEvdevMappings[] = {
+    {1, 0x29},    {2, 0x1E},    {3, 0x1F},    {4, 0x20},    {5, 0x21},
+    {6, 0x22},    {7, 0x23},    {8, 0x24},    {9, 0x25},    {10, 0x26},
+    {11, 0x27},   {12, 0x2D},   {13, 0x2E},   {14, 0x2A},   {15, 0x2B},
+    {16, 0x14},   {17, 0x1A},   {18, 0x08},   {19, 0x15},   {20, 0x17},
+    {21, 0x1C},   {22, 0x18},   {23, 0x0C},   {24, 0x12},   {25, 0x13},
+    {26, 0x2F},   {27, 0x30},   {28, 0x28},   {29, 0xE0},   {30, 0x04},
+    {31, 0x16},   {32, 0x07},   {33, 0x09},   {34, 0x0A},   {35, 0x0B},
+    {36, 0x0D},   {37, 0x0E},   {38, 0x0F},   {39, 0x33},   {40, 0x34},
+    {41, 0x35},   {42, 0xE1},   {43, 0x31},   {44, 0x1D},   {45, 0x1B},
+    {46, 0x06},   {47, 0x19},   {48, 0x05},   {49, 0x11},   {50, 0x10},
+    {51, 0x36},   {52, 0x37},   {53, 0x38},   {54, 0xE5},   {55, 0x55},
+    {56, 0xE2},   {57, 0x2C},   {58, 0x39},   {59, 0x3A},   {60, 0x3B},
+    {61, 0x3C},   {62, 0x3D},   {63, 0x3E},   {64, 0x3F},   {65, 0x40},
+    {66, 0x41},   {67, 0x42},   {68, 0x43},   {69, 0x53},   {70, 0x47},
+    {71, 0x5F},   {72, 0x60},   {73, 0x61},   {74, 0x56},   {75, 0x5C},
+    {76, 0x5D},   {77, 0x5E},   {78, 0x57},   {79, 0x59},   {80, 0x5A},
+    {81, 0x5B},   {82, 0x62},   {83, 0x63},   {85, 0x94},   {86, 0x64},
+    {87, 0x44},   {88, 0x45},   {89, 0x87},   {90, 0x92},   {91, 0x93},
+    {92, 0x8A},   {93, 0x88},   {94, 0x8B},   {95, 0x8C},   {96, 0x58},
+    {97, 0xE4},   {98, 0x54},   {99, 0x46},   {100, 0xE6},  {102, 0x4A},
+    {103, 0x52},  {104, 0x4B},  {105, 0x50},  {106, 0x4F},  {107, 0x4D},
+    {108, 0x51},  {109, 0x4E},  {110, 0x49},  {111, 0x4C},  {113, 0x7F},
+    {114, 0x81},  {115, 0x80},  {116, 0x66},  {117, 0x67},  {119, 0x48},
+    {121, 0x85},  {122, 0x90},  {123, 0x91},  {124, 0x89},  {125, 0xE3},
+    {126, 0xE7},  {127, 0x65},  {183, 0x68},  {184, 0x69},  {185, 0x6A},
+    {186, 0x6B},  {187, 0x6C},  {188, 0x6D},  {189, 0x6E},  {190, 0x6F},
+    {191, 0x70},  {192, 0x71},  {193, 0x72},  {194, 0x73},
+};
+
+// PC/AT set-1 scan codes as reported by Windows low-level hooks. Codes sent
+// with the E0 prefix (LLKHF_EXTENDED) are stored at native | 0x100. Windows
+// reports Pause as a plain 0x45 and NumLock as an extended 0x45.
+inline constexpr KeyMapping kScancodeMappings[] = {
+    {0x01, 0x29},  {0x02, 0x1E},  {0x03, 0x1F},  {0x04, 0x20},  {0x05, 0x21},
+    {0x06, 0x22},  {0x07, 0x23},  {0x08, 0x24},  {0x09, 0x25},  {0x0A, 0x26},
+    {0x0B, 0x27},  {0x0C, 0x2D},  {0x0D, 0x2E},  {0x0E, 0x2A},  {0x0F, 0x2B},
+    {0x10, 0x14},  {0x11, 0x1A},  {0x12, 0x08},  {0x13, 0x15},  {0x14, 0x17},
+    {0x15, 0x1C},  {0x16, 0x18},  {0x17, 0x0C},  {0x18, 0x12},  {0x19, 0x13},
+    {0x1A, 0x2F},  {0x1B, 0x30},  {0x1C, 0x28},  {0x1D, 0xE0},  {0x1E, 0x04},
+    {0x1F, 0x16},  {0x20, 0x07},  {0x21, 0x09},  {0x22, 0x0A},  {0x23, 0x0B},
+    {0x24, 0x0D},  {0x25, 0x0E},  {0x26, 0x0F},  {0x27, 0x33},  {0x28, 0x34},
+    {0x29, 0x35},  {0x2A, 0xE1},  {0x2B, 0x31},  {0x2C, 0x1D},  {0x2D, 0x1B},
+    {0x2E, 0x06},  {0x2F, 0x19},  {0x30, 0x05},  {0x31, 0x11},  {0x32, 0x10},
+    {0x33, 0x36},  {0x34, 0x37},  {0x35, 0x38},  {0x36, 0xE5},  {0x37, 0x55},
+    {0x38, 0xE2},  {0x39, 0x2C},  {0x3A, 0x39},  {0x3B, 0x3A},  {0x3C, 0x3B},
+    {0x3D, 0x3C},  {0x3E, 0x3D},  {0x3F, 0x3E},  {0x40, 0x3F},  {0x41, 0x40},
+    {0x42, 0x41},  {0x43, 0x42},  {0x44, 0x43},  {0x45, 0x48},  {0x46, 0x47},
+    {0x47, 0x5F},  {0x48, 0x60},  {0x49, 0x61},  {0x4A, 0x56},  {0x4B, 0x5C},
+    {0x4C, 0x5D},  {0x4D, 0x5E},  {0x4E, 0x57},  {0x4F, 0x59},  {0x50, 0x5A},
+    {0x51, 0x5B},  {0x52, 0x62},  {0x53, 0x63},  {0x54, 0x46},  {0x56, 0x64},
+    {0x57, 0x44},  {0x58, 0x45},  {0x59, 0x67},  {0x64, 0x68},  {0x65, 0x69},
+    {0x66, 0x6A},  {0x67, 0x6B},  {0x68, 0x6C},  {0x69, 0x6D},  {0x6A, 0x6E},
+    {0x6B, 0x6F},  {0x6C, 0x70},  {0x6D, 0x71},  {0x6E, 0x72},  {0x70, 0x88},
+    {0x73, 0x87},  {0x76, 0x73},  {0x79, 0x8A},  {0x7B, 0x8B},  {0x7D, 0x89},
+    {0x7E, 0x85},
+    {0x11C, 0x58}, {0x11D, 0xE4}, {0x120, 0x7F}, {0x12E, 0x81}, {0x130, 0x80},
+    {0x135, 0x54}, {0x137, 0x46}, {0x138, 0xE6}, {0x145, 0x53}, {0x147, 0x4A},
+    {0x148, 0x52}, {0x149, 0x4B}, {0x14B, 0x50}, {0x14D, 0x4F}, {0x14F, 0x4D},
+    {0x150, 0x51}, {0x151, 0x4E}, {0x152, 0x49}, {0x153, 0x4C}, {0x15B, 0xE3},
+    {0x15C, 0xE7}, {0x15D, 0x65}, {0x15E, 0x66},
+};
+
+// macOS virtual key codes (kVK_* from HIToolbox/Events.h).
+inline constexpr KeyMapping kMacMappings[] = {
+    {0x00, 0x04},  {0x01, 0x16},  {0x02, 0x07},  {0x03, 0x09},  {0x04, 0x0B},
+    {0x05, 0x0A},  {0x06, 0x1D},  {0x07, 0x1B},  {0x08, 0x06},  {0x09, 0x19},
+    {0x0A, 0x64},  {0x0B, 0x05},  {0x0C, 0x14},  {0x0D, 0x1A},  {0x0E, 0x08},
+    {0x0F, 0x15},  {0x10, 0x1C},  {0x11, 0x17},  {0x12, 0x1E},  {0x13, 0x1F},
+    {0x14, 0x20},  {0x15, 0x21},  {0x16, 0x23},  {0x17, 0x22},  {0x18, 0x2E},
+    {0x19, 0x26},  {0x1A, 0x24},  {0x1B, 0x2D},  {0x1C, 0x25},  {0x1D, 0x27},
+    {0x1E, 0x30},  {0x1F, 0x12},  {0x20, 0x18},  {0x21, 0x2F},  {0x22, 0x0C},
+    {0x23, 0x13},  {0x24, 0x28},  {0x25, 0x0F},  {0x26, 0x0D},  {0x27, 0x34},
+    {0x28, 0x0E},  {0x29, 0x33},  {0x2A, 0x31},  {0x2B, 0x36},  {0x2C, 0x38},
+    {0x2D, 0x11},  {0x2E, 0x10},  {0x2F, 0x37},  {0x30, 0x2B},  {0x31, 0x2C},
+    {0x32, 0x35},  {0x33, 0x2A},  {0x35, 0x29},  {0x36, 0xE7},  {0x37, 0xE3},
+    {0x38, 0xE1},  {0x39, 0x39},  {0x3A, 0xE2},  {0x3B, 0xE0},  {0x3C, 0xE5},
+    {0x3D, 0xE6},  {0x3E, 0xE4},  {0x40, 0x6C},  {0x41, 0x63},  {0x43, 0x55},
+    {0x45, 0x57},  {0x47, 0x53},  {0x48, 0x80},  {0x49, 0x81},  {0x4A, 0x7F},
+    {0x4B, 0x54},  {0x4C, 0x58},  {0x4E, 0x56},  {0x4F, 0x6D},  {0x50, 0x6E},
+    {0x51, 0x67},  {0x52, 0x62},  {0x53, 0x59},  {0x54, 0x5A},  {0x55, 0x5B},
+    {0x56, 0x5C},  {0x57, 0x5D},  {0x58, 0x5E},  {0x59, 0x5F},  {0x5A, 0x6F},
+    {0x5B, 0x60},  {0x5C, 0x61},  {0x5D, 0x89},  {0x5E, 0x87},  {0x5F, 0x85},
+    {0x60, 0x3E},  {0x61, 0x3F},  {0x62, 0x40},  {0x63, 0x3C},  {0x64, 0x41},
+    {0x65, 0x42},  {0x66, 0x91},  {0x67, 0x44},  {0x68, 0x90},  {0x69, 0x68},
+    {0x6A, 0x6B},  {0x6B, 0x69},  {0x6D, 0x43},  {0x6E, 0x65},  {0x6F, 0x45},
+    {0x71, 0x6A},  {0x72, 0x49},  {0x73, 0x4A},  {0x74, 0x4B},  {0x75, 0x4C},
+    {0x76, 0x3D},  {0x77, 0x4D},  {0x78, 0x3B},  {0x79, 0x4E},  {0x7A, 0x3A},
+    {0x7B, 0x50},  {0x7C, 0x4F},  {0x7D, 0x51},  {0x7E, 0x52},
+};
+
+inline constexpr auto kEvdevToUsage = BuildTable<256>(kEvdevMappings);
+inline constexpr auto kScancodeToUsage = BuildTable<512>(kScancodeMappings);
+inline constexpr auto kMacToUsage = BuildTable<128>(kMacMappings);
+
+static_assert(kEvdevToUsage[30] == 0x04, "KEY_A must map to usage A");
+static_assert(kScancodeToUsage[0x148] == 0x52, "E0 48 must map to usage Up");
+static_assert(kMacToUsage[0x7E] == 0x52, "kVK_UpArrow must map to usage Up");
+
+constexpr uint16_t UsageFromEvdev(uint32_t code) {
+  return code < kEvdevToUsage.size() ? kEvdevToUsage[code] : kUsageNone;
+}
+
+constexpr uint16_t UsageFromXKeycode(uint32_t keycode) {
+  return keycode >= 8 ? UsageFromEvdev(keycode - 8) : kUsageNone;
+}
+
+constexpr uint16_t UsageFromScancode(uint32_t scancode, bool extended) {
+  uint32_t index = scancode | (extended ? 0x100u : 0u);
+  return index < kScancodeToUsage.size() ? kScancodeToUsage[index] : kUsageNone;
+}
+
+constexpr uint16_t UsageFromMacKeycode(uint32_t keycode) {
+  return keycode < kMacToUsage.size() ? kMacToUsage[keycode] : kUsageNone;
+}
+
+} // namespace keymap
+} // namespace inputhook
@@ -0,0 +1,168 @@
+#include "kinematics.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace inputhook {
+
+void MouseKinematics::Configure(const MouseStatsOptions& options) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  options_ = options;
+  options_.bucketCount = std::max<uint32_t>(1, options_.bucketCount);
+  positionKnown_ = false;
+  inEpisode_ = false;
+  lastSpeed_.reset();
+  ResetPeriod(0.0);
+}
+
+MouseStatsOptions MouseKinematics::Options() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return options_;
+}
+
+void MouseKinematics::Clear() {
+  Configure(Options());
+}
+
+void MouseKinematics::ResetPeriod(double start) {
+  periodStart_ = start;
+  distance_ = 0.0;
+  moveTimeMs_ = 0.0;
+  timedDistance_ = 0.0;
+  episodes_ = 0;
+  longestEpisodeMs_ = 0.0;
+  maxSpeed_ = 0.0;
+  accelSum_ = 0.0;
+  accelCount_ = 0;
+  maxAccel_ = 0.0;
+  speedHistogram_.assign(options_.bucketCount, 0);
+  accelHistogram_.assign(options_.bucketCount, 0);
+}
+
+void MouseKinematics::Bin(std::vector<uint32_t>& histogram, double value, double bucket) {
+  auto index = bucket > 0.0 ? static_cast<std::size_t>(value / bucket) : 0;
+  ++histogram[std::min(index, histogram.size() - 1)];
+}
+
+void MouseKinematics::CloseEpisode() {
+  if (!inEpisode_) {
+    return;
+  }
+  inEpisode_ = false;
+  lastSpeed_.reset();
+  pendingDistance_ = 0.0;
+  longestEpisodeMs_ = std::max(longestEpisodeMs_, lastMotion_ - episodeStart_);
+}
+
+void MouseKinematics::AddSample(double time) {
+  double elapsed = time - lastSample_;
+  double speed = pendingDistance_ / elapsed * 1000.0;
+  Bin(speedHistogram_, speed, options_.speedBucket);
+  maxSpeed_ = std::max(maxSpeed_, speed);
+  if (lastSpeed_) {
+    double accel = std::fabs(speed - *lastSpeed_) / elapsed * 1000.0;
+    Bin(accelHistogram_, accel, options_.accelBucket);
+    accelSum_ += accel;
+    ++accelCount_;
+    maxAccel_ = std::max(maxAccel_, accel);
+  }
+  lastSpeed_ = speed;
+  lastSample_ = time;
+  pendingDistance_ = 0.0;
+}
+
+MouseStatsSnapshot MouseKinematics::BuildSnapshot(double now) const {
+  MouseStatsSnapshot snapshot;
+  snapshot.start = periodStart_;
+  snapshot.end = now;
+  snapshot.distance = distance_;
+  snapshot.moveTimeMs = moveTimeMs_;
+  snapshot.episodes = episodes_;
+  snapshot.longestEpisodeMs = longestEpisodeMs_;
+  if (inEpisode_) {
+    snapshot.longestEpisodeMs = std::max(longestEpisodeMs_, lastMotion_ - episodeStart_);
+  }
+  if (moveTimeMs_ > 0.0) {
+    snapshot.meanSpeed = timedDistance_ / moveTimeMs_ * 1000.0;
+  }
+  snapshot.maxSpeed = maxSpeed_;
+  snapshot.speedBucket = options_.speedBucket;
+  snapshot.speedHistogram = speedHistogram_;
+  if (accelCount_ > 0) {
+    snapshot.meanAccel = accelSum_ / accelCount_;
+  }
+  snapshot.maxAccel = maxAccel_;
+  snapshot.accelBucket = options_.accelBucket;
+  snapshot.accelHistogram = accelHistogram_;
+  return snapshot;
+}
+
+MouseStatsSnapshot MouseKinematics::Snapshot(double now, bool reset) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  MouseStatsSnapshot snapshot = BuildSnapshot(now);
+  if (reset) {
+    ResetPeriod(now);
+  }
+  return snapshot;
+}
+
+void MouseKinematics::Process(const InputEvent& event,
+                              std::optional<MouseStatsSnapshot>* summary) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (!options_.enabled) {
+    return;
+  }
+
+  if (periodStart_ == 0.0) {
+    periodStart_ = event.time;
+  }
+  if (inEpisode_ && event.time - lastMotion_ > options_.episodeGapMs) {
+    CloseEpisode();
+  }
+
+  if (event.type == "mousemove") {
+    double step = 0.0;
+    if (event.deltaX || event.deltaY) {
+      // Deltas win over the position: raw X11 motion carries a pointer
+      // position sampled once per batch, which repeats across the batch.
+      step = std::hypot(event.deltaX.value_or(0), event.deltaY.value_or(0));
+      lastX_ += event.deltaX.value_or(0);
+      lastY_ += event.deltaY.value_or(0);
+    } else if (event.x && event.y) {
+      if (positionKnown_) {
+        step = std::hypot(*event.x - lastX_, *event.y - lastY_);
+      }
+    }
+    if (event.x && event.y) {
+      lastX_ = *event.x;
+      lastY_ = *event.y;
+      positionKnown_ = true;
+    }
+
+    if (step > 0.0) {
+      distance_ += step;
+      if (!inEpisode_) {
+        // The first step of an episode has no elapsed time to divide by.
+        inEpisode_ = true;
+        ++episodes_;
+        episodeStart_ = lastSample_ = event.time;
+      } else {
+        moveTimeMs_ += event.time - lastMotion_;
+        timedDistance_ += step;
+        pendingDistance_ += step;
+        if (event.time - lastSample_ >= options_.sampleMs) {
+          AddSample(event.time);
+        }
+      }
+      lastMotion_ = event.time;
+    }
+  }
+
+  if (summary && options_.intervalMs > 0.0 &&
+      event.time - periodStart_ >= options_.intervalMs) {
+    *summary = BuildSnapshot(event.time);
+    ResetPeriod(event.time);
+  }
+}
+
+} // namespace inputhook
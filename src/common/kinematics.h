@@ -0,0 +1,94 @@
+#pragma once
+
+#include <cstdint>
+#include <mutex>
+#include <optional>
+#include <vector>
+
+#include "event.h"
+
+namespace inputhook {
+
+struct MouseStatsOptions {
+  bool enabled = false;
+  // Period of the pushed summaries; 0 leaves only the pull API.
+  double intervalMs = 10000.0;
+  // Motion separated by a longer gap starts a new movement episode.
+  double episodeGapMs = 300.0;
+  // Displacement is integrated over at least this long before a speed
+  // sample is taken, which smooths out 1000 Hz jitter.
+  double sampleMs = 8.0;
+  double speedBucket = 250.0;  // px/s
+  double accelBucket = 5000.0; // px/s^2
+  uint32_t bucketCount = 32;
+};
+
+struct MouseStatsSnapshot {
+  double start = 0.0;
+  double end = 0.0;
+  double distance = 0.0;
+  double moveTimeMs = 0.0;
+  uint32_t episodes = 0;
+  double longestEpisodeMs = 0.0;
+  double meanSpeed = 0.0;
+  double maxSpeed = 0.0;
+  double speedBucket = 0.0;
+  std::vector<uint32_t> speedHistogram;
+  double meanAccel = 0.0;
+  double maxAccel = 0.0;
+  double accelBucket = 0.0;
+  std::vector<uint32_t> accelHistogram;
+};
+
+// Pointer travel, speed/acceleration distributions and movement episodes.
+// Motion is measured from its deltas when it carries any (raw X11 motion, in
+// device units) and from successive screen positions otherwise.
+class MouseKinematics {
+ public:
+  void Configure(const MouseStatsOptions& options);
+  MouseStatsOptions Options() const;
+  void Clear();
+  MouseStatsSnapshot Snapshot(double now, bool reset);
+
+  // Returns a completed period summary through `summary` when intervalMs
+  // has elapsed since the period started.
+  void Process(const InputEvent& event, std::optional<MouseStatsSnapshot>* summary);
+
+ private:
+  void ResetPeriod(double start);
+  void CloseEpisode();
+  void AddSample(double time);
+  MouseStatsSnapshot BuildSnapshot(double now) const;
+  static void Bin(std::vector<uint32_t>& histogram, double value, double bucket);
+
+  mutable std::mutex mutex_;
+  MouseStatsOptions options_;
+
+  // Pointer state survives period boundaries.
+  bool positionKnown_ = false;
+  double lastX_ = 0.0;
+  double lastY_ = 0.0;
+  bool inEpisode_ = false;
+  double episodeStart_ = 0.0;
+  double lastMotion_ = 0.0;
+  double lastSample_ = 0.0;
+  double pendingDistance_ = 0.0;
+  std::optional<double> lastSpeed_;
+
+  // Per-period accumulators.
+  double periodStart_ = 0.0;
+  double distance_ = 0.0;
+  double moveTimeMs_ = 0.0;
+  // Distance covered during moveTimeMs_, i.e. without each episode's first step.
+  double timedDistance_ = 0.0;
+  uint32_t episodes_ = 0;
+  double longestEpisodeMs_ = 0.0;
+  double maxSpeed_ = 0.0;
+  double accelSum_ = 0.0;
+  uint32_t accelCount_ = 0;
+  double maxAccel_ = 0.0;
+  std::vector<uint32_t> speedHistogram_;
+  std::vector<uint32_t> accelHistogram_;
+};
+
+} // namespace inputhook
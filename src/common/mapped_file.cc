@@ -0,0 +1,232 @@
+#include "mapped_file.h"
+
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace inputhook {
+
+namespace {
+
+#if defined(_WIN32)
+std::string LastErrorMessage(const char* what) {
+  return std::string(what) + " failed (error " + std::to_string(GetLastError()) + ")";
+}
+#else
+std::string ErrnoMessage(const char* what) {
+  return std::string(what) + " failed: " + std::strerror(errno);
+}
+#endif
+
+} // namespace
+
+MappedFile::~MappedFile() {
+  Close();
+}
+
+#if defined(_WIN32)
+
+bool MappedFile::IsOpen() const {
+  return file_ != nullptr;
+}
+
+bool MappedFile::Open(const std::string& path, std::string* error) {
+  Close();
+  HANDLE file = CreateFileA(path.c_str(), GENERIC_READ | GENERIC_WRITE, 0, nullptr, OPEN_ALWAYS,
+                            FILE_ATTRIBUTE_NORMAL, nullptr);
+  if (file == INVALID_HANDLE_VALUE) {
+    *error = GetLastError() == ERROR_SHARING_VIOLATION
+                 ? path + " is in use by another process"
+                 : LastErrorMessage("CreateFile");
+    return false;
+  }
+  LARGE_INTEGER size;
+  if (!GetFileSizeEx(file, &size)) {
+    *error = LastErrorMessage("GetFileSizeEx");
+    CloseHandle(file);
+    return false;
+  }
+  file_ = file;
+  size_ = static_cast<std::size_t>(size.QuadPart);
+  if (!Map(error)) {
+    Close();
+    return false;
+  }
+  return true;
+}
+
+bool MappedFile::Map(std::string* error) {
+  if (size_ == 0) {
+    return true;
+  }
+  ULARGE_INTEGER size;
+  size.QuadPart = size_;
+  mapping_ = CreateFileMappingA(static_cast<HANDLE>(file_), nullptr, PAGE_READWRITE, size.HighPart,
+                                size.LowPart, nullptr);
+  if (!mapping_) {
+    *error = LastErrorMessage("CreateFileMapping");
+    return false;
+  }
+  data_ = static_cast<unsigned char*>(
+      MapViewOfFile(static_cast<HANDLE>(mapping_), FILE_MAP_ALL_ACCESS, 0, 0, size_));
+  if (!data_) {
+    *error = LastErrorMessage("MapViewOfFile");
+    CloseHandle(static_cast<HANDLE>(mapping_));
+    mapping_ = nullptr;
+    return false;
+  }
+  return true;
+}
+
+void MappedFile::Unmap() {
+  if (data_) {
+    UnmapViewOfFile(data_);
+    data_ = nullptr;
+  }
+  if (mapping_) {
+    CloseHandle(static_cast<HANDLE>(mapping_));
+    mapping_ = nullptr;
+  }
+}
+
+bool MappedFile::Resize(std::size_t size, std::string* error) {
+  Unmap();
+  LARGE_INTEGER end;
+  end.QuadPart = static_cast<LONGLONG>(size);
+  if (!SetFilePointerEx(static_cast<HANDLE>(file_), end, nullptr, FILE_BEGIN) ||
+      !SetEndOfFile(static_cast<HANDLE>(file_))) {
+    *error = LastErrorMessage("SetEndOfFile");
+    std::string remapError;
+    Map(&remapError);
+    return false;
+  }
+  size_ = size;
+  return Map(error);
+}
+
+void MappedFile::Sync() {
+  if (data_) {
+    FlushViewOfFile(data_, 0);
+  }
+}
+
+void MappedFile::Close() {
+  Sync();
+  Unmap();
+  if (file_) {
+    CloseHandle(static_cast<HANDLE>(file_));
+    file_ = nullptr;
+  }
+  size_ = 0;
+}
+
+#else
+
+bool MappedFile::IsOpen() const {
+  return fd_ >= 0;
+}
+
+bool MappedFile::Open(const std::string& path, std::string* error) {
+  Close();
+  int fd = open(path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+  if (fd < 0) {
+    *error = ErrnoMessage(("open " + path).c_str());
+    return false;
+  }
+  if (flock(fd, LOCK_EX | LOCK_NB) != 0) {
+    *error = errno == EWOULDBLOCK ? path + " is in use by another process"
+                                  : ErrnoMessage("flock");
+    close(fd);
+    return false;
+  }
+  struct stat info;
+  if (fstat(fd, &info) != 0) {
+    *error = ErrnoMessage("fstat");
+    close(fd);
+    return false;
+  }
+  fd_ = fd;
+  size_ = static_cast<std::size_t>(info.st_size);
+  if (!Map(error)) {
+    Close();
+    return false;
+  }
+  return true;
+}
+
+bool MappedFile::Map(std::string* error) {
+  if (size_ == 0) {
+    return true;
+  }
+  void* data = mmap(nullptr, size_, PROT_READ | PROT_WRITE, MAP_SHARED, fd_, 0);
+  if (data == MAP_FAILED) {
+    *error = ErrnoMessage("mmap");
+    return false;
+  }
+  data_ = static_cast<unsigned char*>(data);
+  return true;
+}
+
+void MappedFile::Unmap() {
+  if (data_) {
+    munmap(data_, size_);
+    data_ = nullptr;
+  }
+}
+
+bool MappedFile::Resize(std::size_t size, std::string* error) {
+  // A sparse extension would only fail once a store through the mapping needs
+  // a block the disk no longer has, as SIGBUS on the hook thread.
+  if (size > size_) {
+#if defined(__APPLE__)
+    fstore_t store = {F_ALLOCATEALL, F_PEOFPOSMODE, 0, static_cast<off_t>(size - size_), 0};
+    if (fcntl(fd_, F_PREALLOCATE, &store) == -1 && errno != ENOTSUP) {
+      *error = ErrnoMessage("fcntl(F_PREALLOCATE)");
+      return false;
+    }
+#else
+    int result = posix_fallocate(fd_, static_cast<off_t>(size_), static_cast<off_t>(size - size_));
+    // Filesystems without block reservation keep the sparse fallback.
+    if (result != 0 && result != EOPNOTSUPP && result != ENOSYS) {
+      errno = result;
+      *error = ErrnoMessage("posix_fallocate");
+      return false;
+    }
+#endif
+  }
+  if (ftruncate(fd_, static_cast<off_t>(size)) != 0) {
+    *error = ErrnoMessage("ftruncate");
+    return false;
+  }
+  Unmap();
+  size_ = size;
+  return Map(error);
+}
+
+void MappedFile::Sync() {
+  if (data_) {
+    msync(data_, size_, MS_ASYNC);
+  }
+}
+
+void MappedFile::Close() {
+  Sync();
+  Unmap();
+  if (fd_ >= 0) {
+    close(fd_);
+    fd_ = -1;
+  }
+  size_ = 0;
+}
+
+#endif
+
+} // namespace inputhook
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+namespace inputhook {
+
+// A read/write shared mapping of a whole file that can grow. The file is
+// held exclusively so two processes never update the same counters.
+class MappedFile {
+ public:
+  MappedFile() = default;
+  ~MappedFile();
+
+  MappedFile(const MappedFile&) = delete;
+  MappedFile& operator=(const MappedFile&) = delete;
+
+  // Opens `path`, creating it empty if missing, and maps its current size.
+  bool Open(const std::string& path, std::string* error);
+  // Grows (or shrinks) the file and remaps it; earlier Data() pointers are
+  // invalidated.
+  bool Resize(std::size_t size, std::string* error);
+  // Schedules dirty pages for writeback without waiting.
+  void Sync();
+  void Close();
+
+  bool IsOpen() const;
+  unsigned char* Data() const { return data_; }
+  std::size_t Size() const { return size_; }
+
+ private:
+  bool Map(std::string* error);
+  void Unmap();
+
+#if defined(_WIN32)
+  void* file_ = nullptr;
+  void* mapping_ = nullptr;
+#else
+  int fd_ = -1;
+#endif
+  unsigned char* data_ = nullptr;
+  std::size_t size_ = 0;
+};
+
+} // namespace inputhook
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#include "event.h"
+
+namespace inputhook {
+
+struct MonitorRect {
+  int32_t x = 0;
+  int32_t y = 0;
+  int32_t width = 0;
+  int32_t height = 0;
+};
+
+// Cached monitor geometry in root coordinates, refreshed by the backend only
+// when the display configuration changes. Lives on the hook thread.
+class MonitorLayout {
+ public:
+  void Set(std::vector<MonitorRect> monitors) { monitors_ = std::move(monitors); }
+
+  // Adds the index of the monitor containing x/y and the position relative
+  // to its top-left corner. Positions in a gap between monitors are left
+  // unannotated.
+  void Annotate(InputEvent& event) const {
+    if (!event.x || !event.y) {
+      return;
+    }
+    for (std::size_t i = 0; i < monitors_.size(); ++i) {
+      const MonitorRect& monitor = monitors_[i];
+      int32_t relativeX = *event.x - monitor.x;
+      int32_t relativeY = *event.y - monitor.y;
+      if (relativeX >= 0 && relativeX < monitor.width && relativeY >= 0 &&
+          relativeY < monitor.height) {
+        event.monitor = static_cast<uint32_t>(i);
+        event.monitorX = relativeX;
+        event.monitorY = relativeY;
+        return;
+      }
+    }
+  }
+
+ private:
+  std::vector<MonitorRect> monitors_;
+};
+
+} // namespace inputhook
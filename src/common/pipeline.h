@@ -0,0 +1,275 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+#include "emitter.h"
+#include "event.h"
+
+namespace inputhook {
+
+// Statically composed event pipeline. Each stage provides
+//
+//   template <typename Next> void Process(InputEvent&& event, Next&& next);
+//   template <typename Next> void Flush(Next&& next);
+//   void Reset();
+//
+// and forwards zero or more events to `next`. The chain is expanded at
+// compile time, so the only indirect call per event is the EventSink entry
+// point the platform hook uses. The event's type is classified once on entry
+// (InputEvent::typeBit) for the stages to test.
+template <typename... Stages>
+class Pipeline final : public EventSink {
+ public:
+  template <typename Stage>
+  Stage& Get() {
+    return std::get<Stage>(stages_);
+  }
+
+  void OnEvent(InputEvent&& event) override {
+    if (!event.typeBit) {
+      event.typeBit = TypeBitFor(event.type);
+    }
+    Run<0>(std::move(event));
+  }
+
+  void Flush() override {
+    FlushFrom<0>();
+  }
+
+  void Reset() override {
+    std::apply([](auto&... stages) { (stages.Reset(), ...); }, stages_);
+  }
+
+ private:
+  template <std::size_t I>
+  void Run(InputEvent&& event) {
+    if constexpr (I < sizeof...(Stages)) {
+      std::get<I>(stages_).Process(std::move(event),
+                                   [this](InputEvent&& next) { Run<I + 1>(std::move(next)); });
+    }
+  }
+
+  template <std::size_t I>
+  void FlushFrom() {
+    if constexpr (I < sizeof...(Stages)) {
+      std::get<I>(stages_).Flush([this](InputEvent&& next) { Run<I + 1>(std::move(next)); });
+      FlushFrom<I + 1>();
+    }
+  }
+
+  std::tuple<Stages...> stages_;
+};
+
+// Routes events to one of several Pipeline compositions, so optional stages
+// are either compiled into the chain or absent rather than toggled per event.
+// Select() may be called from any thread; the hook thread notices the switch
+// on its next event and flushes the previous composition first, so nothing
+// it held is lost or reordered.
+template <typename... Pipelines>
+class PipelineSwitch final : public EventSink {
+ public:
+  template <typename P>
+  void Select() {
+    active_.store(IndexOf<P>(), std::memory_order_release);
+  }
+
+  template <typename F>
+  void ForEach(F&& f) {
+    std::apply([&f](auto&... pipelines) { (f(pipelines), ...); }, pipelines_);
+  }
+
+  void OnEvent(InputEvent&& event) override {
+    Visit<0>(Current(), [&event](auto& pipeline) { pipeline.OnEvent(std::move(event)); });
+  }
+
+  void Flush() override {
+    Visit<0>(Current(), [](auto& pipeline) { pipeline.Flush(); });
+  }
+
+  void Reset() override {
+    ForEach([](auto& pipeline) { pipeline.Reset(); });
+  }
+
+ private:
+  template <typename P, std::size_t I = 0>
+  static constexpr std::size_t IndexOf() {
+    static_assert(I < sizeof...(Pipelines), "not one of the switch's pipelines");
+    if constexpr (std::is_same_v<P, std::tuple_element_t<I, std::tuple<Pipelines...>>>) {
+      return I;
+    } else {
+      return IndexOf<P, I + 1>();
+    }
+  }
+
+  template <std::size_t I, typename F>
+  void Visit(std::size_t index, F&& f) {
+    if constexpr (I < sizeof...(Pipelines)) {
+      if (index == I) {
+        f(std::get<I>(pipelines_));
+      } else {
+        Visit<I + 1>(index, f);
+      }
+    }
+  }
+
+  // Hook thread only.
+  std::size_t Current() {
+    std::size_t active = active_.load(std::memory_order_acquire);
+    if (active != used_) {
+      Visit<0>(used_, [](auto& pipeline) { pipeline.Flush(); });
+      used_ = active;
+    }
+    return active;
+  }
+
+  std::tuple<Pipelines...> pipelines_;
+  std::atomic<std::size_t> active_{0};
+  std::size_t used_ = 0;
+};
+
+// Stages that never buffer inherit the no-op Flush and Reset.
+struct UnbufferedStage {
+  template <typename Next>
+  void Flush(Next&&) {}
+  void Reset() {}
+};
+
+// Drops event types nobody consumes before any other work is done.
+class TypeFilterStage : public UnbufferedStage {
+ public:
+  void SetMask(uint32_t mask) {
+    mask_.store(mask, std::memory_order_release);
+  }
+
+  template <typename Next>
+  void Process(InputEvent&& event, Next&& next) {
+    uint32_t mask = mask_.load(std::memory_order_relaxed);
+    if (mask == kAllTypeBits || (mask & event.typeBit)) {
+      next(std::move(event));
+    }
+  }
+
+ private:
+  std::atomic<uint32_t> mask_{kAllTypeBits};
+};
+
+// Removes motion that does not move the pointer and exact repeats of a key
+// or button transition (same code, same timestamp) that some drivers and
+// remote-desktop stacks deliver twice.
+class DedupeStage : public UnbufferedStage {
+ public:
+  void Reset() {
+    hasPosition_ = false;
+    lastCode_.reset();
+  }
+
+  template <typename Next>
+  void Process(InputEvent&& event, Next&& next) {
+    if (IsDuplicate(event)) {
+      return;
+    }
+    next(std::move(event));
+  }
+
+ private:
+  struct CodeEvent {
+    uint32_t typeBit;
+    uint32_t code;
+    double time;
+  };
+
+  bool IsDuplicate(const InputEvent& event) {
+    uint32_t typeBit = event.typeBit;
+    if (typeBit == kMouseMoveBit) {
+      if (event.x && event.y) {
+        bool same = hasPosition_ && *event.x == lastX_ && *event.y == lastY_;
+        hasPosition_ = true;
+        lastX_ = *event.x;
+        lastY_ = *event.y;
+        return same && !event.deltaX.value_or(0) && !event.deltaY.value_or(0);
+      }
+      return !event.deltaX.value_or(0) && !event.deltaY.value_or(0);
+    }
+
+    std::optional<uint32_t> code = event.keycode ? event.keycode : event.button;
+    if (!code || !(typeBit & (kKeyDownBit | kKeyUpBit | kMouseDownBit | kMouseUpBit))) {
+      return false;
+    }
+    CodeEvent current{typeBit, *code, event.time};
+    bool same = lastCode_ && lastCode_->typeBit == current.typeBit &&
+                lastCode_->code == current.code && lastCode_->time == current.time;
+    lastCode_ = current;
+    return same;
+  }
+
+  bool hasPosition_ = false;
+  int32_t lastX_ = 0;
+  int32_t lastY_ = 0;
+  std::optional<CodeEvent> lastCode_;
+};
+
+// Folds a later "mousemove" into an earlier one: the latest position wins and
+// relative deltas add up.
+inline void MergeMotion(InputEvent& held, const InputEvent& event) {
+  held.time = event.time;
+  held.modifiers = event.modifiers;
+  if (event.x && event.y) {
+    held.x = event.x;
+    held.y = event.y;
+    held.monitor = event.monitor;
+    held.monitorX = event.monitorX;
+    held.monitorY = event.monitorY;
+  }
+  if (event.deltaX) {
+    held.deltaX = held.deltaX.value_or(0) + *event.deltaX;
+  }
+  if (event.deltaY) {
+    held.deltaY = held.deltaY.value_or(0) + *event.deltaY;
+  }
+}
+
+// Keeps a single latest-motion slot: consecutive mousemoves within one
+// platform batch merge into one event (latest position, summed deltas). Any
+// other event or the end of the batch releases the slot first, so ordering
+// is preserved.
+class MotionCoalesceStage {
+ public:
+  void Reset() {
+    held_.reset();
+  }
+
+  template <typename Next>
+  void Process(InputEvent&& event, Next&& next) {
+    if (event.typeBit != kMouseMoveBit) {
+      Flush(next);
+      next(std::move(event));
+      return;
+    }
+    if (!held_) {
+      held_ = std::move(event);
+      return;
+    }
+    MergeMotion(*held_, event);
+  }
+
+  template <typename Next>
+  void Flush(Next&& next) {
+    if (held_) {
+      InputEvent event = std::move(*held_);
+      held_.reset();
+      next(std::move(event));
+    }
+  }
+
+ private:
+  std::optional<InputEvent> held_;
+};
+
+} // namespace inputhook
@@ -0,0 +1,307 @@
+#include "timeline.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+namespace inputhook {
+
+namespace {
+
+constexpr char kMagic[8] = {'I', 'H', 'T', 'L', 'I', 'N', 'E', '1'};
+constexpr uint32_t kVersion = 2;
+// One week of minute buckets per segment.
+constexpr uint32_t kSegmentBuckets = 10080;
+// Each segment starts with its first bucket as an int64.
+constexpr std::size_t kSegmentPrefix = sizeof(int64_t);
+
+enum Column : std::size_t {
+  kKeysColumn,
+  kClicksColumn,
+  kMovesColumn,
+  kWheelColumn,
+  kCounterColumns,
+};
+
+int64_t FloorDiv(int64_t value, int64_t divisor) {
+  int64_t quotient = value / divisor;
+  return (value % divisor != 0 && (value < 0) != (divisor < 0)) ? quotient - 1 : quotient;
+}
+
+} // namespace
+
+struct ActivityTimeline::Header {
+  char magic[8];
+  uint32_t version;
+  uint32_t intervalMs;
+  uint32_t segmentBuckets;
+  uint32_t segments;
+  // Start of bucket 0; only meaningful once a segment exists.
+  int64_t originMs;
+  unsigned char reserved[32];
+};
+
+ActivityTimeline::Header* ActivityTimeline::FileHeader() const {
+  static_assert(sizeof(Header) == 64, "timeline header must stay 64 bytes");
+  return reinterpret_cast<Header*>(file_.Data());
+}
+
+std::size_t ActivityTimeline::SegmentBytes() const {
+  std::size_t buckets = FileHeader()->segmentBuckets;
+  std::size_t bytes = kSegmentPrefix + buckets * (kCounterColumns * sizeof(uint32_t) + 1);
+  return (bytes + 7) & ~static_cast<std::size_t>(7);
+}
+
+unsigned char* ActivityTimeline::Segment(uint32_t slot) const {
+  return file_.Data() + sizeof(Header) + static_cast<std::size_t>(slot) * SegmentBytes();
+}
+
+bool ActivityTimeline::Initialize(uint32_t intervalMs, std::string* error) {
+  Header header{};
+  std::memcpy(header.magic, kMagic, sizeof(kMagic));
+  header.version = kVersion;
+  header.intervalMs = intervalMs ? intervalMs : kDefaultIntervalMs;
+  header.segmentBuckets = kSegmentBuckets;
+  header.segments = 0;
+
+  if (!file_.Resize(sizeof(Header), error)) {
+    return false;
+  }
+  std::memcpy(file_.Data(), &header, sizeof(header));
+  return true;
+}
+
+bool ActivityTimeline::Validate(uint32_t intervalMs, std::string* error) {
+  const Header* header = FileHeader();
+  if (file_.Size() < sizeof(Header) || std::memcmp(header->magic, kMagic, sizeof(kMagic)) != 0) {
+    *error = options_.path + " is not an activity timeline file";
+    return false;
+  }
+  if (header->version != kVersion) {
+    *error = options_.path + " has unsupported timeline version " + std::to_string(header->version);
+    return false;
+  }
+  std::string corrupt = options_.path + " is truncated or corrupt";
+  if (header->intervalMs == 0 || header->segmentBuckets == 0 ||
+      file_.Size() < sizeof(Header) + static_cast<uint64_t>(header->segments) * SegmentBytes()) {
+    *error = corrupt;
+    return false;
+  }
+  int64_t buckets = header->segmentBuckets;
+  for (uint32_t slot = 0; slot < header->segments; ++slot) {
+    int64_t start;
+    std::memcpy(&start, Segment(slot), sizeof(start));
+    if (FloorDiv(start, buckets) * buckets != start || !segments_.emplace(start, slot).second) {
+      *error = corrupt;
+      return false;
+    }
+  }
+  if (intervalMs && intervalMs != header->intervalMs) {
+    *error = options_.path + " was created with a " + std::to_string(header->intervalMs) +
+             " ms interval";
+    return false;
+  }
+  return true;
+}
+
+bool ActivityTimeline::Configure(const TimelineOptions& options, std::string* error) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  file_.Close();
+  segments_.clear();
+  pressed_.reset();
+  options_ = options;
+  if (!options_.enabled) {
+    return true;
+  }
+
+  options_.enabled = false;
+  if (options_.path.empty()) {
+    *error = "timeline path required";
+    return false;
+  }
+  if (!file_.Open(options_.path, error)) {
+    return false;
+  }
+  bool ready = file_.Size() == 0 ? Initialize(options.intervalMs, error)
+                                 : Validate(options.intervalMs, error);
+  if (!ready) {
+    file_.Close();
+    segments_.clear();
+    return false;
+  }
+  options_.enabled = true;
+  options_.intervalMs = FileHeader()->intervalMs;
+  return true;
+}
+
+TimelineOptions ActivityTimeline::Options() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return options_;
+}
+
+void ActivityTimeline::Close() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  file_.Close();
+  segments_.clear();
+  pressed_.reset();
+  options_.enabled = false;
+}
+
+void ActivityTimeline::ResetKeys() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  pressed_.reset();
+}
+
+unsigned char* ActivityTimeline::SegmentColumns(int64_t bucket) {
+  int64_t buckets = FileHeader()->segmentBuckets;
+  int64_t start = FloorDiv(bucket, buckets) * buckets;
+  auto found = segments_.find(start);
+  if (found != segments_.end()) {
+    return Segment(found->second) + kSegmentPrefix;
+  }
+
+  uint32_t slot = FileHeader()->segments;
+  std::string error;
+  if (slot == std::numeric_limits<uint32_t>::max() ||
+      !file_.Resize(sizeof(Header) + (static_cast<std::size_t>(slot) + 1) * SegmentBytes(), &error) ||
+      !file_.Data()) {
+    return nullptr;
+  }
+  std::memcpy(Segment(slot), &start, sizeof(start));
+  FileHeader()->segments = slot + 1;
+  segments_.emplace(start, slot);
+  return Segment(slot) + kSegmentPrefix;
+}
+
+void ActivityTimeline::Process(const InputEvent& event) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (!file_.Data()) {
+    return;
+  }
+
+  Column column;
+  uint32_t usage = event.hidUsage.value_or(0);
+  if (event.type == "keydown") {
+    if (usage > 0 && usage < pressed_.size()) {
+      if (pressed_.test(usage)) {
+        return;  // autorepeat
+      }
+      pressed_.set(usage);
+    }
+    column = kKeysColumn;
+  } else if (event.type == "keyup") {
+    if (usage > 0 && usage < pressed_.size()) {
+      pressed_.reset(usage);
+    }
+    return;
+  } else if (event.type == "mousedown") {
+    column = kClicksColumn;
+  } else if (event.type == "mousemove") {
+    column = kMovesColumn;
+  } else if (event.type == "wheel") {
+    column = kWheelColumn;
+  } else {
+    return;
+  }
+
+  Header* header = FileHeader();
+  int64_t interval = header->intervalMs;
+  int64_t time = static_cast<int64_t>(std::floor(event.time));
+  if (header->segments == 0) {
+    header->originMs = FloorDiv(time, interval) * interval;
+  }
+  int64_t bucket = FloorDiv(time - header->originMs, interval);
+  unsigned char* data = SegmentColumns(bucket);
+  if (!data) {
+    return;
+  }
+
+  int64_t buckets = FileHeader()->segmentBuckets;
+  std::size_t index = static_cast<std::size_t>(bucket - FloorDiv(bucket, buckets) * buckets);
+  uint32_t* counter = reinterpret_cast<uint32_t*>(data) + column * buckets + index;
+  if (*counter != std::numeric_limits<uint32_t>::max()) {
+    ++*counter;
+  }
+  data[kCounterColumns * buckets * sizeof(uint32_t) + index] = 1;
+}
+
+bool ActivityTimeline::Query(double fromMs,
+                             double toMs,
+                             double resolutionMs,
+                             double offsetMs,
+                             TimelineRange* range,
+                             std::string* error) const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (!file_.Data()) {
+    *error = "timeline is not configured";
+    return false;
+  }
+
+  const Header* header = FileHeader();
+  int64_t interval = header->intervalMs;
+  if (!(resolutionMs >= interval && resolutionMs <= 1e12) ||
+      std::fmod(resolutionMs, static_cast<double>(interval)) != 0.0) {
+    *error = "resolution must be a multiple of the " + std::to_string(interval) + " ms interval";
+    return false;
+  }
+  if (!(std::fabs(offsetMs) <= 1e12) || std::fmod(offsetMs, static_cast<double>(interval)) != 0.0) {
+    *error = "offset must be a multiple of the " + std::to_string(interval) + " ms interval";
+    return false;
+  }
+  if (!(toMs >= fromMs) || !std::isfinite(fromMs) || !std::isfinite(toMs)) {
+    *error = "to must not be before from";
+    return false;
+  }
+
+  int64_t resolution = static_cast<int64_t>(resolutionMs);
+  int64_t offset = static_cast<int64_t>(offsetMs);
+  int64_t first =
+      FloorDiv(static_cast<int64_t>(std::floor(fromMs)) + offset, resolution) * resolution - offset;
+  int64_t end = FloorDiv(static_cast<int64_t>(std::ceil(toMs)) + offset + resolution - 1, resolution) *
+                    resolution - offset;
+  std::size_t count = static_cast<std::size_t>((end - first) / resolution);
+  if (count > kMaxQueryBuckets) {
+    *error = "query spans more than " + std::to_string(kMaxQueryBuckets) + " buckets";
+    return false;
+  }
+
+  range->startMs = static_cast<double>(first);
+  range->resolutionMs = static_cast<double>(resolution);
+  for (auto* column : {&range->keys, &range->clicks, &range->moves, &range->wheel, &range->active}) {
+    column->assign(count, 0);
+  }
+  if (segments_.empty() || count == 0) {
+    return true;
+  }
+
+  // The origin, `first` and the resolution are all multiples of the
+  // interval, so every base bucket falls into exactly one output bucket.
+  int64_t firstBucket = FloorDiv(first - header->originMs, interval);
+  int64_t lastBucket = FloorDiv(end - header->originMs, interval) - 1;
+  int64_t buckets = header->segmentBuckets;
+  for (auto segment = segments_.upper_bound(FloorDiv(firstBucket, buckets) * buckets - 1);
+       segment != segments_.end() && segment->first <= lastBucket; ++segment) {
+    const unsigned char* data = Segment(segment->second) + kSegmentPrefix;
+    const uint32_t* counters = reinterpret_cast<const uint32_t*>(data);
+    const unsigned char* active = data + kCounterColumns * buckets * sizeof(uint32_t);
+    int64_t from = std::max(firstBucket, segment->first);
+    int64_t to = std::min(lastBucket, segment->first + buckets - 1);
+    for (int64_t bucket = from; bucket <= to; ++bucket) {
+      std::size_t index = static_cast<std::size_t>(bucket - segment->first);
+      if (!active[index]) {
+        continue;
+      }
+      std::size_t out =
+          static_cast<std::size_t>((header->originMs + bucket * interval - first) / resolution);
+      range->keys[out] += counters[kKeysColumn * buckets + index];
+      range->clicks[out] += counters[kClicksColumn * buckets + index];
+      range->moves[out] += counters[kMovesColumn * buckets + index];
+      range->wheel[out] += counters[kWheelColumn * buckets + index];
+      range->active[out] += 1;
+    }
+  }
+  return true;
+}
+
+} // namespace inputhook
@@ -0,0 +1,89 @@
+#pragma once
+
+#include <bitset>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "event.h"
+#include "mapped_file.h"
+
+namespace inputhook {
+
+struct TimelineOptions {
+  bool enabled = false;
+  std::string path;
+  // Base bucket length. 0 keeps the interval of an existing file, or uses
+  // one minute for a new one.
+  uint32_t intervalMs = 0;
+};
+
+// Counts rolled up to `resolutionMs` buckets starting at `startMs`.
+struct TimelineRange {
+  double startMs = 0.0;
+  double resolutionMs = 0.0;
+  std::vector<uint32_t> keys;
+  std::vector<uint32_t> clicks;
+  std::vector<uint32_t> moves;
+  std::vector<uint32_t> wheel;
+  // Base intervals that saw any input.
+  std::vector<uint32_t> active;
+};
+
+// Appends per-interval activity counts to a memory-mapped columnar file so
+// history survives restarts and range queries only touch the pages they
+// cover. The file is a 64-byte header followed by fixed-size segments in the
+// order they were first written. Each segment covers an aligned run of
+// buckets, named by its first bucket, and stores the keys, clicks, moves and
+// wheel columns as uint32 arrays and the active column as bytes. A segment
+// is only added once input lands in it, so a machine that was off for months
+// or a clock that jumps costs one segment, and a full segment is never
+// relocated when the file grows.
+class ActivityTimeline {
+ public:
+  static constexpr uint32_t kDefaultIntervalMs = 60000;
+  static constexpr std::size_t kMaxQueryBuckets = 1u << 20;
+
+  bool Configure(const TimelineOptions& options, std::string* error);
+  TimelineOptions Options() const;
+  void Close();
+
+  // Buckets are aligned to multiples of `resolutionMs` since the epoch after
+  // adding `offsetMs`, so 86400000 gives UTC days with an offset of 0 and
+  // local days with the zone's UTC offset. `resolutionMs` and `offsetMs`
+  // must be multiples of the interval.
+  bool Query(double fromMs,
+             double toMs,
+             double resolutionMs,
+             double offsetMs,
+             TimelineRange* range,
+             std::string* error) const;
+
+  // Forgets held keys, for when their releases may have been missed.
+  void ResetKeys();
+
+  void Process(const InputEvent& event);
+
+ private:
+  struct Header;
+
+  Header* FileHeader() const;
+  bool Initialize(uint32_t intervalMs, std::string* error);
+  bool Validate(uint32_t intervalMs, std::string* error);
+  // Returns the columns of the segment holding `bucket`, adding the segment
+  // if it is missing, or null when the file cannot grow.
+  unsigned char* SegmentColumns(int64_t bucket);
+  std::size_t SegmentBytes() const;
+  unsigned char* Segment(uint32_t slot) const;
+
+  mutable std::mutex mutex_;
+  TimelineOptions options_;
+  MappedFile file_;
+  // First bucket of each segment to its position in the file.
+  std::map<int64_t, uint32_t> segments_;
+  std::bitset<256> pressed_;
+};
+
+} // namespace inputhook
@@ -0,0 +1,169 @@
+#include "typing.h"
+
+#include <algorithm>
+
+namespace inputhook {
+
+void TypingStats::Configure(const TypingStatsOptions& options) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  options_ = options;
+  options_.bucketCount = std::max<uint32_t>(1, options_.bucketCount);
+  if (!(options_.bucketMs > 0.0)) {
+    options_.bucketMs = 25.0;
+  }
+  pressed_.reset();
+  strokes_.clear();
+  bursts_.clear();
+  pauses_.clear();
+  histogram_.assign(options_.bucketCount, 0);
+  backspaces_ = 0;
+  intervalSum_ = 0.0;
+  intervalCount_ = 0;
+  current_ = {0.0, 0.0, 0};
+}
+
+TypingStatsOptions TypingStats::Options() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return options_;
+}
+
+void TypingStats::Clear() {
+  Configure(Options());
+}
+
+void TypingStats::ResetKeys() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  pressed_.reset();
+}
+
+std::size_t TypingStats::BucketFor(double interval) const {
+  auto bucket = static_cast<std::size_t>(interval / options_.bucketMs);
+  return std::min<std::size_t>(bucket, histogram_.size() - 1);
+}
+
+void TypingStats::Prune(double now) {
+  double horizon = now - options_.windowMs;
+  while (!strokes_.empty() && strokes_.front().time < horizon) {
+    const Stroke& stroke = strokes_.front();
+    if (stroke.backspace) {
+      --backspaces_;
+    }
+    if (stroke.interval >= 0.0) {
+      --histogram_[BucketFor(stroke.interval)];
+      intervalSum_ -= stroke.interval;
+      --intervalCount_;
+    }
+    strokes_.pop_front();
+  }
+  while (!bursts_.empty() && bursts_.front().end < horizon) {
+    bursts_.pop_front();
+  }
+  while (!pauses_.empty() && pauses_.front().first < horizon) {
+    pauses_.pop_front();
+  }
+  if (intervalCount_ == 0) {
+    intervalSum_ = 0.0;
+  }
+}
+
+void TypingStats::Process(const InputEvent& event) {
+  bool keyDown = event.type == "keydown";
+  if (!keyDown && event.type != "keyup") {
+    return;
+  }
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (!options_.enabled) {
+    return;
+  }
+
+  uint32_t usage = event.hidUsage.value_or(0);
+  // Modifiers on their own are not keystrokes.
+  if (usage >= 0xE0 && usage <= 0xE7) {
+    return;
+  }
+  if (!keyDown) {
+    if (usage > 0 && usage < pressed_.size()) {
+      pressed_.reset(usage);
+    }
+    return;
+  }
+  if (usage > 0 && usage < pressed_.size()) {
+    if (pressed_.test(usage)) {
+      return;
+    }
+    pressed_.set(usage);
+  }
+
+  Stroke stroke{event.time, -1.0, usage == kBackspaceUsage};
+  if (current_.keys > 0) {
+    double gap = event.time - current_.end;
+    if (gap >= 0.0 && gap < options_.pauseThresholdMs) {
+      stroke.interval = gap;
+      ++histogram_[BucketFor(gap)];
+      intervalSum_ += gap;
+      ++intervalCount_;
+      current_.end = event.time;
+      ++current_.keys;
+    } else {
+      bursts_.push_back(current_);
+      pauses_.emplace_back(current_.end, std::max(0.0, gap));
+      current_ = {event.time, event.time, 1};
+    }
+  } else {
+    current_ = {event.time, event.time, 1};
+  }
+  if (stroke.backspace) {
+    ++backspaces_;
+  }
+  strokes_.push_back(stroke);
+  Prune(event.time);
+}
+
+TypingStatsSnapshot TypingStats::Snapshot(double now) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  Prune(now);
+
+  TypingStatsSnapshot snapshot;
+  snapshot.windowMs = options_.windowMs;
+  snapshot.keys = static_cast<uint32_t>(strokes_.size());
+  snapshot.backspaces = backspaces_;
+  if (options_.windowMs > 0.0) {
+    snapshot.keysPerMinute = snapshot.keys * 60000.0 / options_.windowMs;
+  }
+  if (intervalCount_ > 0) {
+    snapshot.meanIntervalMs = intervalSum_ / intervalCount_;
+  }
+  snapshot.bucketMs = options_.bucketMs;
+  snapshot.histogram = histogram_;
+
+  // The open burst only counts once the pause threshold has passed.
+  bool currentClosed = current_.keys > 0 && now - current_.end >= options_.pauseThresholdMs;
+  bool currentInWindow = current_.keys > 0 && current_.end >= now - options_.windowMs;
+  double burstKeys = 0.0;
+  double burstMs = 0.0;
+  for (const Burst& burst : bursts_) {
+    burstKeys += burst.keys;
+    burstMs += burst.end - burst.start;
+  }
+  snapshot.bursts = static_cast<uint32_t>(bursts_.size());
+  if (currentClosed && currentInWindow) {
+    ++snapshot.bursts;
+    burstKeys += current_.keys;
+    burstMs += current_.end - current_.start;
+  } else if (!currentClosed) {
+    snapshot.currentBurstKeys = current_.keys;
+  }
+  if (snapshot.bursts > 0) {
+    snapshot.meanBurstKeys = burstKeys / snapshot.bursts;
+    snapshot.meanBurstMs = burstMs / snapshot.bursts;
+  }
+
+  snapshot.pauses = static_cast<uint32_t>(pauses_.size());
+  for (const auto& pause : pauses_) {
+    snapshot.pauseMs += pause.second;
+  }
+  return snapshot;
+}
+
+} // namespace inputhook
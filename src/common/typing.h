@@ -0,0 +1,85 @@
+#pragma once
+
+#include <bitset>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+#include "event.h"
+
+namespace inputhook {
+
+struct TypingStatsOptions {
+  bool enabled = false;
+  double windowMs = 60000.0;
+  // A gap at least this long ends a burst and counts as a pause.
+  double pauseThresholdMs = 2000.0;
+  double bucketMs = 25.0;
+  uint32_t bucketCount = 40;
+};
+
+struct TypingStatsSnapshot {
+  double windowMs = 0.0;
+  uint32_t keys = 0;
+  uint32_t backspaces = 0;
+  double keysPerMinute = 0.0;
+  double meanIntervalMs = 0.0;
+  double bucketMs = 0.0;
+  // The last bucket collects every in-burst interval beyond the others.
+  std::vector<uint32_t> histogram;
+  uint32_t bursts = 0;
+  double meanBurstKeys = 0.0;
+  double meanBurstMs = 0.0;
+  uint32_t currentBurstKeys = 0;
+  uint32_t pauses = 0;
+  double pauseMs = 0.0;
+};
+
+// Rolling-window keystroke cadence. Only timestamps and a backspace flag are
+// retained; which keys were typed never leaves this class.
+class TypingStats {
+ public:
+  void Configure(const TypingStatsOptions& options);
+  TypingStatsOptions Options() const;
+  void Clear();
+  // Forgets held keys, for when their releases may have been missed.
+  void ResetKeys();
+  TypingStatsSnapshot Snapshot(double now);
+
+  void Process(const InputEvent& event);
+
+ private:
+  static constexpr uint32_t kBackspaceUsage = 0x2A;
+
+  struct Stroke {
+    double time;
+    // Interval from the previous stroke when it fell inside a burst, else -1.
+    double interval;
+    bool backspace;
+  };
+
+  struct Burst {
+    double start;
+    double end;
+    uint32_t keys;
+  };
+
+  std::size_t BucketFor(double interval) const;
+  void Prune(double now);
+
+  mutable std::mutex mutex_;
+  TypingStatsOptions options_;
+  std::bitset<256> pressed_;
+  std::deque<Stroke> strokes_;
+  std::deque<Burst> bursts_;
+  std::deque<std::pair<double, double>> pauses_;
+  std::vector<uint32_t> histogram_;
+  uint32_t backspaces_ = 0;
+  double intervalSum_ = 0.0;
+  uint32_t intervalCount_ = 0;
+  Burst current_{0.0, 0.0, 0};
+};
+
+} // namespace inputhook
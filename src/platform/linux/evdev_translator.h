@@ -0,0 +1,237 @@
+#pragma once
+
+#include <linux/input.h>
+
+#include <cstdint>
+#include <utility>
+
+#include "../../common/event.h"
+#include "../../common/keymap.h"
+
+// High-resolution wheels (Linux 5.0) report 1/120 of a notch per unit.
+#ifndef REL_WHEEL_HI_RES
+#define REL_WHEEL_HI_RES 0x0b
+#endif
+#ifndef REL_HWHEEL_HI_RES
+#define REL_HWHEEL_HI_RES 0x0c
+#endif
+
+namespace inputhook {
+namespace platform {
+namespace linux {
+
+// Turns the struct input_event stream of evdev devices into InputEvents.
+// Kept apart from EvdevPlatformHook so recorded streams can be replayed
+// through it without opening a device. Modifier state is shared by all
+// devices; relative motion is accumulated per device in its Axes.
+class EvdevTranslator {
+ public:
+  static constexpr int32_t kHiResPerNotch = 120;
+
+  struct Axes {
+    int32_t relX = 0;
+    int32_t relY = 0;
+    int32_t wheelX = 0;
+    int32_t wheelY = 0;
+    // Devices with a high-resolution wheel send both codes; once one has
+    // been seen the legacy notches are ignored and whole notches are cut
+    // from the accumulated fractions instead, keeping the remainder.
+    bool hiResWheel = false;
+    int32_t hiResX = 0;
+    int32_t hiResY = 0;
+  };
+
+  // `emit` is called with each finished InputEvent.
+  template <typename Emit>
+  void Translate(Axes& axes, uint16_t type, uint16_t code, int32_t value, double time,
+                 Emit&& emit) {
+    switch (type) {
+      case EV_SYN:
+        if (code == SYN_REPORT) {
+          Flush(axes, time, emit);
+        } else if (code == SYN_DROPPED) {
+          // The kernel buffer overflowed; partial motion is meaningless.
+          bool hiResWheel = axes.hiResWheel;
+          axes = Axes();
+          axes.hiResWheel = hiResWheel;
+        }
+        return;
+      case EV_REL:
+        switch (code) {
+          case REL_X:
+            axes.relX += value;
+            break;
+          case REL_Y:
+            axes.relY += value;
+            break;
+          case REL_WHEEL:
+            axes.wheelY += value;
+            break;
+          case REL_HWHEEL:
+            // X reports scrolling left as positive; evdev as negative.
+            axes.wheelX -= value;
+            break;
+          case REL_WHEEL_HI_RES:
+            axes.hiResWheel = true;
+            axes.hiResY += value;
+            break;
+          case REL_HWHEEL_HI_RES:
+            axes.hiResWheel = true;
+            axes.hiResX -= value;
+            break;
+        }
+        return;
+      case EV_KEY:
+        break;
+      default:
+        return;
+    }
+
+    InputEvent event;
+    event.time = time;
+    uint32_t button = 0;
+    if (ButtonIndex(code, &button)) {
+      if (value == 2) {
+        return;
+      }
+      event.type = value ? "mousedown" : "mouseup";
+      event.button = button;
+    } else if (code < BTN_MISC) {
+      // Matches the X keycode (evdev + 8) so all Linux backends agree; value
+      // 2 is autorepeat, reported as another keydown like X does.
+      event.type = value ? "keydown" : "keyup";
+      event.keycode = code + 8u;
+      event.scancode = code + 8u;
+      uint16_t usage = keymap::UsageFromEvdev(code);
+      if (usage != keymap::kUsageNone) {
+        event.hidUsage = usage;
+      }
+    } else {
+      return;
+    }
+
+    // Motion reported before a button in the same frame happened first.
+    Flush(axes, time, emit);
+    event.modifiers = Modifiers();
+    emit(std::move(event));
+
+    uint32_t modifierBit = ModifierKeyBit(code);
+    if (modifierBit) {
+      modifierKeys_ = value ? (modifierKeys_ | modifierBit) : (modifierKeys_ & ~modifierBit);
+    }
+  }
+
+  // Emits the motion and wheel accumulated since the last frame.
+  template <typename Emit>
+  void Flush(Axes& axes, double time, Emit&& emit) {
+    if (axes.relX || axes.relY) {
+      InputEvent motion;
+      motion.type = "mousemove";
+      motion.time = time;
+      motion.modifiers = Modifiers();
+      if (axes.relX) {
+        motion.deltaX = axes.relX;
+      }
+      if (axes.relY) {
+        motion.deltaY = axes.relY;
+      }
+      emit(std::move(motion));
+    }
+    if (axes.hiResWheel) {
+      axes.wheelX = axes.hiResX / kHiResPerNotch;
+      axes.wheelY = axes.hiResY / kHiResPerNotch;
+      axes.hiResX -= axes.wheelX * kHiResPerNotch;
+      axes.hiResY -= axes.wheelY * kHiResPerNotch;
+    }
+    if (axes.wheelX || axes.wheelY) {
+      InputEvent wheel;
+      wheel.type = "wheel";
+      wheel.time = time;
+      wheel.modifiers = Modifiers();
+      if (axes.wheelX) {
+        wheel.deltaX = axes.wheelX;
+      }
+      if (axes.wheelY) {
+        wheel.deltaY = axes.wheelY;
+      }
+      emit(std::move(wheel));
+    }
+    axes.relX = axes.relY = axes.wheelX = axes.wheelY = 0;
+  }
+
+  // Forgets held modifiers, for when releases may have been missed.
+  void Reset() { modifierKeys_ = 0; }
+
+ private:
+  enum ModifierBit : uint32_t {
+    kShiftBit = 1 << 0,
+    kCtrlBit = 1 << 1,
+    kAltBit = 1 << 2,
+    kMetaBit = 1 << 3,
+  };
+
+  // Left and right variants are tracked separately so releasing one side
+  // does not clear a modifier still held on the other.
+  static uint32_t ModifierKeyBit(uint16_t code) {
+    switch (code) {
+      case KEY_LEFTSHIFT:
+        return kShiftBit;
+      case KEY_RIGHTSHIFT:
+        return kShiftBit << 4;
+      case KEY_LEFTCTRL:
+        return kCtrlBit;
+      case KEY_RIGHTCTRL:
+        return kCtrlBit << 4;
+      case KEY_LEFTALT:
+        return kAltBit;
+      case KEY_RIGHTALT:
+        return kAltBit << 4;
+      case KEY_LEFTMETA:
+        return kMetaBit;
+      case KEY_RIGHTMETA:
+        return kMetaBit << 4;
+      default:
+        return 0;
+    }
+  }
+
+  // Same numbering as the X11 backends for left 0, middle 1, right 2; the
+  // side (back) and extra (forward) buttons are 3 and 4, as on macOS.
+  static bool ButtonIndex(uint16_t code, uint32_t* button) {
+    switch (code) {
+      case BTN_LEFT:
+        *button = 0;
+        return true;
+      case BTN_MIDDLE:
+        *button = 1;
+        return true;
+      case BTN_RIGHT:
+        *button = 2;
+        return true;
+      case BTN_SIDE:
+        *button = 3;
+        return true;
+      case BTN_EXTRA:
+        *button = 4;
+        return true;
+      default:
+        return false;
+    }
+  }
+
+  InputModifiers Modifiers() const {
+    uint32_t held = modifierKeys_ | (modifierKeys_ >> 4);
+    InputModifiers modifiers;
+    modifiers.shift = (held & kShiftBit) != 0;
+    modifiers.ctrl = (held & kCtrlBit) != 0;
+    modifiers.alt = (held & kAltBit) != 0;
+    modifiers.meta = (held & kMetaBit) != 0;
+    return modifiers;
+  }
+
+  uint32_t modifierKeys_ = 0;
+};
+
+} // namespace linux
+} // namespace platform
+} // namespace inputhook
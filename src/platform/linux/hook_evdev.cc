@@ -0,0 +1,360 @@
+#include "hook_evdev.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/epoll.h>
+#include <sys/inotify.h>
+#include <sys/ioctl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace inputhook {
+namespace platform {
+namespace linux {
+
+namespace {
+
+constexpr const char* kInputDirectory = "/dev/input";
+constexpr std::size_t kReadBatch = 64;
+
+// epoll user data for the non-device descriptors.
+constexpr uint64_t kWakeToken = 1;
+constexpr uint64_t kInotifyToken = 2;
+
+bool TestBit(const unsigned long* bits, unsigned int bit) {
+  constexpr unsigned int kBitsPerLong = sizeof(unsigned long) * 8;
+  return (bits[bit / kBitsPerLong] >> (bit % kBitsPerLong)) & 1UL;
+}
+
+} // namespace
+
+struct EvdevPlatformHook::Device {
+  std::string path;
+  int fd = -1;
+  // Regular files (recordings) cannot be polled and are replayed once.
+  bool regularFile = false;
+  // Pipes may split a struct input_event across reads.
+  unsigned char partial[sizeof(struct input_event)];
+  std::size_t partialBytes = 0;
+  EvdevTranslator::Axes axes;
+};
+
+EvdevPlatformHook::EvdevPlatformHook(EventSink* sink, std::vector<std::string> devices)
+    : PlatformHook(sink), explicitDevices_(std::move(devices)) {}
+
+EvdevPlatformHook::~EvdevPlatformHook() {
+  Stop();
+}
+
+void EvdevPlatformHook::NotifyStartResult(bool success) {
+  std::shared_ptr<std::promise<bool>> promise;
+  {
+    std::lock_guard<std::mutex> lock(startPromiseMutex_);
+    promise = std::move(startPromise_);
+  }
+  if (promise) {
+    promise->set_value(success);
+  }
+}
+
+std::string EvdevPlatformHook::GetFailureReason() const {
+  std::lock_guard<std::mutex> lock(failureMutex_);
+  return failureReason_;
+}
+
+void EvdevPlatformHook::SetFailureReason(std::string reason) {
+  std::lock_guard<std::mutex> lock(failureMutex_);
+  failureReason_ = std::move(reason);
+}
+
+bool EvdevPlatformHook::OpenDevice(const std::string& path,
+                                   bool explicitPath,
+                                   std::string* error) {
+  for (const auto& device : devices_) {
+    if (device->path == path) {
+      return true;
+    }
+  }
+
+  int fd = open(path.c_str(), O_RDONLY | O_NONBLOCK | O_CLOEXEC);
+  if (fd < 0) {
+    if (error) {
+      *error = path + ": " + std::strerror(errno);
+    }
+    return false;
+  }
+
+  struct stat info;
+  bool regularFile = fstat(fd, &info) == 0 && S_ISREG(info.st_mode);
+  if (!explicitPath) {
+    // Only keyboards and relative pointers; skip lid switches, joysticks,
+    // accelerometers and the like.
+    unsigned long types[(EV_MAX + 1 + sizeof(unsigned long) * 8 - 1) / (sizeof(unsigned long) * 8)] = {};
+    if (ioctl(fd, EVIOCGBIT(0, sizeof(types)), types) < 0 ||
+        (!TestBit(types, EV_KEY) && !TestBit(types, EV_REL))) {
+      close(fd);
+      return false;
+    }
+  }
+
+  auto device = std::make_unique<Device>();
+  device->path = path;
+  device->fd = fd;
+  device->regularFile = regularFile;
+  if (!regularFile) {
+    struct epoll_event registration {};
+    registration.events = EPOLLIN;
+    registration.data.ptr = device.get();
+    if (epoll_ctl(epollFd_, EPOLL_CTL_ADD, fd, &registration) != 0) {
+      if (error) {
+        *error = path + ": " + std::strerror(errno);
+      }
+      close(fd);
+      return false;
+    }
+  }
+  devices_.push_back(std::move(device));
+  return true;
+}
+
+void EvdevPlatformHook::CloseDevice(Device* device) {
+  if (!device->regularFile) {
+    epoll_ctl(epollFd_, EPOLL_CTL_DEL, device->fd, nullptr);
+  }
+  close(device->fd);
+  devices_.erase(std::remove_if(devices_.begin(), devices_.end(),
+                                [device](const std::unique_ptr<Device>& entry) {
+                                  return entry.get() == device;
+                                }),
+                 devices_.end());
+}
+
+void EvdevPlatformHook::ScanDevices() {
+  DIR* directory = opendir(kInputDirectory);
+  if (!directory) {
+    return;
+  }
+  while (struct dirent* entry = readdir(directory)) {
+    if (std::strncmp(entry->d_name, "event", 5) == 0) {
+      OpenDevice(std::string(kInputDirectory) + "/" + entry->d_name, false, nullptr);
+    }
+  }
+  closedir(directory);
+}
+
+void EvdevPlatformHook::HandleHotplug() {
+  alignas(struct inotify_event) char buffer[4096];
+  ssize_t length;
+  while ((length = read(inotifyFd_, buffer, sizeof(buffer))) > 0) {
+    for (char* cursor = buffer; cursor < buffer + length;) {
+      auto* event = reinterpret_cast<struct inotify_event*>(cursor);
+      // udev creates the node first and fixes its permissions afterwards,
+      // so IN_ATTRIB gets a second chance at opening it.
+      if (event->len && std::strncmp(event->name, "event", 5) == 0) {
+        OpenDevice(std::string(kInputDirectory) + "/" + event->name, false, nullptr);
+      }
+      cursor += sizeof(struct inotify_event) + event->len;
+    }
+  }
+}
+
+bool EvdevPlatformHook::Setup() {
+  epollFd_ = epoll_create1(EPOLL_CLOEXEC);
+  if (epollFd_ < 0) {
+    SetFailureReason(std::string("epoll_create1 failed: ") + std::strerror(errno));
+    return false;
+  }
+
+  struct epoll_event registration {};
+  registration.events = EPOLLIN;
+  registration.data.u64 = kWakeToken;
+  epoll_ctl(epollFd_, EPOLL_CTL_ADD, wakeFds_[0], &registration);
+
+  if (!explicitDevices_.empty()) {
+    for (const auto& path : explicitDevices_) {
+      std::string error;
+      if (!OpenDevice(path, true, &error)) {
+        SetFailureReason("unable to open input device " + error);
+        return false;
+      }
+    }
+    return true;
+  }
+
+  inotifyFd_ = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+  if (inotifyFd_ >= 0 &&
+      inotify_add_watch(inotifyFd_, kInputDirectory, IN_CREATE | IN_ATTRIB) >= 0) {
+    registration.data.u64 = kInotifyToken;
+    epoll_ctl(epollFd_, EPOLL_CTL_ADD, inotifyFd_, &registration);
+  }
+  ScanDevices();
+  if (devices_.empty()) {
+    SetFailureReason(access("/dev/input/event0", R_OK) == 0 || errno != EACCES
+                         ? "no keyboard or pointer devices found in /dev/input"
+                         : "no permission to read /dev/input/event* (add the user to the "
+                           "'input' group)");
+    return false;
+  }
+  return true;
+}
+
+void EvdevPlatformHook::Teardown() {
+  while (!devices_.empty()) {
+    CloseDevice(devices_.back().get());
+  }
+  if (inotifyFd_ >= 0) {
+    close(inotifyFd_);
+    inotifyFd_ = -1;
+  }
+  if (epollFd_ >= 0) {
+    close(epollFd_);
+    epollFd_ = -1;
+  }
+  translator_.Reset();
+}
+
+bool EvdevPlatformHook::ReadDevice(Device* device) {
+  struct input_event batch[kReadBatch];
+  auto* bytes = reinterpret_cast<unsigned char*>(batch);
+  while (running_) {
+    std::memcpy(bytes, device->partial, device->partialBytes);
+    ssize_t length = read(device->fd, bytes + device->partialBytes,
+                          sizeof(batch) - device->partialBytes);
+    if (length < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      // ENODEV means unplugged; EAGAIN just drained the queue.
+      return errno == EAGAIN;
+    }
+    if (length == 0) {
+      return false;
+    }
+
+    std::size_t available = device->partialBytes + static_cast<std::size_t>(length);
+    std::size_t count = available / sizeof(struct input_event);
+    device->partialBytes = available % sizeof(struct input_event);
+    std::memcpy(device->partial, bytes + count * sizeof(struct input_event), device->partialBytes);
+
+    for (std::size_t i = 0; i < count; ++i) {
+      const struct input_event& input = batch[i];
+      double time = input.input_event_sec * 1000.0 + input.input_event_usec / 1000.0;
+      translator_.Translate(device->axes, input.type, input.code, input.value, time,
+                            [this](InputEvent&& event) { Dispatch(std::move(event)); });
+    }
+  }
+  return true;
+}
+
+void EvdevPlatformHook::ThreadLoop() {
+  if (!Setup()) {
+    Teardown();
+    NotifyStartResult(false);
+    return;
+  }
+  NotifyStartResult(true);
+
+  // Recordings in regular files are replayed once, straight away.
+  std::vector<Device*> recordings;
+  for (const auto& device : devices_) {
+    if (device->regularFile) {
+      recordings.push_back(device.get());
+    }
+  }
+  for (Device* device : recordings) {
+    ReadDevice(device);
+    FlushSink();
+    CloseDevice(device);
+  }
+
+  struct epoll_event ready[16];
+  while (running_) {
+    int count = epoll_wait(epollFd_, ready, 16, -1);
+    if (count < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      SetFailureReason(std::string("epoll_wait failed: ") + std::strerror(errno));
+      break;
+    }
+    for (int i = 0; i < count && running_; ++i) {
+      if (ready[i].data.u64 == kWakeToken) {
+        char buffer[16];
+        while (read(wakeFds_[0], buffer, sizeof(buffer)) > 0) {
+        }
+      } else if (ready[i].data.u64 == kInotifyToken) {
+        HandleHotplug();
+      } else {
+        auto* device = static_cast<Device*>(ready[i].data.ptr);
+        if (!ReadDevice(device)) {
+          CloseDevice(device);
+          // The array may still name this device in a later slot.
+          for (int j = i + 1; j < count; ++j) {
+            if (ready[j].data.ptr == device) {
+              ready[j].data.u64 = kWakeToken;
+            }
+          }
+        }
+      }
+    }
+    FlushSink();
+  }
+
+  Teardown();
+}
+
+bool EvdevPlatformHook::Start() {
+  if (running_) {
+    return false;
+  }
+
+  SetFailureReason("");
+  if (pipe2(wakeFds_, O_CLOEXEC | O_NONBLOCK) != 0) {
+    SetFailureReason(std::string("unable to create wakeup pipe: ") + std::strerror(errno));
+    return false;
+  }
+
+  auto promise = std::make_shared<std::promise<bool>>();
+  auto future = promise->get_future();
+  {
+    std::lock_guard<std::mutex> lock(startPromiseMutex_);
+    startPromise_ = promise;
+  }
+
+  running_ = true;
+  workerThread_ = std::thread(&EvdevPlatformHook::ThreadLoop, this);
+
+  bool started = future.get();
+  if (!started) {
+    Stop();
+  }
+  return started;
+}
+
+void EvdevPlatformHook::Stop() {
+  if (!running_ && !workerThread_.joinable()) {
+    return;
+  }
+  running_ = false;
+  if (wakeFds_[1] >= 0) {
+    char byte = 0;
+    ssize_t written = write(wakeFds_[1], &byte, 1);
+    (void)written;
+  }
+  if (workerThread_.joinable()) {
+    workerThread_.join();
+  }
+  for (int& fd : wakeFds_) {
+    if (fd >= 0) {
+      close(fd);
+      fd = -1;
+    }
+  }
+}
+
+} // namespace linux
+} // namespace platform
+} // namespace inputhook
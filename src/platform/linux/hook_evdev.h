@@ -0,0 +1,63 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "../../common/emitter.h"
+#include "evdev_translator.h"
+
+namespace inputhook {
+namespace platform {
+namespace linux {
+
+// Reads kernel input events straight from /dev/input/event* (or explicitly
+// given paths), so it needs no display server: Wayland sessions and headless
+// kiosks included. Requires read access to the nodes, usually membership of
+// the `input` group.
+class EvdevPlatformHook : public PlatformHook {
+ public:
+  EvdevPlatformHook(EventSink* sink, std::vector<std::string> devices);
+  ~EvdevPlatformHook() override;
+
+  bool Start() override;
+  void Stop() override;
+  std::string GetFailureReason() const override;
+
+ private:
+  struct Device;
+
+  void ThreadLoop();
+  bool Setup();
+  void Teardown();
+  bool OpenDevice(const std::string& path, bool explicitPath, std::string* error);
+  void CloseDevice(Device* device);
+  void ScanDevices();
+  void HandleHotplug();
+  // Returns false once the device is gone (unplugged, EOF on a pipe).
+  bool ReadDevice(Device* device);
+  void NotifyStartResult(bool success);
+  void SetFailureReason(std::string reason);
+
+  std::vector<std::string> explicitDevices_;
+  std::vector<std::unique_ptr<Device>> devices_;
+  std::atomic<bool> running_{false};
+  std::thread workerThread_;
+  int epollFd_{-1};
+  int inotifyFd_{-1};
+  int wakeFds_[2]{-1, -1};
+  EvdevTranslator translator_;
+  std::mutex startPromiseMutex_;
+  std::shared_ptr<std::promise<bool>> startPromise_;
+  std::string failureReason_;
+  mutable std::mutex failureMutex_;
+};
+
+} // namespace linux
+} // namespace platform
+} // namespace inputhook
@@ -1,13 +1,22 @@
 #include "hook_x11.h"
 
+#include <X11/Xatom.h>
+#include <X11/Xlib-xcb.h>
 #include <X11/Xlib.h>
 #include <X11/extensions/XInput2.h>
 #include <X11/XKBlib.h>
+#include <xcb/xcbext.h>
 
-#include <chrono>
+#include <algorithm>
+#include <cerrno>
+#include <cstdlib>
 #include <cstring>
+#include <fcntl.h>
+#include <poll.h>
 #include <thread>
-#include <sys/time.h>
+#include <unistd.h>
+
+#include "x11_util.h"
 
 namespace inputhook {
 namespace platform {
@@ -27,19 +36,14 @@ int QueryXiOpcode(Display* display) {
   return opcode;
 }
 
-double CurrentTimeMs() {
-  struct timeval now;
-  gettimeofday(&now, nullptr);
-  return now.tv_sec * 1000.0 + now.tv_usec / 1000.0;
-}
+constexpr int64_t kInitialBackoffMs = 250;
+constexpr int64_t kMaxBackoffMs = 30000;
+// After this long without any X traffic a heartbeat round trip is sent.
+constexpr int64_t kStallCheckMs = 5000;
+constexpr int64_t kHeartbeatTimeoutMs = 3000;
 
 InputModifiers BuildModifiersFromState(const XIModifierState& state) {
-  InputModifiers modifiers;
-  modifiers.shift = (state.effective & ShiftMask) != 0;
-  modifiers.ctrl = (state.effective & ControlMask) != 0;
-  modifiers.alt = (state.effective & Mod1Mask) != 0;
-  modifiers.meta = (state.effective & Mod4Mask) != 0;
-  return modifiers;
+  return ModifiersFromMask(static_cast<unsigned int>(state.effective));
 }
 
 InputModifiers QueryKeyboardModifiers(Display* display) {
@@ -50,10 +54,7 @@ InputModifiers QueryKeyboardModifiers(Display* display) {
 
   XkbStateRec state{};
   if (XkbGetState(display, XkbUseCoreKbd, &state) == Success) {
-    modifiers.shift = (state.mods & ShiftMask) != 0;
-    modifiers.ctrl = (state.mods & ControlMask) != 0;
-    modifiers.alt = (state.mods & Mod1Mask) != 0;
-    modifiers.meta = (state.mods & Mod4Mask) != 0;
+    modifiers = ModifiersFromMask(state.mods);
   }
   return modifiers;
 }
@@ -70,89 +71,375 @@ bool IsValuatorMaskSet(const XIValuatorState& state, int axis) {
   return (maskByte & (1 << (axis % 8))) != 0;
 }
 
-bool TryWheelDeltaForButton(uint32_t button, int32_t& deltaX, int32_t& deltaY) {
-  constexpr int32_t kWheelStep = 1;
-  deltaX = 0;
-  deltaY = 0;
-  switch (button) {
-    case 4:
-      deltaY = kWheelStep;
-      return true;
-    case 5:
-      deltaY = -kWheelStep;
-      return true;
-    case 6:
-      deltaX = kWheelStep;
-      return true;
-    case 7:
-      deltaX = -kWheelStep;
-      return true;
-    default:
-      return false;
-  }
-}
-
 } // namespace
 
-LinuxPlatformHook::LinuxPlatformHook(EventCallback callback)
-    : PlatformHook(std::move(callback)) {}
+LinuxPlatformHook::LinuxPlatformHook(EventSink* sink)
+    : PlatformHook(sink) {}
 
 LinuxPlatformHook::~LinuxPlatformHook() {
   Stop();
 }
 
-void LinuxPlatformHook::ThreadLoop() {
+void LinuxPlatformHook::NotifyStartResult(bool success) {
+  std::shared_ptr<std::promise<bool>> promise;
+  {
+    std::lock_guard<std::mutex> lock(startPromiseMutex_);
+    promise = std::move(startPromise_);
+  }
+  if (promise) {
+    promise->set_value(success);
+  }
+}
+
+std::string LinuxPlatformHook::GetLastError() const {
+  std::lock_guard<std::mutex> lock(lastErrorMutex_);
+  return lastError_;
+}
+
+void LinuxPlatformHook::SetLastError(std::string reason) {
+  std::lock_guard<std::mutex> lock(lastErrorMutex_);
+  lastError_ = std::move(reason);
+}
+
+HookStats LinuxPlatformHook::GetStats() const {
+  HookStats stats;
+  stats.reconnects = reconnects_.load(std::memory_order_relaxed);
+  return stats;
+}
+
+std::string LinuxPlatformHook::GetFailureReason() const {
+  std::lock_guard<std::mutex> lock(failureMutex_);
+  return failureReason_;
+}
+
+void LinuxPlatformHook::SetFailureReason(std::string reason) {
+  std::lock_guard<std::mutex> lock(failureMutex_);
+  failureReason_ = std::move(reason);
+}
+
+bool LinuxPlatformHook::OpenConnection(std::string* error) {
   display_ = XOpenDisplay(nullptr);
   if (!display_) {
-    running_ = false;
-    return;
+    const char* name = std::getenv("DISPLAY");
+    *error = std::string("unable to open X display ") +
+             (name && *name ? name : "(DISPLAY is not set)");
+    return false;
   }
+  xcb_ = XGetXCBConnection(display_);
+  connectionLost_.store(false, std::memory_order_release);
+#if INPUTHOOK_X11_IOERROR_EXIT
+  XSetIOErrorExitHandler(display_, &LinuxPlatformHook::OnIOErrorExit, this);
+#endif
 
   xiOpcode_ = QueryXiOpcode(display_);
   if (xiOpcode_ < 0) {
-    running_ = false;
-    XCloseDisplay(display_);
-    display_ = nullptr;
-    return;
+    *error = "X server does not support XInput2";
+    CloseConnection();
+    return false;
   }
 
-  Window root = DefaultRootWindow(display_);
-  XIEventMask mask;
+  randrEventBase_ = WatchMonitorLayout(display_, &haveMonitors_, &monitors_);
+  InputEvent focus;
+  if (activeWindow_.Watch(display_, &focus)) {
+    Dispatch(std::move(focus));
+  }
+  InputEvent lock;
+  if (screenLock_.Watch(display_, &lock)) {
+    Dispatch(std::move(lock));
+  }
+  SelectInputEvents(ShouldCapture());
+  if (!CreateHeartbeatWindow()) {
+    *error = "unable to create the heartbeat window";
+    CloseConnection();
+    return false;
+  }
+  // Once the round trip returns the server has applied the selection, so
+  // events from here on are delivered.
+  XSync(display_, False);
+  return true;
+}
+
+void LinuxPlatformHook::SelectInputEvents(bool enabled) {
   unsigned char maskBytes[XIMaskLen(XI_LASTEVENT)];
   memset(maskBytes, 0, sizeof(maskBytes));
-  XISetMask(maskBytes, XI_KeyPress);
-  XISetMask(maskBytes, XI_KeyRelease);
-  XISetMask(maskBytes, XI_RawKeyPress);
-  XISetMask(maskBytes, XI_RawKeyRelease);
-  XISetMask(maskBytes, XI_RawButtonPress);
-  XISetMask(maskBytes, XI_RawButtonRelease);
-  XISetMask(maskBytes, XI_ButtonPress);
-  XISetMask(maskBytes, XI_ButtonRelease);
-  XISetMask(maskBytes, XI_Motion);
-  XISetMask(maskBytes, XI_RawMotion);
+  if (enabled) {
+    XISetMask(maskBytes, XI_KeyPress);
+    XISetMask(maskBytes, XI_KeyRelease);
+    XISetMask(maskBytes, XI_RawKeyPress);
+    XISetMask(maskBytes, XI_RawKeyRelease);
+    XISetMask(maskBytes, XI_RawButtonPress);
+    XISetMask(maskBytes, XI_RawButtonRelease);
+    XISetMask(maskBytes, XI_ButtonPress);
+    XISetMask(maskBytes, XI_ButtonRelease);
+    XISetMask(maskBytes, XI_Motion);
+    XISetMask(maskBytes, XI_RawMotion);
+  }
+  // An all-zero mask deselects everything, so a paused server sends no input
+  // at all instead of events we would only drop.
+  XIEventMask mask;
   mask.deviceid = XIAllMasterDevices;
   mask.mask_len = sizeof(maskBytes);
   mask.mask = maskBytes;
+  XISelectEvents(display_, DefaultRootWindow(display_), &mask, 1);
+  inputSelected_ = enabled;
+}
+
+bool LinuxPlatformHook::ShouldCapture() const {
+  return !IsPaused() && !screenLock_.Locked();
+}
+
+void LinuxPlatformHook::ApplyCapture() {
+  bool enabled = ShouldCapture();
+  SelectInputEvents(enabled);
+  if (enabled) {
+    // Focus changes during a pause were dropped.
+    InputEvent focus;
+    if (activeWindow_.Reannounce(&focus)) {
+      Dispatch(std::move(focus));
+    }
+  }
+  XFlush(display_);
+}
+
+bool LinuxPlatformHook::OnPauseChanged() {
+  Wake();
+  return true;
+}
+
+void LinuxPlatformHook::OnFocusRequested() {
+  Wake();
+}
+
+void LinuxPlatformHook::CloseConnection() {
+  if (!display_) {
+    return;
+  }
+  if (heartbeatWindow_ && !connectionLost_.load(std::memory_order_acquire)) {
+    XDestroyWindow(display_, heartbeatWindow_);
+  }
+  heartbeatWindow_ = 0;
+  held_.clear();
+  positionRequested_ = false;
+  pointerKnown_ = false;
+  activeWindow_.Stop();
+  XCloseDisplay(display_);
+  display_ = nullptr;
+  xcb_ = nullptr;
+  xiOpcode_ = 0;
+  randrEventBase_ = -1;
+}
+
+void LinuxPlatformHook::OnIOErrorExit(Display* /*display*/, void* userData) {
+  // Returning keeps Xlib from exiting the process; the display is dead from
+  // here on and only XCloseDisplay may touch it.
+  auto* self = static_cast<LinuxPlatformHook*>(userData);
+  self->connectionLost_.store(true, std::memory_order_release);
+}
+
+bool LinuxPlatformHook::CreateHeartbeatWindow() {
+  heartbeatAtom_ = XInternAtom(display_, "_INPUTHOOK_HEARTBEAT", False);
+  heartbeatWindow_ = XCreateSimpleWindow(display_, DefaultRootWindow(display_),
+                                         -1, -1, 1, 1, 0, 0, 0);
+  if (!heartbeatWindow_) {
+    return false;
+  }
+  XSelectInput(display_, heartbeatWindow_, PropertyChangeMask);
+  return true;
+}
+
+void LinuxPlatformHook::SendHeartbeat() {
+  // A zero-length property change is answered with PropertyNotify, proving
+  // the server still processes our requests.
+  XChangeProperty(display_, heartbeatWindow_, heartbeatAtom_, XA_CARDINAL, 32,
+                  PropModeReplace, nullptr, 0);
+  XFlush(display_);
+  heartbeatSentMs_ = NowSteadyMs();
+}
+
+LinuxPlatformHook::WaitResult LinuxPlatformHook::WaitForEvents() {
+  int64_t now = NowSteadyMs();
+  int64_t deadline = heartbeatSentMs_ ? heartbeatSentMs_ + kHeartbeatTimeoutMs
+                                      : lastTrafficMs_ + kStallCheckMs;
+  if (now >= deadline) {
+    if (heartbeatSentMs_) {
+      return WaitResult::Lost;
+    }
+    SendHeartbeat();
+    return WaitResult::Timeout;
+  }
 
-  XISelectEvents(display_, root, &mask, 1);
+  struct pollfd fds[2];
+  fds[0].fd = ConnectionNumber(display_);
+  fds[0].events = POLLIN | POLLRDHUP;
+  fds[1].fd = wakeFds_[0];
+  fds[1].events = POLLIN;
+  int ready = poll(fds, 2, static_cast<int>(deadline - now));
+  if (ready < 0) {
+    return WaitResult::Timeout;
+  }
+  if (fds[1].revents & POLLIN) {
+    char buffer[16];
+    while (read(wakeFds_[0], buffer, sizeof(buffer)) > 0) {
+    }
+  }
+  // Catch a closed socket here, before Xlib reads the EOF and raises an IO
+  // error.
+  if (fds[0].revents & (POLLRDHUP | POLLHUP | POLLERR | POLLNVAL)) {
+    return WaitResult::Lost;
+  }
+  return ready > 0 ? WaitResult::Ready : WaitResult::Timeout;
+}
 
+bool LinuxPlatformHook::SleepInterruptible(int64_t delayMs) {
+  struct pollfd fd;
+  fd.fd = wakeFds_[0];
+  fd.events = POLLIN;
+  int64_t deadline = NowSteadyMs() + delayMs;
+  while (running_) {
+    int64_t remaining = deadline - NowSteadyMs();
+    if (remaining <= 0) {
+      return true;
+    }
+    poll(&fd, 1, static_cast<int>(remaining));
+    if (fd.revents & POLLIN) {
+      char buffer[16];
+      while (read(wakeFds_[0], buffer, sizeof(buffer)) > 0) {
+      }
+    }
+  }
+  return false;
+}
+
+void LinuxPlatformHook::Wake() {
+  if (wakeFds_[1] >= 0) {
+    char byte = 0;
+    ssize_t written = write(wakeFds_[1], &byte, 1);
+    (void)written;
+  }
+}
+
+void LinuxPlatformHook::ThreadLoop() {
+  bool announced = false;
+  int64_t backoffMs = kInitialBackoffMs;
+  while (running_) {
+    std::string error;
+    if (!OpenConnection(&error)) {
+      // The first connection decides Start(); later ones retry until Stop()
+      // and leave the start failure reason alone.
+      if (!announced) {
+        SetFailureReason(error);
+        NotifyStartResult(false);
+        return;
+      }
+      SetLastError("reconnect failed: " + error);
+      if (!SleepInterruptible(backoffMs)) {
+        break;
+      }
+      backoffMs = std::min(backoffMs * 2, kMaxBackoffMs);
+      continue;
+    }
+
+    if (!announced) {
+      announced = true;
+      NotifyStartResult(true);
+    } else {
+      reconnects_.fetch_add(1, std::memory_order_relaxed);
+      SetLastError("");
+    }
+    backoffMs = kInitialBackoffMs;
+
+    bool stopped = RunConnection();
+    ReleaseAllHeldEvents();
+    // RunConnection can leave mid-batch; end the batch so a coalesced
+    // motion is delivered before the connection goes.
+    FlushSink();
+    if (stopped) {
+      CloseConnection();
+      break;
+    }
+    // Keys released while disconnected are never reported.
+    ResetSink();
+    CloseConnection();
+    if (!SleepInterruptible(backoffMs)) {
+      break;
+    }
+  }
+}
+
+bool LinuxPlatformHook::RunConnection() {
   rawKeyboardSeen_.store(false, std::memory_order_release);
   rawPointerSeen_.store(false, std::memory_order_release);
+  lastTrafficMs_ = NowSteadyMs();
+  heartbeatSentMs_ = 0;
 
   XEvent event;
   while (running_) {
+    if (connectionLost_.load(std::memory_order_acquire)) {
+      SetLastError("X connection lost; reconnecting");
+      return false;
+    }
+    if (inputSelected_ != ShouldCapture()) {
+      ApplyCapture();
+    }
+    // While not capturing, resuming reports the focus anyway.
+    if (TakeFocusRequest() && inputSelected_) {
+      InputEvent focus;
+      if (activeWindow_.Reannounce(&focus)) {
+        Dispatch(std::move(focus));
+      }
+    }
+
+    // XPending also drains whatever the connection has already buffered
+    // (including position replies), so poll() is only reached when there is
+    // truly nothing to read.
     if (XPending(display_) == 0) {
-      std::this_thread::sleep_for(std::chrono::milliseconds(10));
+      if (ReleaseHeldEvents()) {
+        continue;
+      }
+      // The queue is drained: this is the end of the batch.
+      FlushSink();
+      InputEvent lock;
+      if (screenLock_.Poll(NowSteadyMs(), &lock)) {
+        Dispatch(std::move(lock));
+        continue;
+      }
+      if (connectionLost_.load(std::memory_order_acquire)) {
+        continue;
+      }
+      WaitResult result = WaitForEvents();
+      if (result == WaitResult::Lost) {
+        SetLastError(heartbeatSentMs_ ? "X connection stalled; reconnecting"
+                                      : "X connection closed; reconnecting");
+        return false;
+      }
       continue;
     }
+    ReleaseHeldEvents();
 
     XNextEvent(display_, &event);
+    lastTrafficMs_ = NowSteadyMs();
+    heartbeatSentMs_ = 0;
     if (!running_) {
       break;
     }
 
+    if (HandleMonitorLayoutEvent(display_, randrEventBase_, haveMonitors_, &event, &monitors_)) {
+      continue;
+    }
+    InputEvent focus;
+    if (activeWindow_.HandleEvent(event, &focus)) {
+      Deliver(std::move(focus), false);
+      continue;
+    }
+    InputEvent lock;
+    if (screenLock_.HandleEvent(event, &lock)) {
+      Deliver(std::move(lock), false);
+      continue;
+    }
+    // Input still in flight when the selection was cleared is not
+    // translated.
     if (event.type != GenericEvent ||
-        event.xgeneric.extension != xiOpcode_) {
+        event.xgeneric.extension != xiOpcode_ || !inputSelected_) {
       continue;
     }
 
@@ -165,6 +452,7 @@ void LinuxPlatformHook::ThreadLoop() {
 
     InputModifiers modifiers;
     bool shouldDispatch = false;
+    bool needsPosition = false;
     int evtype = event.xcookie.evtype;
 
     switch (evtype) {
@@ -181,21 +469,22 @@ void LinuxPlatformHook::ThreadLoop() {
       }
       case XI_RawButtonPress:
       case XI_RawButtonRelease: {
-        modifiers = QueryKeyboardModifiers(display_);
+        // Position and modifiers come with the pointer reply.
         shouldDispatch = ProcessRawButtonEvent(reinterpret_cast<XIRawEvent*>(event.xcookie.data),
                                                inputEvent,
                                                evtype);
         if (shouldDispatch) {
           rawPointerSeen_.store(true, std::memory_order_release);
+          needsPosition = true;
         }
         break;
       }
       case XI_RawMotion: {
-        modifiers = QueryKeyboardModifiers(display_);
         shouldDispatch = ProcessRawMotionEvent(reinterpret_cast<XIRawEvent*>(event.xcookie.data),
                                                inputEvent);
         if (shouldDispatch) {
           rawPointerSeen_.store(true, std::memory_order_release);
+          needsPosition = true;
         }
         break;
       }
@@ -212,17 +501,91 @@ void LinuxPlatformHook::ThreadLoop() {
 
     inputEvent.modifiers = modifiers;
     if (shouldDispatch) {
-      Dispatch(std::move(inputEvent));
+      activeWindow_.Annotate(inputEvent);
+      Deliver(std::move(inputEvent), needsPosition);
     }
 
     XFreeEventData(display_, &event.xcookie);
   }
+  return true;
+}
+
+void LinuxPlatformHook::Deliver(InputEvent&& event, bool needsPosition) {
+  if (!needsPosition && held_.empty()) {
+    monitors_.Annotate(event);
+    Dispatch(std::move(event));
+    return;
+  }
+  held_.push_back({std::move(event), needsPosition});
+  if (needsPosition && !positionRequested_) {
+    RequestPointerPosition();
+  }
+}
+
+void LinuxPlatformHook::RequestPointerPosition() {
+  // XCB lets the request go out without waiting for its reply; Xlib flushes
+  // its own buffered requests first, so ordering is kept.
+  xcb_query_pointer_cookie_t cookie = xcb_query_pointer(xcb_, DefaultRootWindow(display_));
+  xcb_flush(xcb_);
+  positionRequested_ = true;
+  positionSequence_ = cookie.sequence;
+  positionCovers_ = held_.size();
+}
+
+bool LinuxPlatformHook::ReleaseHeldEvents() {
+  if (!positionRequested_) {
+    return false;
+  }
+  void* reply = nullptr;
+  xcb_generic_error_t* error = nullptr;
+  if (!xcb_poll_for_reply(xcb_, positionSequence_, &reply, &error)) {
+    return false;
+  }
+  positionRequested_ = false;
+  if (reply) {
+    auto* pointer = static_cast<xcb_query_pointer_reply_t*>(reply);
+    pointerX_ = pointer->root_x;
+    pointerY_ = pointer->root_y;
+    pointerMask_ = pointer->mask;
+    pointerKnown_ = true;
+    std::free(reply);
+  }
+  std::free(error);
+
+  for (std::size_t i = 0; i < positionCovers_ && !held_.empty(); ++i) {
+    HeldEvent held = std::move(held_.front());
+    held_.pop_front();
+    Release(std::move(held));
+  }
+  while (!held_.empty() && !held_.front().needsPosition) {
+    HeldEvent held = std::move(held_.front());
+    held_.pop_front();
+    Release(std::move(held));
+  }
+  // Pointer events that arrived after the request need a newer position.
+  if (!held_.empty()) {
+    RequestPointerPosition();
+  }
+  return true;
+}
+
+void LinuxPlatformHook::ReleaseAllHeldEvents() {
+  while (!held_.empty()) {
+    HeldEvent held = std::move(held_.front());
+    held_.pop_front();
+    Release(std::move(held));
+  }
+  positionRequested_ = false;
+}
 
-  if (display_) {
-    XCloseDisplay(display_);
-    display_ = nullptr;
-    xiOpcode_ = 0;
+void LinuxPlatformHook::Release(HeldEvent&& held) {
+  if (held.needsPosition && pointerKnown_) {
+    held.event.x = pointerX_;
+    held.event.y = pointerY_;
+    held.event.modifiers = ModifiersFromMask(pointerMask_);
   }
+  monitors_.Annotate(held.event);
+  Dispatch(std::move(held.event));
 }
 
 void LinuxPlatformHook::ProcessDeviceEvent(XIDeviceEvent* event,
@@ -241,8 +604,7 @@ void LinuxPlatformHook::ProcessDeviceEvent(XIDeviceEvent* event,
         return;
       }
       inputEvent.type = "keydown";
-      inputEvent.keycode = event->detail;
-      inputEvent.scancode = event->detail;
+      AssignKeyCodes(inputEvent, static_cast<uint32_t>(event->detail));
       break;
     case XI_KeyRelease:
       if (skipKeyboardEvents) {
@@ -250,8 +612,7 @@ void LinuxPlatformHook::ProcessDeviceEvent(XIDeviceEvent* event,
         return;
       }
       inputEvent.type = "keyup";
-      inputEvent.keycode = event->detail;
-      inputEvent.scancode = event->detail;
+      AssignKeyCodes(inputEvent, static_cast<uint32_t>(event->detail));
       break;
     case XI_ButtonPress:
       if (skipPointerEvents) {
@@ -290,8 +651,7 @@ bool LinuxPlatformHook::ProcessRawKeyEvent(XIRawEvent* event,
   if (!event) {
     return false;
   }
-  inputEvent.keycode = event->detail;
-  inputEvent.scancode = event->detail;
+  AssignKeyCodes(inputEvent, static_cast<uint32_t>(event->detail));
   inputEvent.type = (evtype == XI_RawKeyPress) ? "keydown" : "keyup";
   return true;
 }
@@ -309,9 +669,11 @@ bool LinuxPlatformHook::ProcessRawButtonEvent(XIRawEvent* event,
     return true;
   }
 
+  // Wheel buttons report a press and a release per notch; only the press is
+  // a scroll step.
   int32_t deltaX = 0;
   int32_t deltaY = 0;
-  if (TryWheelDeltaForButton(detail, deltaX, deltaY)) {
+  if (evtype == XI_RawButtonPress && TryWheelDeltaForButton(detail, deltaX, deltaY)) {
     inputEvent.type = "wheel";
     if (deltaX) {
       inputEvent.deltaX = deltaX;
@@ -367,13 +729,11 @@ bool LinuxPlatformHook::ProcessRawMotionEvent(XIRawEvent* event,
     return false;
   }
 
+  // Both axes are always reported, as the other backends do; an axis the
+  // device did not move is 0.
   inputEvent.type = "mousemove";
-  if (hasDeltaX) {
-    inputEvent.deltaX = static_cast<int32_t>(deltaX);
-  }
-  if (hasDeltaY) {
-    inputEvent.deltaY = static_cast<int32_t>(deltaY);
-  }
+  inputEvent.deltaX = static_cast<int32_t>(deltaX);
+  inputEvent.deltaY = static_cast<int32_t>(deltaY);
   return true;
 }
 
@@ -381,19 +741,46 @@ bool LinuxPlatformHook::Start() {
   if (running_) {
     return false;
   }
+
+  SetFailureReason("");
+  if (pipe2(wakeFds_, O_CLOEXEC | O_NONBLOCK) != 0) {
+    SetFailureReason(std::string("unable to create wakeup pipe: ") + std::strerror(errno));
+    return false;
+  }
+
+  auto promise = std::make_shared<std::promise<bool>>();
+  auto future = promise->get_future();
+  {
+    std::lock_guard<std::mutex> lock(startPromiseMutex_);
+    startPromise_ = promise;
+  }
+
   running_ = true;
   workerThread_ = std::thread(&LinuxPlatformHook::ThreadLoop, this);
-  return true;
+
+  // Only report success once the XI2 selection is active on the server.
+  bool started = future.get();
+  if (!started) {
+    Stop();
+  }
+  return started;
 }
 
 void LinuxPlatformHook::Stop() {
-  if (!running_) {
+  if (!running_ && !workerThread_.joinable()) {
     return;
   }
   running_ = false;
+  Wake();
   if (workerThread_.joinable()) {
     workerThread_.join();
   }
+  for (int& fd : wakeFds_) {
+    if (fd >= 0) {
+      close(fd);
+      fd = -1;
+    }
+  }
 }
 
 } // namespace linux
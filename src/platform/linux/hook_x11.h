@@ -2,11 +2,21 @@
 
 #include <X11/Xlib.h>
 #include <X11/extensions/XInput2.h>
+#include <xcb/xcb.h>
 
 #include <atomic>
+#include <cstdint>
+#include <deque>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <string>
 #include <thread>
 
 #include "../../common/emitter.h"
+#include "../../common/monitors.h"
+#include "x11_focus.h"
+#include "x11_lock.h"
 
 namespace inputhook {
 namespace platform {
@@ -14,14 +24,46 @@ namespace linux {
 
 class LinuxPlatformHook : public PlatformHook {
  public:
-  explicit LinuxPlatformHook(EventCallback callback);
+  explicit LinuxPlatformHook(EventSink* sink);
   ~LinuxPlatformHook() override;
 
   bool Start() override;
   void Stop() override;
+  std::string GetFailureReason() const override;
+  std::string GetLastError() const override;
+  HookStats GetStats() const override;
 
  private:
+  enum class WaitResult { Ready, Timeout, Lost };
+
+  struct HeldEvent {
+    InputEvent event;
+    bool needsPosition;
+  };
+
+  static void OnIOErrorExit(Display* display, void* userData);
+
+  // Supervises connections: reconnects with exponential backoff whenever
+  // RunConnection() reports the X connection lost or stalled.
   void ThreadLoop();
+  // Returns true when stopped, false when the connection was lost.
+  bool RunConnection();
+  bool OpenConnection(std::string* error);
+  void CloseConnection();
+  // Selects the XI2 input events, or none while paused or locked.
+  void SelectInputEvents(bool enabled);
+  bool ShouldCapture() const;
+  void ApplyCapture();
+  bool OnPauseChanged() override;
+  void OnFocusRequested() override;
+  bool CreateHeartbeatWindow();
+  void SendHeartbeat();
+  WaitResult WaitForEvents();
+  bool SleepInterruptible(int64_t delayMs);
+  void Wake();
+  void NotifyStartResult(bool success);
+  void SetFailureReason(std::string reason);
+  void SetLastError(std::string reason);
   void ProcessDeviceEvent(XIDeviceEvent* event,
                           InputEvent& inputEvent,
                           bool skipKeyboardEvents,
@@ -33,13 +75,56 @@ class LinuxPlatformHook : public PlatformHook {
                              InputEvent& inputEvent,
                              int evtype);
   bool ProcessRawMotionEvent(XIRawEvent* event, InputEvent& inputEvent);
+  // Raw XI2 events carry no position. Pointer events wait for the reply to a
+  // QueryPointer sent after they arrived, which gives the real cursor
+  // position without blocking on a round trip; anything queued behind them
+  // waits too so order is kept.
+  void Deliver(InputEvent&& event, bool needsPosition);
+  void RequestPointerPosition();
+  // Returns true when a position reply arrived and held events went out.
+  bool ReleaseHeldEvents();
+  // Sends whatever is still held, with the last known position.
+  void ReleaseAllHeldEvents();
+  void Release(HeldEvent&& held);
 
   std::atomic<bool> running_{false};
   std::atomic<bool> rawKeyboardSeen_{false};
   std::atomic<bool> rawPointerSeen_{false};
   std::thread workerThread_;
   Display* display_{nullptr};
+  xcb_connection_t* xcb_{nullptr};
   int xiOpcode_{0};
+  // Whether the root window currently selects input; hook thread only.
+  bool inputSelected_{false};
+  int randrEventBase_{-1};
+  bool haveMonitors_{false};
+  MonitorLayout monitors_;
+  ActiveWindowWatcher activeWindow_;
+  ScreenLockWatcher screenLock_;
+  // Hook thread only.
+  std::deque<HeldEvent> held_;
+  bool positionRequested_{false};
+  unsigned int positionSequence_{0};
+  // Number of events at the front of held_ the outstanding request answers.
+  std::size_t positionCovers_{0};
+  bool pointerKnown_{false};
+  int32_t pointerX_{0};
+  int32_t pointerY_{0};
+  unsigned int pointerMask_{0};
+  std::atomic<bool> connectionLost_{false};
+  std::atomic<uint64_t> reconnects_{0};
+  Window heartbeatWindow_{0};
+  Atom heartbeatAtom_{0};
+  int64_t heartbeatSentMs_{0};
+  int64_t lastTrafficMs_{0};
+  // Written by Stop() so the worker leaves poll() without waiting for input.
+  int wakeFds_[2]{-1, -1};
+  std::mutex startPromiseMutex_;
+  std::shared_ptr<std::promise<bool>> startPromise_;
+  std::string failureReason_;
+  mutable std::mutex failureMutex_;
+  std::string lastError_;
+  mutable std::mutex lastErrorMutex_;
 };
 
 } // namespace linux
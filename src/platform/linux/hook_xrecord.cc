@@ -0,0 +1,421 @@
+#include "hook_xrecord.h"
+
+#include <X11/Xproto.h>
+
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+
+#include "x11_util.h"
+
+namespace inputhook {
+namespace platform {
+namespace linux {
+
+namespace {
+// How long the server gets to open the data stream before Start() fails.
+constexpr int64_t kStartTimeoutMs = 2000;
+} // namespace
+
+XRecordPlatformHook::XRecordPlatformHook(EventSink* sink)
+    : PlatformHook(sink) {}
+
+XRecordPlatformHook::~XRecordPlatformHook() {
+  Stop();
+}
+
+void XRecordPlatformHook::NotifyStartResult(bool success) {
+  std::shared_ptr<std::promise<bool>> promise;
+  {
+    std::lock_guard<std::mutex> lock(startPromiseMutex_);
+    promise = std::move(startPromise_);
+  }
+  if (promise) {
+    promise->set_value(success);
+  }
+}
+
+std::string XRecordPlatformHook::GetFailureReason() const {
+  std::lock_guard<std::mutex> lock(failureMutex_);
+  return failureReason_;
+}
+
+void XRecordPlatformHook::SetFailureReason(std::string reason) {
+  std::lock_guard<std::mutex> lock(failureMutex_);
+  failureReason_ = std::move(reason);
+}
+
+bool XRecordPlatformHook::OpenContext() {
+  controlDisplay_ = XOpenDisplay(nullptr);
+  dataDisplay_ = controlDisplay_ ? XOpenDisplay(nullptr) : nullptr;
+  if (!controlDisplay_ || !dataDisplay_) {
+    const char* name = std::getenv("DISPLAY");
+    SetFailureReason(std::string("unable to open X display ") +
+                     (name && *name ? name : "(DISPLAY is not set)"));
+    return false;
+  }
+#if INPUTHOOK_X11_IOERROR_EXIT
+  XSetIOErrorExitHandler(controlDisplay_, &XRecordPlatformHook::OnIOErrorExit, this);
+  XSetIOErrorExitHandler(dataDisplay_, &XRecordPlatformHook::OnIOErrorExit, this);
+#endif
+
+  int major = 0;
+  int minor = 0;
+  if (!XRecordQueryVersion(controlDisplay_, &major, &minor)) {
+    SetFailureReason("X server does not support the RECORD extension");
+    return false;
+  }
+
+  XRecordRange* range = XRecordAllocRange();
+  if (!range) {
+    SetFailureReason("XRecordAllocRange failed");
+    return false;
+  }
+  range->device_events.first = KeyPress;
+  range->device_events.last = MotionNotify;
+  XRecordClientSpec clients = XRecordAllClients;
+  context_ = XRecordCreateContext(controlDisplay_, 0, &clients, 1, &range, 1);
+  XFree(range);
+  if (!context_) {
+    SetFailureReason("XRecordCreateContext failed");
+    return false;
+  }
+  randrEventBase_ = WatchMonitorLayout(controlDisplay_, &haveMonitors_, &monitors_);
+  InputEvent focus;
+  if (activeWindow_.Watch(controlDisplay_, &focus)) {
+    Dispatch(std::move(focus));
+  }
+  InputEvent lock;
+  if (screenLock_.Watch(controlDisplay_, &lock)) {
+    Dispatch(std::move(lock));
+  }
+  // The data connection must see the context before enabling it.
+  XSync(controlDisplay_, False);
+
+  if (!XRecordEnableContextAsync(dataDisplay_, context_, &XRecordPlatformHook::OnIntercept,
+                                 reinterpret_cast<XPointer>(this))) {
+    SetFailureReason("XRecordEnableContextAsync failed");
+    return false;
+  }
+  recording_ = true;
+  return true;
+}
+
+// Disabling the context stops the server from copying every input event to
+// us; it is re-enabled on the same connections once the EndOfData of the
+// previous run has been read.
+bool XRecordPlatformHook::ShouldCapture() const {
+  return !IsPaused() && !screenLock_.Locked();
+}
+
+void XRecordPlatformHook::ApplyCapture() {
+  if (!ShouldCapture()) {
+    XRecordDisableContext(controlDisplay_, context_);
+    XFlush(controlDisplay_);
+    recording_ = false;
+    return;
+  }
+  if (!dataEnded_) {
+    return;
+  }
+  dataEnded_ = false;
+  if (!XRecordEnableContextAsync(dataDisplay_, context_, &XRecordPlatformHook::OnIntercept,
+                                 reinterpret_cast<XPointer>(this))) {
+    SetFailureReason("XRecordEnableContextAsync failed");
+    return;
+  }
+  recording_ = true;
+  // Focus changes during a pause were dropped.
+  InputEvent focus;
+  if (activeWindow_.Reannounce(&focus)) {
+    Dispatch(std::move(focus));
+  }
+}
+
+bool XRecordPlatformHook::OnPauseChanged() {
+  Wake();
+  return true;
+}
+
+void XRecordPlatformHook::OnFocusRequested() {
+  Wake();
+}
+
+void XRecordPlatformHook::Wake() {
+  if (wakeFds_[1] >= 0) {
+    char byte = 0;
+    ssize_t written = write(wakeFds_[1], &byte, 1);
+    (void)written;
+  }
+}
+
+void XRecordPlatformHook::CloseContext(bool connectionAlive) {
+  if (context_ && controlDisplay_ && connectionAlive) {
+    if (recording_) {
+      XRecordDisableContext(controlDisplay_, context_);
+    }
+    XSync(controlDisplay_, False);
+    if (dataDisplay_) {
+      // Drain the EndOfData reply so the context can be freed cleanly.
+      XRecordProcessReplies(dataDisplay_);
+    }
+    XRecordFreeContext(controlDisplay_, context_);
+  }
+  context_ = 0;
+  recording_ = false;
+  if (dataDisplay_) {
+    XCloseDisplay(dataDisplay_);
+    dataDisplay_ = nullptr;
+  }
+  if (controlDisplay_) {
+    activeWindow_.Stop();
+    XCloseDisplay(controlDisplay_);
+    controlDisplay_ = nullptr;
+  }
+}
+
+void XRecordPlatformHook::OnIOErrorExit(Display* /*display*/, void* userData) {
+  // Returning keeps Xlib from exiting the process; the loop notices the flag
+  // and closes both connections.
+  auto* self = static_cast<XRecordPlatformHook*>(userData);
+  self->connectionLost_.store(true, std::memory_order_release);
+}
+
+void XRecordPlatformHook::OnIntercept(XPointer closure, XRecordInterceptData* data) {
+  auto* self = reinterpret_cast<XRecordPlatformHook*>(closure);
+  if (data->category == XRecordStartOfData) {
+    self->dataStarted_ = true;
+  } else if (data->category == XRecordEndOfData) {
+    self->dataEnded_ = true;
+  } else if (data->category == XRecordFromServer && self->recording_ && data->data &&
+             data->data_len * 4 >= sizeof(xEvent)) {
+    self->HandleEvent(data->data);
+  }
+  XRecordFreeData(data);
+}
+
+void XRecordPlatformHook::HandleEvent(const unsigned char* data) {
+  const auto* event = reinterpret_cast<const xEvent*>(data);
+  int type = event->u.u.type & 0x7F;
+  uint32_t detail = event->u.u.detail;
+
+  InputEvent inputEvent;
+  inputEvent.time = CurrentTimeMs();
+  inputEvent.modifiers = ModifiersFromMask(event->u.keyButtonPointer.state);
+
+  switch (type) {
+    case KeyPress:
+    case KeyRelease:
+      inputEvent.type = type == KeyPress ? "keydown" : "keyup";
+      AssignKeyCodes(inputEvent, detail);
+      break;
+    case ButtonPress:
+    case ButtonRelease: {
+      if (detail >= 1 && detail <= 3) {
+        inputEvent.type = type == ButtonPress ? "mousedown" : "mouseup";
+        inputEvent.button = detail - 1;
+        inputEvent.x = event->u.keyButtonPointer.rootX;
+        inputEvent.y = event->u.keyButtonPointer.rootY;
+        break;
+      }
+      int32_t deltaX = 0;
+      int32_t deltaY = 0;
+      if (type != ButtonPress || !TryWheelDeltaForButton(detail, deltaX, deltaY)) {
+        return;
+      }
+      inputEvent.type = "wheel";
+      inputEvent.x = event->u.keyButtonPointer.rootX;
+      inputEvent.y = event->u.keyButtonPointer.rootY;
+      if (deltaX) {
+        inputEvent.deltaX = deltaX;
+      }
+      if (deltaY) {
+        inputEvent.deltaY = deltaY;
+      }
+      break;
+    }
+    case MotionNotify: {
+      // Core motion only has the root position; the deltas are the distance
+      // from the previous one, so they include pointer acceleration where
+      // xi2's raw deltas do not.
+      int32_t x = event->u.keyButtonPointer.rootX;
+      int32_t y = event->u.keyButtonPointer.rootY;
+      inputEvent.type = "mousemove";
+      inputEvent.x = x;
+      inputEvent.y = y;
+      inputEvent.deltaX = havePointer_ ? x - pointerX_ : 0;
+      inputEvent.deltaY = havePointer_ ? y - pointerY_ : 0;
+      havePointer_ = true;
+      pointerX_ = x;
+      pointerY_ = y;
+      break;
+    }
+    default:
+      return;
+  }
+  monitors_.Annotate(inputEvent);
+  activeWindow_.Annotate(inputEvent);
+  Dispatch(std::move(inputEvent));
+}
+
+void XRecordPlatformHook::DrainControlEvents() {
+  XEvent event;
+  while (!connectionLost_.load(std::memory_order_acquire) && XPending(controlDisplay_) > 0) {
+    XNextEvent(controlDisplay_, &event);
+    if (HandleMonitorLayoutEvent(controlDisplay_, randrEventBase_, haveMonitors_, &event,
+                                 &monitors_)) {
+      continue;
+    }
+    InputEvent focus;
+    if (activeWindow_.HandleEvent(event, &focus)) {
+      Dispatch(std::move(focus));
+      continue;
+    }
+    InputEvent lock;
+    if (screenLock_.HandleEvent(event, &lock)) {
+      Dispatch(std::move(lock));
+    }
+  }
+  InputEvent lock;
+  if (!connectionLost_.load(std::memory_order_acquire) &&
+      screenLock_.Poll(NowSteadyMs(), &lock)) {
+    Dispatch(std::move(lock));
+  }
+}
+
+void XRecordPlatformHook::ThreadLoop() {
+  dataStarted_ = false;
+  dataEnded_ = false;
+  havePointer_ = false;
+  connectionLost_.store(false, std::memory_order_release);
+  if (!OpenContext()) {
+    CloseContext(!connectionLost_.load(std::memory_order_acquire));
+    NotifyStartResult(false);
+    return;
+  }
+
+  bool announced = false;
+  bool connectionAlive = true;
+  int64_t startDeadline = NowSteadyMs() + kStartTimeoutMs;
+  struct pollfd fds[3];
+  fds[0].fd = ConnectionNumber(dataDisplay_);
+  fds[0].events = POLLIN | POLLRDHUP;
+  fds[1].fd = wakeFds_[0];
+  fds[1].events = POLLIN;
+  fds[2].fd = ConnectionNumber(controlDisplay_);
+  fds[2].events = POLLIN | POLLRDHUP;
+
+  while (running_) {
+    DrainControlEvents();
+    if (!connectionLost_.load(std::memory_order_acquire)) {
+      XRecordProcessReplies(dataDisplay_);
+    }
+    FlushSink();
+    if (connectionLost_.load(std::memory_order_acquire)) {
+      SetFailureReason("X connection lost");
+      connectionAlive = false;
+      break;
+    }
+
+    if (!announced) {
+      if (dataStarted_) {
+        announced = true;
+        NotifyStartResult(true);
+      } else if (NowSteadyMs() >= startDeadline) {
+        SetFailureReason("RECORD data stream did not start");
+        break;
+      }
+    }
+    if (announced && recording_ != ShouldCapture()) {
+      ApplyCapture();
+    }
+    // While not recording, resuming reports the focus anyway.
+    if (announced && TakeFocusRequest() && recording_) {
+      InputEvent focus;
+      if (activeWindow_.Reannounce(&focus)) {
+        Dispatch(std::move(focus));
+      }
+    }
+
+    // DPMS has no events, so an idle loop still wakes up to poll it.
+    int timeout = announced ? static_cast<int>(ScreenLockWatcher::kDpmsPollMs) : 50;
+    if (poll(fds, 3, timeout) < 0 && errno != EINTR) {
+      break;
+    }
+    if (fds[1].revents & POLLIN) {
+      char buffer[16];
+      while (read(wakeFds_[0], buffer, sizeof(buffer)) > 0) {
+      }
+    }
+    if ((fds[0].revents | fds[2].revents) & (POLLRDHUP | POLLHUP | POLLERR | POLLNVAL)) {
+      SetFailureReason("X connection closed");
+      connectionAlive = false;
+      break;
+    }
+  }
+
+  CloseContext(connectionAlive);
+  if (!connectionAlive) {
+    // Keys held when the connection went are never released.
+    ResetSink();
+  }
+  if (!announced) {
+    NotifyStartResult(false);
+  }
+}
+
+bool XRecordPlatformHook::Start() {
+  if (running_) {
+    return false;
+  }
+
+  SetFailureReason("");
+  if (pipe2(wakeFds_, O_CLOEXEC | O_NONBLOCK) != 0) {
+    SetFailureReason(std::string("unable to create wakeup pipe: ") + std::strerror(errno));
+    return false;
+  }
+
+  auto promise = std::make_shared<std::promise<bool>>();
+  auto future = promise->get_future();
+  {
+    std::lock_guard<std::mutex> lock(startPromiseMutex_);
+    startPromise_ = promise;
+  }
+
+  running_ = true;
+  workerThread_ = std::thread(&XRecordPlatformHook::ThreadLoop, this);
+
+  bool started = future.get();
+  if (!started) {
+    Stop();
+  }
+  return started;
+}
+
+void XRecordPlatformHook::Stop() {
+  if (!running_ && !workerThread_.joinable()) {
+    return;
+  }
+  running_ = false;
+  if (wakeFds_[1] >= 0) {
+    char byte = 0;
+    ssize_t written = write(wakeFds_[1], &byte, 1);
+    (void)written;
+  }
+  if (workerThread_.joinable()) {
+    workerThread_.join();
+  }
+  for (int& fd : wakeFds_) {
+    if (fd >= 0) {
+      close(fd);
+      fd = -1;
+    }
+  }
+}
+
+} // namespace linux
+} // namespace platform
+} // namespace inputhook
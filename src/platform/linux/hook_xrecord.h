@@ -0,0 +1,85 @@
+#pragma once
+
+#include <X11/Xlib.h>
+#include <X11/extensions/record.h>
+
+#include <atomic>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+
+#include "../../common/emitter.h"
+#include "../../common/monitors.h"
+#include "x11_focus.h"
+#include "x11_lock.h"
+
+namespace inputhook {
+namespace platform {
+namespace linux {
+
+// Core-protocol capture through the RECORD extension, the strategy libuiohook
+// uses. Unlike XInput2 raw events it reports absolute motion and sees
+// synthetic (XTest) input exactly as clients do.
+class XRecordPlatformHook : public PlatformHook {
+ public:
+  explicit XRecordPlatformHook(EventSink* sink);
+  ~XRecordPlatformHook() override;
+
+  bool Start() override;
+  void Stop() override;
+  std::string GetFailureReason() const override;
+
+ private:
+  static void OnIntercept(XPointer closure, XRecordInterceptData* data);
+  static void OnIOErrorExit(Display* display, void* userData);
+
+  void ThreadLoop();
+  bool OpenContext();
+  void CloseContext(bool connectionAlive);
+  void HandleEvent(const unsigned char* data);
+  void DrainControlEvents();
+  bool ShouldCapture() const;
+  void ApplyCapture();
+  bool OnPauseChanged() override;
+  void OnFocusRequested() override;
+  void Wake();
+  void NotifyStartResult(bool success);
+  void SetFailureReason(std::string reason);
+
+  std::atomic<bool> running_{false};
+  std::thread workerThread_;
+  // RECORD needs a connection of its own for the data stream; requests go
+  // over the control connection.
+  Display* controlDisplay_{nullptr};
+  Display* dataDisplay_{nullptr};
+  XRecordContext context_{0};
+  bool dataStarted_{false};
+  // Whether the context is enabled, and whether the data stream of the last
+  // enable has ended; both hook thread only.
+  bool recording_{false};
+  bool dataEnded_{false};
+  // Set by the IO error exit handler; the displays may then only be closed.
+  std::atomic<bool> connectionLost_{false};
+  // Last root position, for the deltas motion carries; hook thread only.
+  bool havePointer_{false};
+  int32_t pointerX_{0};
+  int32_t pointerY_{0};
+  // Screen and focus changes arrive as ordinary events on the control
+  // connection.
+  int randrEventBase_{-1};
+  bool haveMonitors_{false};
+  MonitorLayout monitors_;
+  ActiveWindowWatcher activeWindow_;
+  ScreenLockWatcher screenLock_;
+  int wakeFds_[2]{-1, -1};
+  std::mutex startPromiseMutex_;
+  std::shared_ptr<std::promise<bool>> startPromise_;
+  std::string failureReason_;
+  mutable std::mutex failureMutex_;
+};
+
+} // namespace linux
+} // namespace platform
+} // namespace inputhook
@@ -0,0 +1,97 @@
+#include "../../common/idle.h"
+
+#include <X11/Xlib.h>
+#include <X11/extensions/scrnsaver.h>
+
+#include <atomic>
+#include <mutex>
+
+#include "x11_util.h"
+
+namespace inputhook {
+
+namespace {
+
+// One connection is kept for all queries, so a poll is a single round trip.
+// A server that goes away must not take the process down through Xlib's IO
+// error handler, so without XSetIOErrorExitHandler (libX11 < 1.7) a
+// connection is opened per query instead.
+std::mutex g_idleMutex;
+Display* g_idleDisplay = nullptr;
+std::atomic<bool> g_idleDisplayLost{false};
+
+#if INPUTHOOK_X11_IOERROR_EXIT
+void OnIdleDisplayIOError(Display* /*display*/, void* /*userData*/) {
+  // Xlib marks the display dead once this returns; it is replaced on the
+  // next query.
+  g_idleDisplayLost.store(true, std::memory_order_release);
+}
+#endif
+
+void CloseIdleDisplay() {
+  if (g_idleDisplay) {
+    platform::linux::X11ErrorFilter::Remove(g_idleDisplay);
+    XCloseDisplay(g_idleDisplay);
+    g_idleDisplay = nullptr;
+  }
+}
+
+bool OpenIdleDisplay(std::string* error) {
+  if (g_idleDisplay && !g_idleDisplayLost.load(std::memory_order_acquire)) {
+    return true;
+  }
+  CloseIdleDisplay();
+  g_idleDisplayLost.store(false, std::memory_order_release);
+  g_idleDisplay = XOpenDisplay(nullptr);
+  if (!g_idleDisplay) {
+    *error = "cannot open X display";
+    return false;
+  }
+#if INPUTHOOK_X11_IOERROR_EXIT
+  XSetIOErrorExitHandler(g_idleDisplay, &OnIdleDisplayIOError, nullptr);
+#endif
+  platform::linux::X11ErrorFilter::Add(g_idleDisplay);
+
+  int eventBase = 0;
+  int errorBase = 0;
+  if (!XScreenSaverQueryExtension(g_idleDisplay, &eventBase, &errorBase)) {
+    *error = "X server lacks the MIT-SCREEN-SAVER extension";
+    CloseIdleDisplay();
+    return false;
+  }
+  return true;
+}
+
+} // namespace
+
+bool QueryIdleTime(double* idleMs, std::string* error) {
+  std::lock_guard<std::mutex> lock(g_idleMutex);
+  if (!OpenIdleDisplay(error)) {
+    return false;
+  }
+
+  bool ok = false;
+  if (XScreenSaverInfo* info = XScreenSaverAllocInfo()) {
+    if (XScreenSaverQueryInfo(g_idleDisplay, DefaultRootWindow(g_idleDisplay), info) &&
+        !g_idleDisplayLost.load(std::memory_order_acquire)) {
+      *idleMs = static_cast<double>(info->idle);
+      ok = true;
+    } else {
+      *error = g_idleDisplayLost.load(std::memory_order_acquire) ? "X connection lost"
+                                                                 : "XScreenSaverQueryInfo failed";
+    }
+    XFree(info);
+  } else {
+    *error = "out of memory";
+  }
+#if !INPUTHOOK_X11_IOERROR_EXIT
+  CloseIdleDisplay();
+#else
+  if (g_idleDisplayLost.load(std::memory_order_acquire)) {
+    CloseIdleDisplay();
+  }
+#endif
+  return ok;
+}
+
+} // namespace inputhook
@@ -0,0 +1,152 @@
+#pragma once
+
+#include <X11/Xatom.h>
+#include <X11/Xlib.h>
+#include <X11/Xutil.h>
+
+#include <cstdint>
+#include <string>
+
+#include "../../common/event.h"
+#include "x11_util.h"
+
+namespace inputhook {
+namespace platform {
+namespace linux {
+
+// Follows the window manager's _NET_ACTIVE_WINDOW through PropertyNotify on
+// the root window, so the focused window is known without a query per
+// event. WM_CLASS and _NET_WM_PID are fetched once per focus change.
+class ActiveWindowWatcher {
+ public:
+  // Selects property changes on the root window and reads the current
+  // focus. Returns true with a "focus" event when a window is active.
+  // Errors on `display` are ignored from here until Stop().
+  bool Watch(Display* display, InputEvent* focus) {
+    X11ErrorFilter::Add(display);
+    display_ = display;
+    window_ = 0;
+    activeAtom_ = XInternAtom(display, "_NET_ACTIVE_WINDOW", False);
+    pidAtom_ = XInternAtom(display, "_NET_WM_PID", False);
+    XSelectInput(display, DefaultRootWindow(display), PropertyChangeMask);
+    return Refresh(focus);
+  }
+
+  // Call before closing the display.
+  void Stop() {
+    if (display_) {
+      X11ErrorFilter::Remove(display_);
+      display_ = nullptr;
+    }
+    window_ = 0;
+  }
+
+  // Returns true with a "focus" event when `event` changed the active
+  // window, including a "focus" event without a window when focus was lost.
+  bool HandleEvent(const XEvent& event, InputEvent* focus) {
+    if (!display_ || event.type != PropertyNotify ||
+        event.xproperty.window != DefaultRootWindow(display_) ||
+        event.xproperty.atom != activeAtom_) {
+      return false;
+    }
+    return Refresh(focus);
+  }
+
+  // Re-reads the active window and reports it even if unchanged, e.g. after
+  // a pause dropped the focus events in between.
+  bool Reannounce(InputEvent* focus) {
+    if (!display_) {
+      return false;
+    }
+    window_ = 0;
+    if (!Refresh(focus)) {
+      focus->type = "focus";
+      focus->time = CurrentTimeMs();
+    }
+    return true;
+  }
+
+  void Annotate(InputEvent& event) const {
+    if (window_) {
+      event.window = window_;
+    }
+  }
+
+ private:
+  bool Refresh(InputEvent* focus) {
+    Window window = ReadWindowProperty(DefaultRootWindow(display_), activeAtom_);
+    if (window == window_) {
+      return false;
+    }
+    window_ = window;
+    focus->type = "focus";
+    focus->time = CurrentTimeMs();
+    if (!window) {
+      return true;
+    }
+
+    // The window can be destroyed before these requests arrive; the
+    // BadWindow is swallowed by X11ErrorFilter and the fields stay unset.
+    focus->window = window;
+    XClassHint hint{};
+    if (XGetClassHint(display_, window, &hint)) {
+      if (hint.res_class) {
+        focus->app = std::string(hint.res_class);
+        XFree(hint.res_class);
+      }
+      if (hint.res_name) {
+        XFree(hint.res_name);
+      }
+    }
+    uint32_t pid = static_cast<uint32_t>(ReadCardinalProperty(window, pidAtom_));
+    if (pid) {
+      focus->pid = pid;
+    }
+    return true;
+  }
+
+  unsigned long ReadCardinalProperty(Window window, Atom property) const {
+    Atom type = None;
+    int format = 0;
+    unsigned long count = 0;
+    unsigned long remaining = 0;
+    unsigned char* data = nullptr;
+    unsigned long value = 0;
+    if (XGetWindowProperty(display_, window, property, 0, 1, False, XA_CARDINAL, &type, &format,
+                           &count, &remaining, &data) == Success &&
+        data) {
+      if (format == 32 && count == 1) {
+        value = *reinterpret_cast<unsigned long*>(data);
+      }
+      XFree(data);
+    }
+    return value;
+  }
+
+  Window ReadWindowProperty(Window window, Atom property) const {
+    Atom type = None;
+    int format = 0;
+    unsigned long count = 0;
+    unsigned long remaining = 0;
+    unsigned char* data = nullptr;
+    Window value = 0;
+    if (XGetWindowProperty(display_, window, property, 0, 1, False, XA_WINDOW, &type, &format,
+                           &count, &remaining, &data) == Success &&
+        data) {
+      if (format == 32 && count == 1) {
+        value = *reinterpret_cast<Window*>(data);
+      }
+      XFree(data);
+    }
+    return value;
+  }
+
+  Display* display_{nullptr};
+  Atom activeAtom_{None};
+  Atom pidAtom_{None};
+  Window window_{0};
+};
+
+} // namespace linux
+} // namespace platform
+} // namespace inputhook
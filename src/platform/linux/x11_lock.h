@@ -0,0 +1,114 @@
+#pragma once
+
+#include <X11/Xlib.h>
+#include <X11/extensions/dpms.h>
+#include <X11/extensions/scrnsaver.h>
+
+#include <cstdint>
+
+#include "../../common/event.h"
+#include "x11_util.h"
+
+namespace inputhook {
+namespace platform {
+namespace linux {
+
+// Tracks whether the screen is locked or off: screensaver activation arrives
+// as MIT-SCREEN-SAVER notify events (lockers such as xscreensaver and
+// light-locker drive it), while DPMS has no events and is polled at most
+// every kDpmsPollMs. Either one counts as locked.
+class ScreenLockWatcher {
+ public:
+  static constexpr int64_t kDpmsPollMs = 5000;
+
+  // Selects screensaver notifications and reads the current state. Returns
+  // true with a "lock" event when the screen is already locked.
+  bool Watch(Display* display, InputEvent* transition) {
+    display_ = display;
+    saverActive_ = false;
+    dpmsOff_ = false;
+    locked_ = false;
+    nextDpmsPollMs_ = 0;
+
+    int errorBase = 0;
+    if (XScreenSaverQueryExtension(display, &saverEventBase_, &errorBase)) {
+      XScreenSaverSelectInput(display, DefaultRootWindow(display), ScreenSaverNotifyMask);
+      if (XScreenSaverInfo* info = XScreenSaverAllocInfo()) {
+        if (XScreenSaverQueryInfo(display, DefaultRootWindow(display), info)) {
+          saverActive_ = info->state == ScreenSaverOn;
+        }
+        XFree(info);
+      }
+    } else {
+      saverEventBase_ = -1;
+    }
+    int dpmsEventBase = 0;
+    haveDpms_ = DPMSQueryExtension(display, &dpmsEventBase, &errorBase) && DPMSCapable(display);
+    dpmsOff_ = ReadDpmsOff();
+    nextDpmsPollMs_ = NowSteadyMs() + kDpmsPollMs;
+    return Update(transition);
+  }
+
+  // Returns true with a "lock" or "unlock" event when `event` changed the
+  // screensaver state.
+  bool HandleEvent(const XEvent& event, InputEvent* transition) {
+    if (saverEventBase_ < 0 || event.type != saverEventBase_ + ScreenSaverNotify) {
+      return false;
+    }
+    const auto& notify = reinterpret_cast<const XScreenSaverNotifyEvent&>(event);
+    if (notify.state == ScreenSaverOn) {
+      saverActive_ = true;
+    } else if (notify.state == ScreenSaverOff) {
+      saverActive_ = false;
+    }
+    return Update(transition);
+  }
+
+  // Re-reads DPMS once the poll interval has passed.
+  bool Poll(int64_t nowMs, InputEvent* transition) {
+    if (!haveDpms_ || nowMs < nextDpmsPollMs_) {
+      return false;
+    }
+    nextDpmsPollMs_ = nowMs + kDpmsPollMs;
+    dpmsOff_ = ReadDpmsOff();
+    return Update(transition);
+  }
+
+  bool Locked() const { return locked_; }
+
+ private:
+  bool ReadDpmsOff() const {
+    if (!haveDpms_) {
+      return false;
+    }
+    CARD16 level = DPMSModeOn;
+    BOOL enabled = False;
+    return DPMSInfo(display_, &level, &enabled) && enabled && level != DPMSModeOn;
+  }
+
+  bool Update(InputEvent* transition) {
+    bool locked = saverActive_ || dpmsOff_;
+    if (locked == locked_) {
+      return false;
+    }
+    locked_ = locked;
+    transition->type = locked ? "lock" : "unlock";
+    transition->time = CurrentTimeMs();
+    if (locked) {
+      transition->reason = saverActive_ ? "screensaver" : "dpms";
+    }
+    return true;
+  }
+
+  Display* display_{nullptr};
+  int saverEventBase_{-1};
+  bool haveDpms_{false};
+  bool saverActive_{false};
+  bool dpmsOff_{false};
+  bool locked_{false};
+  int64_t nextDpmsPollMs_{0};
+};
+
+} // namespace linux
+} // namespace platform
+} // namespace inputhook
@@ -0,0 +1,197 @@
+#pragma once
+
+#include <X11/X.h>
+#include <X11/Xlib.h>
+#include <X11/extensions/Xrandr.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <mutex>
+#include <sys/time.h>
+#include <time.h>
+#include <vector>
+
+#include "../../common/event.h"
+#include "../../common/keymap.h"
+#include "../../common/monitors.h"
+
+// Helpers shared by the X11 backends so XInput2 and XRecord produce the same
+// event contract.
+
+// libX11 >= 1.7 lets a per-display handler stop an IO error from exiting the
+// process; binding.gyp probes for it through pkg-config.
+#ifndef INPUTHOOK_X11_IOERROR_EXIT
+#define INPUTHOOK_X11_IOERROR_EXIT 0
+#endif
+
+namespace inputhook {
+namespace platform {
+namespace linux {
+
+// Xlib's error handler is process-global, so swapping it around a query
+// races with other threads and libraries doing the same. One handler is
+// installed on first use instead: it ignores errors on the displays added
+// here (a window destroyed between two requests answers BadWindow) and
+// passes everything else to the handler that was installed before it.
+class X11ErrorFilter {
+ public:
+  static void Add(Display* display) {
+    State& state = GetState();
+    std::lock_guard<std::mutex> lock(state.mutex);
+    if (!state.installed) {
+      state.previous = XSetErrorHandler(&X11ErrorFilter::Handle);
+      state.installed = true;
+    }
+    state.displays.push_back(display);
+  }
+
+  // Must be called before the display is closed.
+  static void Remove(Display* display) {
+    State& state = GetState();
+    std::lock_guard<std::mutex> lock(state.mutex);
+    auto found = std::find(state.displays.begin(), state.displays.end(), display);
+    if (found != state.displays.end()) {
+      state.displays.erase(found);
+    }
+  }
+
+ private:
+  struct State {
+    std::mutex mutex;
+    std::vector<Display*> displays;
+    XErrorHandler previous = nullptr;
+    bool installed = false;
+  };
+
+  static State& GetState() {
+    static State state;
+    return state;
+  }
+
+  static int Handle(Display* display, XErrorEvent* error) {
+    XErrorHandler previous;
+    {
+      State& state = GetState();
+      std::lock_guard<std::mutex> lock(state.mutex);
+      if (std::find(state.displays.begin(), state.displays.end(), display) !=
+          state.displays.end()) {
+        return 0;
+      }
+      previous = state.previous;
+    }
+    return previous ? previous(display, error) : 0;
+  }
+};
+
+inline double CurrentTimeMs() {
+  struct timeval now;
+  gettimeofday(&now, nullptr);
+  return now.tv_sec * 1000.0 + now.tv_usec / 1000.0;
+}
+
+inline int64_t NowSteadyMs() {
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return static_cast<int64_t>(now.tv_sec) * 1000 + now.tv_nsec / 1000000;
+}
+
+inline InputModifiers ModifiersFromMask(unsigned int mask) {
+  InputModifiers modifiers;
+  modifiers.shift = (mask & ShiftMask) != 0;
+  modifiers.ctrl = (mask & ControlMask) != 0;
+  modifiers.alt = (mask & Mod1Mask) != 0;
+  modifiers.meta = (mask & Mod4Mask) != 0;
+  return modifiers;
+}
+
+inline void AssignKeyCodes(InputEvent& inputEvent, uint32_t keycode) {
+  inputEvent.keycode = keycode;
+  inputEvent.scancode = keycode;
+  uint16_t usage = keymap::UsageFromXKeycode(keycode);
+  if (usage != keymap::kUsageNone) {
+    inputEvent.hidUsage = usage;
+  }
+}
+
+inline bool TryWheelDeltaForButton(uint32_t button, int32_t& deltaX, int32_t& deltaY) {
+  constexpr int32_t kWheelStep = 1;
+  deltaX = 0;
+  deltaY = 0;
+  switch (button) {
+    case 4:
+      deltaY = kWheelStep;
+      return true;
+    case 5:
+      deltaY = -kWheelStep;
+      return true;
+    case 6:
+      deltaX = kWheelStep;
+      return true;
+    case 7:
+      deltaX = -kWheelStep;
+      return true;
+    default:
+      return false;
+  }
+}
+
+// Reloads the monitor rectangles. Without RandR 1.5 monitors the root window
+// is treated as a single monitor.
+inline void RefreshMonitorLayout(Display* display, bool haveMonitors, MonitorLayout* layout) {
+  std::vector<MonitorRect> rects;
+  Window root = DefaultRootWindow(display);
+  int count = 0;
+  XRRMonitorInfo* monitors = haveMonitors ? XRRGetMonitors(display, root, True, &count) : nullptr;
+  if (monitors) {
+    // Primary first, so index 0 is the main display.
+    for (int pass = 0; pass < 2; ++pass) {
+      for (int i = 0; i < count; ++i) {
+        if (static_cast<bool>(monitors[i].primary) == (pass == 0)) {
+          rects.push_back({monitors[i].x, monitors[i].y, monitors[i].width, monitors[i].height});
+        }
+      }
+    }
+    XRRFreeMonitors(monitors);
+  }
+  if (rects.empty()) {
+    int screen = DefaultScreen(display);
+    rects.push_back({0, 0, DisplayWidth(display, screen), DisplayHeight(display, screen)});
+  }
+  layout->Set(std::move(rects));
+}
+
+// Selects RRScreenChangeNotify on the root window and loads the current
+// layout. Returns the RandR event base, or -1 when RandR is unavailable and
+// the layout will not follow changes.
+inline int WatchMonitorLayout(Display* display, bool* haveMonitors, MonitorLayout* layout) {
+  int eventBase = 0;
+  int errorBase = 0;
+  int major = 0;
+  int minor = 0;
+  bool randr = XRRQueryExtension(display, &eventBase, &errorBase) &&
+               XRRQueryVersion(display, &major, &minor);
+  *haveMonitors = randr && (major > 1 || (major == 1 && minor >= 5));
+  if (randr) {
+    XRRSelectInput(display, DefaultRootWindow(display), RRScreenChangeNotifyMask);
+  }
+  RefreshMonitorLayout(display, *haveMonitors, layout);
+  return randr ? eventBase : -1;
+}
+
+// Handles `event` if it is a RandR screen change; returns false otherwise.
+inline bool HandleMonitorLayoutEvent(Display* display,
+                                     int eventBase,
+                                     bool haveMonitors,
+                                     XEvent* event,
+                                     MonitorLayout* layout) {
+  if (eventBase < 0 || event->type != eventBase + RRScreenChangeNotify) {
+    return false;
+  }
+  XRRUpdateConfiguration(event);
+  RefreshMonitorLayout(display, haveMonitors, layout);
+  return true;
+}
+
+} // namespace linux
+} // namespace platform
+} // namespace inputhook
@@ -18,7 +18,7 @@ namespace mac {
 
 class MacPlatformHook : public PlatformHook {
  public:
-  explicit MacPlatformHook(PlatformHook::EventCallback callback);
+  explicit MacPlatformHook(EventSink* sink);
   ~MacPlatformHook() override;
 
   bool Start() override;
@@ -37,6 +37,9 @@ class MacPlatformHook : public PlatformHook {
   bool CreateEventTapSequence(CGEventMask mask);
   void TeardownEventTap();
   bool RecreateEventTap(const char* reason);
+  // Polls the lock screen and display sleep on the run loop thread.
+  void PollScreenLock();
+  bool OnPauseChanged() override;
   void SetFailureReason(std::string reason);
   void SetLastError(std::string reason);
 
@@ -55,6 +58,9 @@ class MacPlatformHook : public PlatformHook {
   std::atomic<int64_t> lastRecreateMs_{0};
   std::atomic<bool> eventSeen_{false};
   CGEventFlags lastFlags_{0};
+  // Run loop thread only.
+  bool locked_{false};
+  int64_t nextLockPollMs_{0};
   std::string processPath_;
 
   void NotifyStartResult(bool success);
@@ -12,6 +12,8 @@
 #include <unistd.h>
 #include <vector>
 
+#include "../../common/keymap.h"
+
 namespace inputhook {
 namespace platform {
 namespace mac {
@@ -20,6 +22,7 @@ namespace {
 constexpr int64_t kWatchdogIntervalMs = 120000;
 constexpr int64_t kInitialNoEventMs = 30000;
 constexpr int64_t kMinRecreateIntervalMs = 60000;
+constexpr int64_t kLockPollMs = 1000;
 
 double CurrentTimeMs() {
   using namespace std::chrono;
@@ -31,6 +34,21 @@ int64_t NowSteadyMs() {
   return duration_cast<milliseconds>(steady_clock::now().time_since_epoch()).count();
 }
 
+// The session dictionary reflects the lock screen from any thread, unlike the
+// com.apple.screenIsLocked distributed notification, which is only delivered
+// on the main run loop that Node never runs.
+bool ScreenIsLocked() {
+  CFDictionaryRef session = CGSessionCopyCurrentDictionary();
+  if (!session) {
+    return false;
+  }
+  CFTypeRef value = CFDictionaryGetValue(session, CFSTR("CGSSessionScreenIsLocked"));
+  bool locked = value && CFGetTypeID(value) == CFBooleanGetTypeID() &&
+                CFBooleanGetValue(static_cast<CFBooleanRef>(value));
+  CFRelease(session);
+  return locked;
+}
+
 bool DebugEnabled() {
   static std::atomic<int> cached{-1};
   int value = cached.load(std::memory_order_acquire);
@@ -54,6 +72,14 @@ void DebugLog(const char* fmt, ...) {
   va_end(args);
 }
 
+void AssignKeyCodes(InputEvent& event, uint32_t keycode) {
+  event.keycode = keycode;
+  uint16_t usage = keymap::UsageFromMacKeycode(keycode);
+  if (usage != keymap::kUsageNone) {
+    event.hidUsage = usage;
+  }
+}
+
 InputModifiers ModifiersFromFlags(CGEventFlags flags) {
   InputModifiers mods;
   mods.shift = (flags & kCGEventFlagMaskShift) != 0;
@@ -71,13 +97,13 @@ std::optional<InputEvent> BuildEvent(CGEventType type, CGEventRef eventRef) {
   switch (type) {
     case kCGEventKeyDown:
       event.type = "keydown";
-      event.keycode = static_cast<uint32_t>(
-          CGEventGetIntegerValueField(eventRef, kCGKeyboardEventKeycode));
+      AssignKeyCodes(event, static_cast<uint32_t>(
+          CGEventGetIntegerValueField(eventRef, kCGKeyboardEventKeycode)));
       break;
     case kCGEventKeyUp:
       event.type = "keyup";
-      event.keycode = static_cast<uint32_t>(
-          CGEventGetIntegerValueField(eventRef, kCGKeyboardEventKeycode));
+      AssignKeyCodes(event, static_cast<uint32_t>(
+          CGEventGetIntegerValueField(eventRef, kCGKeyboardEventKeycode)));
       break;
     case kCGEventMouseMoved:
     case kCGEventLeftMouseDragged:
@@ -203,8 +229,8 @@ bool CheckAccessibilityPermission(const std::string& processPath,
 
 }  // namespace
 
-MacPlatformHook::MacPlatformHook(PlatformHook::EventCallback callback)
-    : PlatformHook(std::move(callback)) {}
+MacPlatformHook::MacPlatformHook(EventSink* sink)
+    : PlatformHook(sink) {}
 
 MacPlatformHook::~MacPlatformHook() {
   Stop();
@@ -257,16 +283,19 @@ CGEventRef MacPlatformHook::EventCallback(CGEventTapProxy proxy,
     InputEvent modifierEvent;
     modifierEvent.time = CurrentTimeMs();
     modifierEvent.modifiers = ModifiersFromFlags(flags);
-    modifierEvent.keycode = static_cast<uint32_t>(
-        CGEventGetIntegerValueField(event, kCGKeyboardEventKeycode));
+    AssignKeyCodes(modifierEvent, static_cast<uint32_t>(
+        CGEventGetIntegerValueField(event, kCGKeyboardEventKeycode)));
     modifierEvent.type = (flags & changed) ? "keydown" : "keyup";
     self->Dispatch(std::move(modifierEvent));
+    self->FlushSink();
     return event;
   }
 
   auto builtEvent = BuildEvent(type, event);
   if (builtEvent) {
+    // The tap delivers one event per callback, so each is its own batch.
     self->Dispatch(std::move(*builtEvent));
+    self->FlushSink();
   }
   return event;
 }
@@ -412,8 +441,26 @@ void MacPlatformHook::RunLoopThread() {
 
     lastRecreateMs_.store(NowSteadyMs(), std::memory_order_release);
 
+    bool tapEnabled = true;
+    locked_ = false;
+    nextLockPollMs_ = 0;
     while (running_) {
       CFRunLoopRunInMode(kCFRunLoopDefaultMode, 0.1, true);
+      PollScreenLock();
+
+      // A disabled tap is taken out of the event path entirely. The watchdog
+      // is suspended meanwhile and restarts its clock on resume.
+      bool paused = IsPaused() || locked_;
+      if (paused == tapEnabled) {
+        tapEnabled = !paused;
+        if (eventTap_) {
+          CGEventTapEnable(eventTap_, tapEnabled);
+        }
+        lastEventMs_.store(NowSteadyMs(), std::memory_order_release);
+      }
+      if (paused) {
+        continue;
+      }
 
       int64_t now = NowSteadyMs();
       int64_t lastEvent = lastEventMs_.load(std::memory_order_acquire);
@@ -438,6 +485,38 @@ void MacPlatformHook::RunLoopThread() {
   }
 }
 
+void MacPlatformHook::PollScreenLock() {
+  int64_t now = NowSteadyMs();
+  if (now < nextLockPollMs_) {
+    return;
+  }
+  nextLockPollMs_ = now + kLockPollMs;
+  bool sessionLocked = ScreenIsLocked();
+  bool displayAsleep = CGDisplayIsAsleep(CGMainDisplayID());
+  bool locked = sessionLocked || displayAsleep;
+  if (locked == locked_) {
+    return;
+  }
+  locked_ = locked;
+  InputEvent transition;
+  transition.type = locked ? "lock" : "unlock";
+  transition.time = CurrentTimeMs();
+  if (locked) {
+    transition.reason = sessionLocked ? "session" : "dpms";
+  }
+  Dispatch(std::move(transition));
+  FlushSink();
+}
+
+bool MacPlatformHook::OnPauseChanged() {
+  // Returns the run loop thread from CFRunLoopRunInMode so the change does
+  // not wait for the next tick.
+  if (runLoop_) {
+    CFRunLoopStop(runLoop_);
+  }
+  return true;
+}
+
 bool MacPlatformHook::Start() {
   if (running_) {
     return false;
@@ -0,0 +1,19 @@
+#include "../../common/idle.h"
+
+#import <ApplicationServices/ApplicationServices.h>
+
+namespace inputhook {
+
+// Needs no Accessibility or Input Monitoring permission, unlike the event tap.
+bool QueryIdleTime(double* idleMs, std::string* error) {
+  CFTimeInterval seconds = CGEventSourceSecondsSinceLastEventType(
+      kCGEventSourceStateCombinedSessionState, kCGAnyInputEventType);
+  if (seconds < 0) {
+    *error = "CGEventSourceSecondsSinceLastEventType failed";
+    return false;
+  }
+  *idleMs = seconds * 1000.0;
+  return true;
+}
+
+} // namespace inputhook
@@ -1,6 +1,11 @@
 #include "hook_win.h"
 
+#include <wtsapi32.h>
+
 #include <chrono>
+#include <string>
+
+#include "../../common/keymap.h"
 
 namespace inputhook {
 namespace platform {
@@ -10,6 +15,13 @@ WinPlatformHook* WinPlatformHook::instance_ = nullptr;
 
 namespace {
 
+constexpr UINT kPauseChangedMessage = WM_APP + 1;
+constexpr UINT kFocusRequestedMessage = WM_APP + 2;
+// A resume waits this long for the hook thread, which only takes longer if
+// it is stopping.
+constexpr auto kResumeTimeout = std::chrono::seconds(2);
+constexpr wchar_t kSessionWindowClass[] = L"InputHookSessionWindow";
+
 InputModifiers CurrentModifiers() {
   InputModifiers mods;
   mods.shift = (GetAsyncKeyState(VK_SHIFT) & 0x8000) != 0;
@@ -24,23 +36,137 @@ double CurrentTimeMs() {
   return static_cast<double>(duration_cast<milliseconds>(system_clock::now().time_since_epoch()).count());
 }
 
+// Executable name without directory or extension, e.g. "chrome".
+std::string ProcessName(DWORD pid) {
+  HANDLE process = OpenProcess(PROCESS_QUERY_LIMITED_INFORMATION, FALSE, pid);
+  if (!process) {
+    return std::string();
+  }
+  wchar_t path[MAX_PATH];
+  DWORD length = MAX_PATH;
+  BOOL ok = QueryFullProcessImageNameW(process, 0, path, &length);
+  CloseHandle(process);
+  if (!ok) {
+    return std::string();
+  }
+  std::wstring name(path, length);
+  std::size_t slash = name.find_last_of(L"\\/");
+  if (slash != std::wstring::npos) {
+    name.erase(0, slash + 1);
+  }
+  std::size_t dot = name.find_last_of(L'.');
+  if (dot != std::wstring::npos && dot > 0) {
+    name.erase(dot);
+  }
+  int bytes = WideCharToMultiByte(CP_UTF8, 0, name.c_str(), static_cast<int>(name.size()),
+                                  nullptr, 0, nullptr, nullptr);
+  std::string utf8(bytes > 0 ? bytes : 0, '\0');
+  if (bytes > 0) {
+    WideCharToMultiByte(CP_UTF8, 0, name.c_str(), static_cast<int>(name.size()), &utf8[0], bytes,
+                        nullptr, nullptr);
+  }
+  return utf8;
+}
+
 } // namespace
 
-WinPlatformHook::WinPlatformHook(EventCallback callback)
-    : PlatformHook(std::move(callback)) {}
+WinPlatformHook::WinPlatformHook(EventSink* sink)
+    : PlatformHook(sink) {}
 
 WinPlatformHook::~WinPlatformHook() {
   Stop();
 }
 
+void WinPlatformHook::NotifyStartResult(bool success) {
+  std::shared_ptr<std::promise<bool>> promise;
+  {
+    std::lock_guard<std::mutex> lock(startPromiseMutex_);
+    promise = std::move(startPromise_);
+  }
+  if (promise) {
+    promise->set_value(success);
+  }
+}
+
+void WinPlatformHook::NotifyResumeResult(bool success) {
+  std::shared_ptr<std::promise<bool>> promise;
+  {
+    std::lock_guard<std::mutex> lock(resumePromiseMutex_);
+    promise = std::move(resumePromise_);
+  }
+  if (promise) {
+    promise->set_value(success);
+  }
+}
+
+std::string WinPlatformHook::GetFailureReason() const {
+  std::lock_guard<std::mutex> lock(failureMutex_);
+  return failureReason_;
+}
+
+void WinPlatformHook::SetFailureReason(std::string reason) {
+  std::lock_guard<std::mutex> lock(failureMutex_);
+  failureReason_ = std::move(reason);
+}
+
 void WinPlatformHook::ThreadLoop() {
   threadId_ = GetCurrentThreadId();
+  // Force the message queue into existence so Stop()'s WM_QUIT is not lost.
+  MSG message;
+  PeekMessage(&message, nullptr, WM_USER, WM_USER, PM_NOREMOVE);
+
   HINSTANCE module = GetModuleHandle(nullptr);
   keyboardHook_ = SetWindowsHookEx(WH_KEYBOARD_LL, KeyboardProc, module, 0);
+  if (!keyboardHook_) {
+    SetFailureReason("SetWindowsHookEx(WH_KEYBOARD_LL) failed with error " +
+                     std::to_string(::GetLastError()));
+  }
   mouseHook_ = SetWindowsHookEx(WH_MOUSE_LL, MouseProc, module, 0);
+  if (!mouseHook_ && keyboardHook_) {
+    SetFailureReason("SetWindowsHookEx(WH_MOUSE_LL) failed with error " +
+                     std::to_string(::GetLastError()));
+  }
+  if (!keyboardHook_ || !mouseHook_) {
+    if (keyboardHook_) {
+      UnhookWindowsHookEx(keyboardHook_);
+      keyboardHook_ = nullptr;
+    }
+    if (mouseHook_) {
+      UnhookWindowsHookEx(mouseHook_);
+      mouseHook_ = nullptr;
+    }
+    NotifyStartResult(false);
+    return;
+  }
+  NotifyStartResult(true);
+
+  // Out-of-context WinEvents are delivered through this thread's message
+  // loop. Focus tracking is optional, so a failure here is not fatal.
+  foregroundHook_ = SetWinEventHook(EVENT_SYSTEM_FOREGROUND, EVENT_SYSTEM_FOREGROUND, nullptr,
+                                    ForegroundProc, 0, 0,
+                                    WINEVENT_OUTOFCONTEXT | WINEVENT_SKIPOWNPROCESS);
+  UpdateForeground(GetForegroundWindow());
+  CreateSessionWindow();
+
+  if (!ShouldCapture()) {
+    ApplyCapture();
+  }
 
-  MSG message;
   while (running_ && GetMessage(&message, nullptr, 0, 0) > 0) {
+    if (!message.hwnd && message.message == kPauseChangedMessage) {
+      ApplyCapture();
+      // A lock keeps the hooks out until it ends; that is not a failure.
+      NotifyResumeResult(!ShouldCapture() || (keyboardHook_ && mouseHook_));
+      continue;
+    }
+    if (!message.hwnd && message.message == kFocusRequestedMessage) {
+      // While paused, resuming reports the focus anyway.
+      if (TakeFocusRequest() && ShouldCapture()) {
+        foreground_ = nullptr;
+        UpdateForeground(GetForegroundWindow());
+      }
+      continue;
+    }
     TranslateMessage(&message);
     DispatchMessage(&message);
   }
@@ -53,20 +179,231 @@ void WinPlatformHook::ThreadLoop() {
     UnhookWindowsHookEx(mouseHook_);
     mouseHook_ = nullptr;
   }
+  if (foregroundHook_) {
+    UnhookWinEvent(foregroundHook_);
+    foregroundHook_ = nullptr;
+  }
+  DestroySessionWindow();
+  foreground_ = nullptr;
+  NotifyResumeResult(false);
+}
+
+// Lock and display notifications are only sent to windows, so a hidden
+// message-only window on the hook thread receives them. Like focus tracking
+// this is optional and a failure is not fatal.
+void WinPlatformHook::CreateSessionWindow() {
+  sessionLocked_ = false;
+  displayOff_ = false;
+  locked_ = false;
+
+  HINSTANCE module = GetModuleHandle(nullptr);
+  WNDCLASSEXW windowClass = {};
+  windowClass.cbSize = sizeof(windowClass);
+  windowClass.lpfnWndProc = SessionWindowProc;
+  windowClass.hInstance = module;
+  windowClass.lpszClassName = kSessionWindowClass;
+  RegisterClassExW(&windowClass);
+  sessionWindow_ = CreateWindowExW(0, kSessionWindowClass, L"", 0, 0, 0, 0, 0, HWND_MESSAGE,
+                                   nullptr, module, nullptr);
+  if (!sessionWindow_) {
+    return;
+  }
+  WTSRegisterSessionNotification(sessionWindow_, NOTIFY_FOR_THIS_SESSION);
+  // Delivers the current display state right away.
+  displayNotification_ = RegisterPowerSettingNotification(
+      sessionWindow_, &GUID_CONSOLE_DISPLAY_STATE, DEVICE_NOTIFY_WINDOW_HANDLE);
+}
+
+void WinPlatformHook::DestroySessionWindow() {
+  if (displayNotification_) {
+    UnregisterPowerSettingNotification(displayNotification_);
+    displayNotification_ = nullptr;
+  }
+  if (sessionWindow_) {
+    WTSUnRegisterSessionNotification(sessionWindow_);
+    DestroyWindow(sessionWindow_);
+    sessionWindow_ = nullptr;
+  }
+}
+
+LRESULT CALLBACK WinPlatformHook::SessionWindowProc(HWND window,
+                                                    UINT message,
+                                                    WPARAM wParam,
+                                                    LPARAM lParam) {
+  WinPlatformHook* self = instance_;
+  if (self && message == WM_WTSSESSION_CHANGE) {
+    if (wParam == WTS_SESSION_LOCK) {
+      self->sessionLocked_ = true;
+      self->UpdateLocked();
+    } else if (wParam == WTS_SESSION_UNLOCK) {
+      self->sessionLocked_ = false;
+      self->UpdateLocked();
+    }
+    return 0;
+  }
+  if (self && message == WM_POWERBROADCAST && wParam == PBT_POWERSETTINGCHANGE) {
+    auto* setting = reinterpret_cast<const POWERBROADCAST_SETTING*>(lParam);
+    if (setting && IsEqualGUID(setting->PowerSetting, GUID_CONSOLE_DISPLAY_STATE) &&
+        setting->DataLength >= sizeof(DWORD)) {
+      // 0 is off, 1 on and 2 dimmed.
+      self->displayOff_ = *reinterpret_cast<const DWORD*>(setting->Data) == 0;
+      self->UpdateLocked();
+    }
+    return TRUE;
+  }
+  return DefWindowProcW(window, message, wParam, lParam);
+}
+
+void WinPlatformHook::UpdateLocked() {
+  bool locked = sessionLocked_ || displayOff_;
+  if (locked == locked_) {
+    return;
+  }
+  locked_ = locked;
+  InputEvent transition;
+  transition.type = locked ? "lock" : "unlock";
+  transition.time = CurrentTimeMs();
+  if (locked) {
+    transition.reason = sessionLocked_ ? "session" : "dpms";
+  }
+  Dispatch(std::move(transition));
+  FlushSink();
+  ApplyCapture();
+}
+
+bool WinPlatformHook::ShouldCapture() const {
+  return !IsPaused() && !locked_;
+}
+
+// Low-level hooks put this thread in the path of every input event in the
+// session, so a pause or lock removes them instead of just dropping what they
+// see.
+// Runs on the hook thread, which must own the hooks.
+void WinPlatformHook::ApplyCapture() {
+  if (!ShouldCapture()) {
+    if (keyboardHook_) {
+      UnhookWindowsHookEx(keyboardHook_);
+      keyboardHook_ = nullptr;
+    }
+    if (mouseHook_) {
+      UnhookWindowsHookEx(mouseHook_);
+      mouseHook_ = nullptr;
+    }
+    return;
+  }
+
+  HINSTANCE module = GetModuleHandle(nullptr);
+  if (!keyboardHook_) {
+    keyboardHook_ = SetWindowsHookEx(WH_KEYBOARD_LL, KeyboardProc, module, 0);
+  }
+  if (!mouseHook_) {
+    mouseHook_ = SetWindowsHookEx(WH_MOUSE_LL, MouseProc, module, 0);
+  }
+  if (!keyboardHook_ || !mouseHook_) {
+    SetFailureReason("SetWindowsHookEx failed on resume with error " +
+                     std::to_string(::GetLastError()));
+  }
+  // Focus changes during a pause were dropped.
+  foreground_ = nullptr;
+  UpdateForeground(GetForegroundWindow());
+}
+
+// The hooks are only reinstalled on the hook thread, so a resume waits there
+// for SetWindowsHookEx; on failure PlatformHook pauses again and the next
+// message removes whichever hook did install.
+bool WinPlatformHook::OnPauseChanged() {
+  if (!threadId_) {
+    return true;
+  }
+  if (IsPaused()) {
+    PostThreadMessage(threadId_, kPauseChangedMessage, 0, 0);
+    return true;
+  }
+
+  auto promise = std::make_shared<std::promise<bool>>();
+  auto future = promise->get_future();
+  {
+    std::lock_guard<std::mutex> lock(resumePromiseMutex_);
+    resumePromise_ = promise;
+  }
+  if (!PostThreadMessage(threadId_, kPauseChangedMessage, 0, 0)) {
+    SetFailureReason("PostThreadMessage failed on resume with error " +
+                     std::to_string(::GetLastError()));
+    NotifyResumeResult(false);
+  }
+  return future.wait_for(kResumeTimeout) == std::future_status::ready && future.get();
+}
+
+void WinPlatformHook::OnFocusRequested() {
+  if (threadId_) {
+    PostThreadMessage(threadId_, kFocusRequestedMessage, 0, 0);
+  }
+}
+
+void WinPlatformHook::UpdateForeground(HWND window) {
+  if (window == foreground_) {
+    return;
+  }
+  foreground_ = window;
+  if (!window) {
+    return;
+  }
+
+  InputEvent focus;
+  focus.type = "focus";
+  focus.time = CurrentTimeMs();
+  focus.window = reinterpret_cast<uintptr_t>(window);
+  DWORD pid = 0;
+  GetWindowThreadProcessId(window, &pid);
+  if (pid) {
+    focus.pid = pid;
+    std::string app = ProcessName(pid);
+    if (!app.empty()) {
+      focus.app = std::move(app);
+    }
+  }
+  Dispatch(std::move(focus));
+  FlushSink();
+}
+
+void CALLBACK WinPlatformHook::ForegroundProc(HWINEVENTHOOK /*hook*/,
+                                              DWORD /*event*/,
+                                              HWND window,
+                                              LONG objectId,
+                                              LONG /*childId*/,
+                                              DWORD /*threadId*/,
+                                              DWORD /*time*/) {
+  if (instance_ && objectId == OBJID_WINDOW) {
+    instance_->UpdateForeground(window);
+  }
 }
 
 bool WinPlatformHook::Start() {
   if (running_) {
     return false;
   }
+
+  SetFailureReason("");
+  auto promise = std::make_shared<std::promise<bool>>();
+  auto future = promise->get_future();
+  {
+    std::lock_guard<std::mutex> lock(startPromiseMutex_);
+    startPromise_ = promise;
+  }
+
   running_ = true;
   instance_ = this;
   workerThread_ = std::thread(&WinPlatformHook::ThreadLoop, this);
-  return true;
+
+  bool started = future.get();
+  if (!started) {
+    Stop();
+  }
+  return started;
 }
 
 void WinPlatformHook::Stop() {
-  if (!running_) {
+  if (!running_ && !workerThread_.joinable()) {
     return;
   }
   running_ = false;
@@ -80,6 +417,8 @@ void WinPlatformHook::Stop() {
   threadId_ = 0;
 }
 
+// Low-level hooks deliver one event per call, so every event is flushed as
+// its own batch.
 LRESULT CALLBACK WinPlatformHook::KeyboardProc(int code, WPARAM wParam, LPARAM lParam) {
   if (code == HC_ACTION && instance_) {
     auto data = reinterpret_cast<KBDLLHOOKSTRUCT*>(lParam);
@@ -101,9 +440,18 @@ LRESULT CALLBACK WinPlatformHook::KeyboardProc(int code, WPARAM wParam, LPARAM l
     if (event.type.empty()) {
       return CallNextHookEx(nullptr, code, wParam, lParam);
     }
+    if (instance_->foreground_) {
+      event.window = reinterpret_cast<uintptr_t>(instance_->foreground_);
+    }
     event.keycode = data->vkCode;
     event.scancode = data->scanCode;
+    uint16_t usage = keymap::UsageFromScancode(data->scanCode,
+                                               (data->flags & LLKHF_EXTENDED) != 0);
+    if (usage != keymap::kUsageNone) {
+      event.hidUsage = usage;
+    }
     instance_->Dispatch(std::move(event));
+    instance_->FlushSink();
   }
   return CallNextHookEx(nullptr, code, wParam, lParam);
 }
@@ -116,6 +464,9 @@ LRESULT CALLBACK WinPlatformHook::MouseProc(int code, WPARAM wParam, LPARAM lPar
     event.modifiers = CurrentModifiers();
     event.x = static_cast<int32_t>(data->pt.x);
     event.y = static_cast<int32_t>(data->pt.y);
+    if (instance_->foreground_) {
+      event.window = reinterpret_cast<uintptr_t>(instance_->foreground_);
+    }
 
     switch (wParam) {
       case WM_MOUSEMOVE:
@@ -161,6 +512,7 @@ LRESULT CALLBACK WinPlatformHook::MouseProc(int code, WPARAM wParam, LPARAM lPar
     }
 
     instance_->Dispatch(std::move(event));
+    instance_->FlushSink();
   }
   return CallNextHookEx(nullptr, code, wParam, lParam);
 }
@@ -1,6 +1,10 @@
 #pragma once
 
 #include <atomic>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <string>
 #include <thread>
 #include <windows.h>
 
@@ -12,16 +16,39 @@ namespace win {
 
 class WinPlatformHook : public PlatformHook {
  public:
-  explicit WinPlatformHook(EventCallback callback);
+  explicit WinPlatformHook(EventSink* sink);
   ~WinPlatformHook() override;
 
   bool Start() override;
   void Stop() override;
+  std::string GetFailureReason() const override;
 
  private:
   static LRESULT CALLBACK KeyboardProc(int code, WPARAM wParam, LPARAM lParam);
   static LRESULT CALLBACK MouseProc(int code, WPARAM wParam, LPARAM lParam);
+  static void CALLBACK ForegroundProc(HWINEVENTHOOK hook,
+                                      DWORD event,
+                                      HWND window,
+                                      LONG objectId,
+                                      LONG childId,
+                                      DWORD threadId,
+                                      DWORD time);
+  static LRESULT CALLBACK SessionWindowProc(HWND window,
+                                            UINT message,
+                                            WPARAM wParam,
+                                            LPARAM lParam);
+  void UpdateForeground(HWND window);
+  void CreateSessionWindow();
+  void DestroySessionWindow();
+  void UpdateLocked();
+  bool ShouldCapture() const;
+  void ApplyCapture();
+  bool OnPauseChanged() override;
+  void OnFocusRequested() override;
   void ThreadLoop();
+  void NotifyStartResult(bool success);
+  void NotifyResumeResult(bool success);
+  void SetFailureReason(std::string reason);
 
   static WinPlatformHook* instance_;
 
@@ -29,7 +56,23 @@ class WinPlatformHook : public PlatformHook {
   std::atomic<bool> running_{false};
   HHOOK keyboardHook_{nullptr};
   HHOOK mouseHook_{nullptr};
+  HWINEVENTHOOK foregroundHook_{nullptr};
+  // Only touched on the hook thread, where all hooks and the session window's
+  // messages are delivered.
+  HWND foreground_{nullptr};
+  HWND sessionWindow_{nullptr};
+  HPOWERNOTIFY displayNotification_{nullptr};
+  bool sessionLocked_{false};
+  bool displayOff_{false};
+  bool locked_{false};
   DWORD threadId_{0};
+  std::mutex startPromiseMutex_;
+  std::shared_ptr<std::promise<bool>> startPromise_;
+  // Set while a resume waits for the hook thread to reinstall the hooks.
+  std::mutex resumePromiseMutex_;
+  std::shared_ptr<std::promise<bool>> resumePromise_;
+  std::string failureReason_;
+  mutable std::mutex failureMutex_;
 };
 
 } // namespace win
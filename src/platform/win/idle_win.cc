@@ -0,0 +1,20 @@
+#include "../../common/idle.h"
+
+#include <windows.h>
+
+namespace inputhook {
+
+bool QueryIdleTime(double* idleMs, std::string* error) {
+  LASTINPUTINFO info;
+  info.cbSize = sizeof(info);
+  if (!GetLastInputInfo(&info)) {
+    *error = "GetLastInputInfo failed";
+    return false;
+  }
+  // Both are 32-bit tick counts, so unsigned subtraction survives the wrap
+  // every 49.7 days.
+  *idleMs = static_cast<double>(static_cast<DWORD>(GetTickCount() - info.dwTime));
+  return true;
+}
+
+} // namespace inputhook
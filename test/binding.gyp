@@ -0,0 +1,59 @@
+{
+  "targets": [
+    {
+      "target_name": "native_tests",
+      "type": "executable",
+      "sources": [
+        "native/app_usage_test.cc",
+        "native/event_codec_test.cc",
+        "native/event_stream_test.cc",
+        "native/gestures_test.cc",
+        "native/harness.cc",
+        "native/heatmap_test.cc",
+        "native/hotkeys_test.cc",
+        "native/keymap_test.cc",
+        "native/kinematics_test.cc",
+        "native/pipeline_test.cc",
+        "native/timeline_test.cc",
+        "native/typing_test.cc",
+        "../src/common/app_usage.cc",
+        "../src/common/event_stream.cc",
+        "../src/common/gestures.cc",
+        "../src/common/heatmap.cc",
+        "../src/common/hotkeys.cc",
+        "../src/common/kinematics.cc",
+        "../src/common/mapped_file.cc",
+        "../src/common/timeline.cc",
+        "../src/common/typing.cc"
+      ],
+      "conditions": [
+        ["OS!='win'", {
+          "sources": [
+            "native/event_broadcast_test.cc",
+            "native/frame_writer_test.cc",
+            "../src/common/event_broadcast.cc",
+            "../src/common/frame_writer.cc"
+          ]
+        }],
+        ["OS=='linux'", {
+          "sources": [
+            "native/evdev_test.cc"
+          ],
+          "libraries": [
+            "-lrt"
+          ]
+        }]
+      ],
+      "include_dirs": [
+        "<!(node -p \"require('node-addon-api').include.slice(1, -1)\")"
+      ],
+      "defines": [
+        "NAPI_DISABLE_CPP_EXCEPTIONS=1"
+      ],
+      "cflags_cc": ["-std=c++17"],
+      "xcode_settings": {
+        "OTHER_CPLUSPLUSFLAGS": ["-std=c++17"]
+      }
+    }
+  ]
+}
@@ -0,0 +1,17 @@
+// Runs the native unit tests built by `npm run test:build`.
+//
+//   npm run test:build && npm test [-- filter]
+
+const { spawnSync } = require('child_process');
+const fs = require('fs');
+const path = require('path');
+
+const name = process.platform === 'win32' ? 'native_tests.exe' : 'native_tests';
+const binary = path.join(__dirname, 'build', 'Release', name);
+if (!fs.existsSync(binary)) {
+  console.error('native tests not built. Run `npm run test:build` first.');
+  process.exit(1);
+}
+
+const result = spawnSync(binary, process.argv.slice(2), { stdio: 'inherit' });
+process.exit(result.status === null ? 1 : result.status);
@@ -0,0 +1,107 @@
+#include "../../src/common/app_usage.h"
+
+#include "harness.h"
+
+using inputhook::AppUsageLedger;
+using inputhook::AppUsageOptions;
+using inputhook::AppUsageSnapshot;
+using inputhook::InputEvent;
+
+namespace {
+
+InputEvent Focus(double time, const char* app, uint64_t window) {
+  InputEvent event;
+  event.type = "focus";
+  event.time = time;
+  event.app = app;
+  event.window = window;
+  event.pid = 42;
+  return event;
+}
+
+InputEvent Input(const char* type, double time, uint32_t usage = 0) {
+  InputEvent event;
+  event.type = type;
+  event.time = time;
+  if (usage) {
+    event.hidUsage = usage;
+  }
+  return event;
+}
+
+void Enable(AppUsageLedger& ledger, double idleThresholdMs) {
+  AppUsageOptions options;
+  options.enabled = true;
+  options.idleThresholdMs = idleThresholdMs;
+  ledger.Configure(options);
+}
+
+} // namespace
+
+TEST(AppUsageCreditsGapsWithinIdleThreshold) {
+  AppUsageLedger ledger;
+  Enable(ledger, 1000);
+  // Input before the first focus is not attributed.
+  ledger.Process(Input("keydown", 500, 0x04));
+  ledger.Process(Focus(1000, "editor", 1));
+  ledger.Process(Input("keydown", 1500, 0x05));
+  // Longer than the threshold: idle, not active.
+  ledger.Process(Input("keydown", 4000, 0x06));
+  ledger.Process(Focus(4400, "browser", 2));
+  ledger.Process(Input("mousedown", 4600));
+
+  // The stretch since the last input counts while it is still short.
+  AppUsageSnapshot snapshot = ledger.Snapshot(4800, false);
+  CHECK_EQ(snapshot.sinceMs, 500.0);
+  CHECK(snapshot.currentApp == "browser");
+  CHECK_EQ(snapshot.currentWindow, 2u);
+  CHECK_EQ(snapshot.apps.size(), 2u);
+  CHECK(snapshot.apps[0].app == "editor");
+  CHECK_EQ(snapshot.apps[0].pid, 42u);
+  CHECK_EQ(snapshot.apps[0].focusCount, 1u);
+  CHECK_NEAR(snapshot.apps[0].totals.activeMs, 900.0, 1e-9);
+  CHECK_EQ(snapshot.apps[0].totals.keys, 2u);
+  CHECK_EQ(snapshot.apps[0].windows.size(), 1u);
+  CHECK_EQ(snapshot.apps[0].windows[0].window, 1u);
+  CHECK_NEAR(snapshot.apps[0].windows[0].totals.activeMs, 900.0, 1e-9);
+  CHECK(snapshot.apps[1].app == "browser");
+  CHECK_NEAR(snapshot.apps[1].totals.activeMs, 400.0, 1e-9);
+  CHECK_EQ(snapshot.apps[1].totals.clicks, 1u);
+
+  snapshot = ledger.Snapshot(7000, false);
+  CHECK_NEAR(snapshot.apps[1].totals.activeMs, 200.0, 1e-9);
+}
+
+TEST(AppUsageSkipsAutorepeatAndResets) {
+  AppUsageLedger ledger;
+  Enable(ledger, 1000);
+  ledger.Process(Focus(900, "browser", 2));
+  ledger.Process(Focus(1000, "editor", 1));
+  ledger.Process(Input("keydown", 1100, 0x04));
+  ledger.Process(Input("keydown", 1130, 0x04));
+  ledger.Process(Input("keydown", 1160, 0x04));
+  ledger.Process(Input("keyup", 1200, 0x04));
+  ledger.Process(Input("keydown", 1300, 0x04));
+
+  AppUsageSnapshot snapshot = ledger.Snapshot(1300, true);
+  CHECK_EQ(snapshot.apps.size(), 2u);
+  CHECK(snapshot.apps[0].app == "editor");
+  CHECK_EQ(snapshot.apps[0].totals.keys, 2u);
+  CHECK_NEAR(snapshot.apps[0].totals.activeMs, 300.0, 1e-9);
+
+  // Only the focused app survives a reset, with empty totals; time already
+  // reported is not credited again.
+  snapshot = ledger.Snapshot(1500, false);
+  CHECK_EQ(snapshot.sinceMs, 1300.0);
+  CHECK_EQ(snapshot.apps.size(), 1u);
+  CHECK(snapshot.apps[0].app == "editor");
+  CHECK_EQ(snapshot.apps[0].focusCount, 0u);
+  CHECK_EQ(snapshot.apps[0].totals.keys, 0u);
+  CHECK_NEAR(snapshot.apps[0].totals.activeMs, 200.0, 1e-9);
+
+  ledger.Process(Input("keydown", 1600, 0x05));
+  snapshot = ledger.Snapshot(1600, false);
+  CHECK_EQ(snapshot.apps[0].totals.keys, 1u);
+  CHECK_NEAR(snapshot.apps[0].totals.activeMs, 300.0, 1e-9);
+  CHECK_NEAR(snapshot.apps[0].windows[0].totals.activeMs, 300.0, 1e-9);
+}
@@ -0,0 +1,124 @@
+#include "../../src/platform/linux/evdev_translator.h"
+
+#include <cstring>
+
+#include "harness.h"
+
+using inputhook::InputEvent;
+using inputhook::platform::linux::EvdevTranslator;
+
+namespace {
+
+// A recording as `evdev` reads it from a device or a file: back-to-back
+// struct input_event records, each frame closed by SYN_REPORT.
+class Recording {
+ public:
+  Recording& Add(uint16_t type, uint16_t code, int32_t value) {
+    struct input_event input {};
+    input.input_event_sec = static_cast<decltype(input.input_event_sec)>(time_ / 1000);
+    input.input_event_usec = static_cast<decltype(input.input_event_usec)>((time_ % 1000) * 1000);
+    input.type = type;
+    input.code = code;
+    input.value = value;
+    const auto* bytes = reinterpret_cast<const unsigned char*>(&input);
+    bytes_.insert(bytes_.end(), bytes, bytes + sizeof(input));
+    return *this;
+  }
+
+  Recording& Report() {
+    Add(EV_SYN, SYN_REPORT, 0);
+    time_ += 8;
+    return *this;
+  }
+
+  std::vector<InputEvent> Replay() const {
+    std::vector<InputEvent> events;
+    EvdevTranslator translator;
+    EvdevTranslator::Axes axes;
+    for (std::size_t offset = 0; offset + sizeof(struct input_event) <= bytes_.size();
+         offset += sizeof(struct input_event)) {
+      struct input_event input;
+      std::memcpy(&input, bytes_.data() + offset, sizeof(input));
+      double time = input.input_event_sec * 1000.0 + input.input_event_usec / 1000.0;
+      translator.Translate(axes, input.type, input.code, input.value, time,
+                           [&events](InputEvent&& event) { events.push_back(std::move(event)); });
+    }
+    return events;
+  }
+
+ private:
+  std::vector<unsigned char> bytes_;
+  long time_ = 1000;
+};
+
+} // namespace
+
+TEST(EvdevReplaysKeysWithModifiers) {
+  Recording recording;
+  recording.Add(EV_KEY, KEY_LEFTCTRL, 1).Report();
+  recording.Add(EV_KEY, KEY_A, 1).Report();
+  recording.Add(EV_KEY, KEY_A, 2).Report();
+  recording.Add(EV_KEY, KEY_A, 0).Report();
+  recording.Add(EV_KEY, KEY_LEFTCTRL, 0).Report();
+  recording.Add(EV_KEY, KEY_A, 1).Report();
+  auto events = recording.Replay();
+  CHECK_EQ(events.size(), 6u);
+  CHECK(events[1].type == "keydown" && *events[1].keycode == KEY_A + 8u);
+  CHECK(events[1].modifiers.ctrl);
+  CHECK(events[2].type == "keydown");
+  CHECK(events[3].type == "keyup" && events[3].modifiers.ctrl);
+  CHECK(!events[5].modifiers.ctrl);
+  CHECK_NEAR(events[1].time, 1008.0, 1e-9);
+}
+
+TEST(EvdevReplaysMotionBeforeButtons) {
+  Recording recording;
+  recording.Add(EV_REL, REL_X, 3).Add(EV_REL, REL_Y, -2).Add(EV_KEY, BTN_LEFT, 1).Report();
+  recording.Add(EV_KEY, BTN_SIDE, 1).Report();
+  recording.Add(EV_KEY, BTN_SIDE, 0).Report();
+  recording.Add(EV_KEY, BTN_EXTRA, 1).Report();
+  auto events = recording.Replay();
+  CHECK_EQ(events.size(), 5u);
+  CHECK(events[0].type == "mousemove" && *events[0].deltaX == 3 && *events[0].deltaY == -2);
+  CHECK(events[1].type == "mousedown" && *events[1].button == 0u);
+  CHECK(events[2].type == "mousedown" && *events[2].button == 3u);
+  CHECK(events[3].type == "mouseup" && *events[3].button == 3u);
+  CHECK(events[4].type == "mousedown" && *events[4].button == 4u);
+}
+
+TEST(EvdevReplaysLegacyWheel) {
+  Recording recording;
+  recording.Add(EV_REL, REL_WHEEL, -1).Report();
+  recording.Add(EV_REL, REL_HWHEEL, 1).Report();
+  auto events = recording.Replay();
+  CHECK_EQ(events.size(), 2u);
+  CHECK(events[0].type == "wheel" && *events[0].deltaY == -1 && !events[0].deltaX);
+  CHECK(events[1].type == "wheel" && *events[1].deltaX == -1 && !events[1].deltaY);
+}
+
+// A high-resolution wheel sends fractions of a notch and the legacy notch
+// once a whole one has accumulated; each notch must come out exactly once.
+TEST(EvdevReplaysHighResolutionWheel) {
+  Recording recording;
+  recording.Add(EV_REL, REL_WHEEL_HI_RES, 120).Add(EV_REL, REL_WHEEL, 1).Report();
+  recording.Add(EV_REL, REL_WHEEL_HI_RES, 60).Report();
+  recording.Add(EV_REL, REL_WHEEL_HI_RES, 60).Add(EV_REL, REL_WHEEL, 1).Report();
+  recording.Add(EV_REL, REL_WHEEL, -1).Add(EV_REL, REL_WHEEL_HI_RES, -240).Report();
+  recording.Add(EV_REL, REL_HWHEEL_HI_RES, 40).Report();
+  recording.Add(EV_REL, REL_HWHEEL_HI_RES, 80).Add(EV_REL, REL_HWHEEL, 1).Report();
+  auto events = recording.Replay();
+  CHECK_EQ(events.size(), 4u);
+  CHECK(events[0].type == "wheel" && *events[0].deltaY == 1);
+  CHECK(events[1].type == "wheel" && *events[1].deltaY == 1);
+  CHECK(events[2].type == "wheel" && *events[2].deltaY == -2);
+  CHECK(events[3].type == "wheel" && *events[3].deltaX == -1 && !events[3].deltaY);
+}
+
+TEST(EvdevDropsPartialFrameOnOverflow) {
+  Recording recording;
+  recording.Add(EV_REL, REL_X, 5).Add(EV_SYN, SYN_DROPPED, 0);
+  recording.Add(EV_REL, REL_Y, 1).Report();
+  auto events = recording.Replay();
+  CHECK_EQ(events.size(), 1u);
+  CHECK(!events[0].deltaX && *events[0].deltaY == 1);
+}
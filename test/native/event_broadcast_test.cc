@@ -0,0 +1,144 @@
+#include "../../src/common/event_broadcast.h"
+
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <cstring>
+
+#include "../../src/common/event_codec.h"
+#include "harness.h"
+
+using inputhook::BroadcastPublisher;
+using inputhook::BroadcastReadResult;
+using inputhook::BroadcastSubscriber;
+using inputhook::InputEvent;
+using inputhook::kEncodedEventSize;
+
+namespace {
+
+// Unique per process so parallel runs do not share a ring.
+std::string SegmentName(const char* name) {
+  std::string segment = std::string("inputhook-test-") + name + "-" + std::to_string(getpid());
+  shm_unlink(("/" + segment).c_str());
+  return segment;
+}
+
+void PublishKeys(BroadcastPublisher& publisher, double from, int count) {
+  for (int i = 0; i < count; ++i) {
+    InputEvent event;
+    event.type = "keydown";
+    event.time = from + i;
+    publisher.Publish(event);
+  }
+}
+
+double RecordTime(const std::vector<uint8_t>& records, std::size_t index) {
+  double time;
+  std::memcpy(&time, records.data() + index * kEncodedEventSize, sizeof(time));
+  return time;
+}
+
+} // namespace
+
+TEST(BroadcastReadsAcrossWrap) {
+  std::string name = SegmentName("wrap");
+  BroadcastPublisher publisher;
+  std::string error;
+  CHECK(publisher.Open(name, 4, &error));
+  BroadcastSubscriber subscriber;
+  CHECK(subscriber.Open(name, false, &error));
+
+  std::vector<uint8_t> records;
+  double time = 1;
+  for (int round = 0; round < 5; ++round) {
+    PublishKeys(publisher, time, 3);
+    time += 3;
+    BroadcastReadResult result = subscriber.Read(16, &records);
+    CHECK_EQ(result.records, 3u);
+    CHECK_EQ(result.lost, 0u);
+  }
+  CHECK_EQ(records.size(), 15 * kEncodedEventSize);
+  for (std::size_t i = 0; i < 15; ++i) {
+    CHECK_EQ(RecordTime(records, i), static_cast<double>(i + 1));
+  }
+  CHECK_EQ(subscriber.Sequence(), 15u);
+  CHECK_EQ(publisher.Sequence(), 15u);
+  CHECK_EQ(subscriber.PublisherPid(), static_cast<uint32_t>(getpid()));
+
+  subscriber.Close();
+  publisher.Close();
+  shm_unlink(("/" + name).c_str());
+}
+
+// A reader more than a ring behind skips to the oldest record still there and
+// counts the rest as lost.
+TEST(BroadcastCountsLostRecords) {
+  std::string name = SegmentName("loss");
+  BroadcastPublisher publisher;
+  std::string error;
+  CHECK(publisher.Open(name, 4, &error));
+  BroadcastSubscriber subscriber;
+  CHECK(subscriber.Open(name, false, &error));
+
+  PublishKeys(publisher, 1, 10);
+  std::vector<uint8_t> records;
+  BroadcastReadResult result = subscriber.Read(2, &records);
+  CHECK_EQ(result.records, 2u);
+  CHECK_EQ(result.lost, 6u);
+  CHECK_EQ(RecordTime(records, 0), 7.0);
+  result = subscriber.Read(16, &records);
+  CHECK_EQ(result.records, 2u);
+  CHECK_EQ(result.lost, 0u);
+  CHECK_EQ(RecordTime(records, 3), 10.0);
+  CHECK_EQ(subscriber.Lost(), 6u);
+
+  // fromStart replays what is left in the ring.
+  BroadcastSubscriber late;
+  CHECK(late.Open(name, true, &error));
+  records.clear();
+  CHECK_EQ(late.Read(16, &records).records, 4u);
+  CHECK_EQ(RecordTime(records, 0), 7.0);
+
+  late.Close();
+  subscriber.Close();
+  publisher.Close();
+  shm_unlink(("/" + name).c_str());
+}
+
+TEST(BroadcastFlagsReplacedSegment) {
+  std::string name = SegmentName("replace");
+  BroadcastPublisher publisher;
+  std::string error;
+  CHECK(publisher.Open(name, 4, &error));
+  BroadcastSubscriber subscriber;
+  CHECK(subscriber.Open(name, false, &error));
+  PublishKeys(publisher, 1, 2);
+
+  // Same capacity continues the ring.
+  CHECK(publisher.Open(name, 4, &error));
+  PublishKeys(publisher, 3, 1);
+  CHECK(!subscriber.Replaced());
+
+  CHECK(publisher.Open(name, 16, &error));
+  PublishKeys(publisher, 4, 1);
+  CHECK(subscriber.Replaced());
+  std::vector<uint8_t> records;
+  BroadcastReadResult result = subscriber.Read(2, &records);
+  CHECK_EQ(result.records, 2u);
+  CHECK(!result.replaced);
+  result = subscriber.Read(16, &records);
+  CHECK_EQ(result.records, 1u);
+  CHECK(result.replaced);
+
+  BroadcastSubscriber fresh;
+  CHECK(fresh.Open(name, true, &error));
+  CHECK(!fresh.Replaced());
+  records.clear();
+  CHECK_EQ(fresh.Read(16, &records).records, 1u);
+  CHECK_EQ(RecordTime(records, 0), 4.0);
+
+  fresh.Close();
+  subscriber.Close();
+  publisher.Close();
+  shm_unlink(("/" + name).c_str());
+}
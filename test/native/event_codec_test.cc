@@ -0,0 +1,138 @@
+#include "../../src/common/event_codec.h"
+
+#include <cstring>
+
+#include "harness.h"
+
+using inputhook::EncodeEvent;
+using inputhook::InputEvent;
+using inputhook::kEncodedEventSize;
+
+namespace {
+
+// Same type order as `encodedTypes` in index.js.
+const char* const kTypeNames[] = {"other", "keydown", "keyup", "mousedown", "mouseup",
+                                  "mousemove", "wheel", "focus", "lock", "unlock",
+                                  "click", "dragstart", "dragend"};
+
+template <typename T>
+T Read(const uint8_t* record, std::size_t offset) {
+  T value;
+  std::memcpy(&value, record + offset, sizeof(value));
+  return value;
+}
+
+// Mirrors decodeEvents() in index.js, so a record that survives this
+// survives the JS decoder.
+InputEvent Decode(const uint8_t* record) {
+  InputEvent event;
+  uint8_t type = record[8];
+  event.type = type < sizeof(kTypeNames) / sizeof(kTypeNames[0]) ? kTypeNames[type] : "other";
+  event.time = Read<double>(record, 0);
+  event.modifiers.shift = (record[9] & 1) != 0;
+  event.modifiers.ctrl = (record[9] & 2) != 0;
+  event.modifiers.alt = (record[9] & 4) != 0;
+  event.modifiers.meta = (record[9] & 8) != 0;
+  uint16_t fields = Read<uint16_t>(record, 10);
+  if (fields & inputhook::kEncodedKeycode) {
+    event.keycode = Read<uint32_t>(record, 12);
+  }
+  if (fields & inputhook::kEncodedScancode) {
+    event.scancode = Read<uint32_t>(record, 16);
+  }
+  if (fields & inputhook::kEncodedHidUsage) {
+    event.hidUsage = Read<uint16_t>(record, 20);
+  }
+  if (fields & inputhook::kEncodedButton) {
+    event.button = record[22];
+  }
+  if (fields & inputhook::kEncodedClicks) {
+    event.clicks = record[23];
+  }
+  if (fields & inputhook::kEncodedPosition) {
+    event.x = Read<int32_t>(record, 24);
+    event.y = Read<int32_t>(record, 28);
+  }
+  if (fields & inputhook::kEncodedDeltaX) {
+    event.deltaX = Read<int32_t>(record, 32);
+  }
+  if (fields & inputhook::kEncodedDeltaY) {
+    event.deltaY = Read<int32_t>(record, 36);
+  }
+  if (fields & inputhook::kEncodedWindow) {
+    event.window = Read<uint64_t>(record, 40);
+  }
+  return event;
+}
+
+InputEvent RoundTrip(const InputEvent& event) {
+  uint8_t record[kEncodedEventSize];
+  std::memset(record, 0xAB, sizeof(record));
+  EncodeEvent(event, record);
+  return Decode(record);
+}
+
+} // namespace
+
+TEST(CodecRoundTripsKeys) {
+  InputEvent event;
+  event.type = "keydown";
+  event.time = 1704067200123.5;
+  event.keycode = 38;
+  event.scancode = 0x1E;
+  event.hidUsage = 0x04;
+  event.modifiers.ctrl = true;
+  event.modifiers.meta = true;
+  InputEvent decoded = RoundTrip(event);
+  CHECK(decoded.type == "keydown");
+  CHECK_EQ(decoded.time, event.time);
+  CHECK_EQ(*decoded.keycode, 38u);
+  CHECK_EQ(*decoded.scancode, 0x1Eu);
+  CHECK_EQ(*decoded.hidUsage, 0x04u);
+  CHECK(!decoded.modifiers.shift && decoded.modifiers.ctrl);
+  CHECK(!decoded.modifiers.alt && decoded.modifiers.meta);
+  CHECK(!decoded.button && !decoded.x && !decoded.deltaX && !decoded.window);
+}
+
+TEST(CodecRoundTripsPointerFields) {
+  InputEvent event;
+  event.type = "click";
+  event.time = 42.0;
+  event.button = 4;
+  event.clicks = 300;
+  event.x = -1920;
+  event.y = 1080;
+  event.deltaX = -7;
+  event.deltaY = 0;
+  event.window = 0x1234567890ULL;
+  InputEvent decoded = RoundTrip(event);
+  CHECK(decoded.type == "click");
+  CHECK_EQ(*decoded.button, 4u);
+  // Saturated to fit its byte.
+  CHECK_EQ(*decoded.clicks, 255u);
+  CHECK_EQ(*decoded.x, -1920);
+  CHECK_EQ(*decoded.y, 1080);
+  CHECK_EQ(*decoded.deltaX, -7);
+  // A present zero stays present.
+  CHECK(decoded.deltaY && *decoded.deltaY == 0);
+  CHECK_EQ(*decoded.window, 0x1234567890ULL);
+  CHECK(!decoded.keycode && !decoded.hidUsage);
+}
+
+TEST(CodecKeepsEveryTypeName) {
+  for (const char* name : kTypeNames) {
+    InputEvent event;
+    event.type = name;
+    CHECK(RoundTrip(event).type == name);
+  }
+  InputEvent unknown;
+  unknown.type = "gesture";
+  CHECK(RoundTrip(unknown).type == "other");
+
+  // Half a position is not encoded.
+  InputEvent partial;
+  partial.type = "mousemove";
+  partial.x = 5;
+  InputEvent decoded = RoundTrip(partial);
+  CHECK(!decoded.x && !decoded.y);
+}
@@ -0,0 +1,104 @@
+#include "../../src/common/event_stream.h"
+
+#include "harness.h"
+
+using inputhook::EventStream;
+using inputhook::EventStreamStats;
+using inputhook::InputEvent;
+
+namespace {
+
+InputEvent Move(double time, int32_t x, int32_t y, int32_t deltaX) {
+  InputEvent event;
+  event.type = "mousemove";
+  event.time = time;
+  event.x = x;
+  event.y = y;
+  event.deltaX = deltaX;
+  return event;
+}
+
+InputEvent Key(double time) {
+  InputEvent event;
+  event.type = "keydown";
+  event.time = time;
+  event.keycode = 38;
+  return event;
+}
+
+} // namespace
+
+// The hook thread only wakes the reader after it found the queue empty, and
+// only once for that empty read.
+TEST(EventStreamWakesOncePerEmptyRead) {
+  EventStream stream;
+  CHECK(!stream.Push(Key(1)));
+  stream.Open(4);
+  CHECK(!stream.Push(Key(1)));
+
+  std::vector<InputEvent> events;
+  CHECK_EQ(stream.Pop(16, &events), 1u);
+  CHECK_EQ(stream.Pop(16, &events), 0u);
+  CHECK(stream.Push(Key(2)));
+  CHECK(!stream.Push(Key(3)));
+  CHECK_EQ(stream.Pop(1, &events), 1u);
+  CHECK_EQ(stream.Pop(16, &events), 1u);
+  CHECK_EQ(events.size(), 3u);
+  CHECK_EQ(events[2].time, 3.0);
+
+  stream.Close();
+  CHECK(!stream.IsOpen());
+  CHECK(!stream.Push(Key(4)));
+}
+
+TEST(EventStreamKeepsOrderAcrossWrap) {
+  EventStream stream;
+  stream.Open(3);
+  std::vector<InputEvent> events;
+  double time = 0;
+  for (int round = 0; round < 4; ++round) {
+    stream.Push(Key(++time));
+    stream.Push(Key(++time));
+    CHECK_EQ(stream.Pop(16, &events), 2u);
+  }
+  CHECK_EQ(events.size(), 8u);
+  for (std::size_t i = 0; i < events.size(); ++i) {
+    CHECK_EQ(events[i].time, static_cast<double>(i + 1));
+  }
+  EventStreamStats stats = stream.Stats();
+  CHECK_EQ(stats.queued, 8u);
+  CHECK_EQ(stats.depth, 0u);
+  CHECK_EQ(stats.highWater, 2u);
+}
+
+// A full queue folds motion into the newest queued motion and drops the
+// rest, counting both.
+TEST(EventStreamCoalescesWhenFull) {
+  EventStream stream;
+  stream.Open(2);
+  stream.Push(Key(1));
+  stream.Push(Move(2, 10, 10, 1));
+  stream.Push(Move(3, 20, 30, 2));
+  stream.Push(Move(4, 25, 35, 3));
+  stream.Push(Key(5));
+
+  EventStreamStats stats = stream.Stats();
+  CHECK_EQ(stats.queued, 2u);
+  CHECK_EQ(stats.coalesced, 2u);
+  CHECK_EQ(stats.dropped, 1u);
+  CHECK_EQ(stats.depth, 2u);
+
+  std::vector<InputEvent> events;
+  CHECK_EQ(stream.Pop(16, &events), 2u);
+  CHECK(events[1].type == "mousemove");
+  CHECK_EQ(events[1].time, 4.0);
+  CHECK_EQ(*events[1].x, 25);
+  CHECK_EQ(*events[1].y, 35);
+  CHECK_EQ(*events[1].deltaX, 6);
+
+  // With a key newest, motion has nothing to fold into.
+  stream.Push(Move(6, 0, 0, 1));
+  stream.Push(Key(7));
+  stream.Push(Move(8, 1, 1, 1));
+  CHECK_EQ(stream.Stats().dropped, 2u);
+}
@@ -0,0 +1,149 @@
+#include "../../src/common/frame_writer.h"
+
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <cstring>
+#include <thread>
+
+#include "../../src/common/event_codec.h"
+#include "harness.h"
+
+using inputhook::FrameWriter;
+using inputhook::FrameWriterStats;
+using inputhook::InputEvent;
+using inputhook::kEncodedEventSize;
+
+namespace {
+
+InputEvent Key(double time) {
+  InputEvent event;
+  event.type = "keydown";
+  event.time = time;
+  event.keycode = 38;
+  return event;
+}
+
+// Reads exactly `size` bytes, giving up after a second without data.
+bool ReadFully(int fd, uint8_t* out, std::size_t size) {
+  while (size > 0) {
+    pollfd ready{fd, POLLIN, 0};
+    if (poll(&ready, 1, 1000) <= 0) {
+      return false;
+    }
+    ssize_t got = read(fd, out, size);
+    if (got <= 0) {
+      return false;
+    }
+    out += got;
+    size -= static_cast<std::size_t>(got);
+  }
+  return true;
+}
+
+// Reads frames until `count` events arrived; returns the number of frames, or
+// 0 when a frame is torn or an event is out of order.
+std::size_t ReadEvents(int fd, std::size_t count) {
+  std::size_t frames = 0;
+  std::size_t seen = 0;
+  std::vector<uint8_t> records;
+  while (seen < count) {
+    uint8_t header[4];
+    if (!ReadFully(fd, header, sizeof(header))) {
+      return 0;
+    }
+    uint32_t size = header[0] | header[1] << 8 | header[2] << 16 |
+                    static_cast<uint32_t>(header[3]) << 24;
+    if (size == 0 || size % kEncodedEventSize != 0 ||
+        size > FrameWriter::kMaxFrameEvents * kEncodedEventSize) {
+      return 0;
+    }
+    records.resize(size);
+    if (!ReadFully(fd, records.data(), size)) {
+      return 0;
+    }
+    for (std::size_t offset = 0; offset < size; offset += kEncodedEventSize) {
+      double time;
+      std::memcpy(&time, records.data() + offset, sizeof(time));
+      if (time != static_cast<double>(++seen)) {
+        return 0;
+      }
+    }
+    ++frames;
+  }
+  return frames;
+}
+
+// The writer counts a frame just after the peer could read it.
+FrameWriterStats WaitForEvents(const FrameWriter& writer, uint64_t events) {
+  FrameWriterStats stats = writer.Stats();
+  for (int i = 0; i < 100 && stats.events < events; ++i) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    stats = writer.Stats();
+  }
+  return stats;
+}
+
+} // namespace
+
+TEST(FrameWriterFramesRecords) {
+  int sockets[2];
+  CHECK(socketpair(AF_UNIX, SOCK_STREAM, 0, sockets) == 0);
+  FrameWriter writer;
+  std::string error;
+  CHECK(writer.OpenFd(sockets[0], 64, &error));
+  close(sockets[0]);
+
+  for (int i = 1; i <= 3; ++i) {
+    writer.Push(Key(i));
+  }
+  std::size_t frames = ReadEvents(sockets[1], 3);
+  CHECK(frames >= 1 && frames <= 3);
+
+  FrameWriterStats stats = WaitForEvents(writer, 3);
+  CHECK_EQ(stats.frames, frames);
+  CHECK_EQ(stats.events, 3u);
+  CHECK_EQ(stats.bytes, frames * 4 + 3 * kEncodedEventSize);
+  CHECK(stats.error.empty());
+
+  // Once the peer is gone the writer fails instead of raising SIGPIPE.
+  close(sockets[1]);
+  writer.Push(Key(4));
+  for (int i = 0; i < 100 && writer.IsOpen(); ++i) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  }
+  CHECK(!writer.IsOpen());
+  CHECK(!writer.Stats().error.empty());
+  writer.Close();
+}
+
+// Frames larger than the socket buffer go out in pieces while the peer is
+// not reading; none of them may arrive torn.
+TEST(FrameWriterResumesShortWrites) {
+  int sockets[2];
+  CHECK(socketpair(AF_UNIX, SOCK_STREAM, 0, sockets) == 0);
+  int small = 4096;
+  setsockopt(sockets[0], SOL_SOCKET, SO_SNDBUF, &small, sizeof(small));
+  setsockopt(sockets[1], SOL_SOCKET, SO_RCVBUF, &small, sizeof(small));
+  FrameWriter writer;
+  std::string error;
+  CHECK(writer.OpenFd(sockets[0], 4096, &error));
+  close(sockets[0]);
+
+  const std::size_t count = 3000;
+  for (std::size_t i = 1; i <= count; ++i) {
+    writer.Push(Key(static_cast<double>(i)));
+  }
+  // Let the writer fill the buffer and back off.
+  std::this_thread::sleep_for(std::chrono::milliseconds(50));
+  CHECK(ReadEvents(sockets[1], count) > 0);
+
+  FrameWriterStats stats = WaitForEvents(writer, count);
+  CHECK_EQ(stats.events, count);
+  CHECK_EQ(stats.dropped, 0u);
+  CHECK(stats.error.empty());
+  writer.Close();
+  close(sockets[1]);
+}
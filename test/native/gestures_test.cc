@@ -0,0 +1,95 @@
+#include "../../src/common/gestures.h"
+
+#include "harness.h"
+
+using inputhook::GestureOptions;
+using inputhook::GestureTracker;
+using inputhook::InputEvent;
+
+namespace {
+
+InputEvent Pointer(const char* type, double time, int32_t x, int32_t y) {
+  InputEvent event;
+  event.type = type;
+  event.time = time;
+  event.x = x;
+  event.y = y;
+  if (event.type != "mousemove") {
+    event.button = 0;
+  }
+  return event;
+}
+
+std::vector<InputEvent> Feed(GestureTracker& tracker, InputEvent event) {
+  std::vector<InputEvent> derived;
+  tracker.Process(event, &derived);
+  return derived;
+}
+
+void Enable(GestureTracker& tracker) {
+  GestureOptions options;
+  options.enabled = true;
+  tracker.Configure(options);
+}
+
+} // namespace
+
+TEST(GestureCountsMultiClicks) {
+  GestureTracker tracker;
+  Enable(tracker);
+  InputEvent down = Pointer("mousedown", 0, 10, 10);
+  tracker.Process(down, nullptr);
+  CHECK_EQ(down.clicks.value_or(0), 1u);
+  auto derived = Feed(tracker, Pointer("mouseup", 50, 10, 10));
+  CHECK(derived.size() == 1 && derived[0].type == "click");
+
+  InputEvent second = Pointer("mousedown", 200, 12, 11);
+  tracker.Process(second, nullptr);
+  CHECK_EQ(second.clicks.value_or(0), 2u);
+  Feed(tracker, Pointer("mouseup", 250, 12, 11));
+
+  // Too far away starts a new series.
+  InputEvent far = Pointer("mousedown", 300, 40, 40);
+  tracker.Process(far, nullptr);
+  CHECK_EQ(far.clicks.value_or(0), 1u);
+}
+
+TEST(GestureDragCarriesBounds) {
+  GestureTracker tracker;
+  Enable(tracker);
+  Feed(tracker, Pointer("mousedown", 0, 100, 100));
+  CHECK(Feed(tracker, Pointer("mousemove", 10, 102, 100)).empty());
+  auto started = Feed(tracker, Pointer("mousemove", 20, 90, 120));
+  CHECK_EQ(started.size(), 1u);
+  if (started.size() == 1) {
+    CHECK(started[0].type == "dragstart");
+    CHECK_EQ(*started[0].x, 100);
+    CHECK(started[0].bounds.has_value());
+    CHECK_EQ(started[0].bounds->left, 90);
+    CHECK_EQ(started[0].bounds->right, 102);
+    CHECK_EQ(started[0].bounds->bottom, 120);
+  }
+  Feed(tracker, Pointer("mousemove", 30, 130, 95));
+  auto ended = Feed(tracker, Pointer("mouseup", 40, 120, 110));
+  CHECK_EQ(ended.size(), 1u);
+  if (ended.size() == 1) {
+    CHECK(ended[0].type == "dragend");
+    CHECK_EQ(*ended[0].deltaX, 20);
+    CHECK_EQ(*ended[0].deltaY, 10);
+    CHECK_EQ(*ended[0].duration, 40.0);
+    CHECK(ended[0].bounds.has_value());
+    CHECK_EQ(ended[0].bounds->left, 90);
+    CHECK_EQ(ended[0].bounds->top, 95);
+    CHECK_EQ(ended[0].bounds->right, 130);
+    CHECK_EQ(ended[0].bounds->bottom, 120);
+  }
+}
+
+TEST(GestureResetDropsHeldButtons) {
+  GestureTracker tracker;
+  Enable(tracker);
+  Feed(tracker, Pointer("mousedown", 0, 0, 0));
+  tracker.Reset();
+  CHECK(Feed(tracker, Pointer("mousemove", 10, 50, 50)).empty());
+  CHECK(Feed(tracker, Pointer("mouseup", 20, 50, 50)).empty());
+}
@@ -0,0 +1,43 @@
+#include "harness.h"
+
+namespace inputhook {
+namespace test {
+
+namespace {
+
+int g_failures = 0;
+
+} // namespace
+
+std::vector<TestCase>& Registry() {
+  static std::vector<TestCase> registry;
+  return registry;
+}
+
+void Fail(const char* file, int line, const std::string& message) {
+  ++g_failures;
+  std::fprintf(stderr, "  %s:%d: %s\n", file, line, message.c_str());
+}
+
+} // namespace test
+} // namespace inputhook
+
+// Runs every registered case, or only those whose name contains argv[1].
+int main(int argc, char** argv) {
+  using namespace inputhook::test;
+  int failedCases = 0;
+  int ran = 0;
+  for (const TestCase& testCase : Registry()) {
+    if (argc > 1 && std::string(testCase.name).find(argv[1]) == std::string::npos) {
+      continue;
+    }
+    int before = g_failures;
+    testCase.body();
+    ++ran;
+    bool passed = g_failures == before;
+    failedCases += passed ? 0 : 1;
+    std::printf("%s %s\n", passed ? "ok  " : "FAIL", testCase.name);
+  }
+  std::printf("%d/%d passed\n", ran - failedCases, ran);
+  return failedCases == 0 ? 0 : 1;
+}
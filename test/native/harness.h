@@ -0,0 +1,57 @@
+#pragma once
+
+#include <cmath>
+#include <cstdio>
+#include <functional>
+#include <string>
+#include <vector>
+
+// Minimal test registry for the native unit tests: TEST() registers a case,
+// CHECK*() record failures without aborting it, and harness.cc runs them all.
+namespace inputhook {
+namespace test {
+
+struct TestCase {
+  const char* name;
+  std::function<void()> body;
+};
+
+std::vector<TestCase>& Registry();
+void Fail(const char* file, int line, const std::string& message);
+
+struct Registration {
+  Registration(const char* name, std::function<void()> body) {
+    Registry().push_back({name, std::move(body)});
+  }
+};
+
+template <typename A, typename B>
+void CheckEqual(const A& actual, const B& expected, const char* expression, const char* file,
+                int line) {
+  if (!(actual == expected)) {
+    Fail(file, line, std::string(expression) + ": got " + std::to_string(actual) +
+                         ", expected " + std::to_string(expected));
+  }
+}
+
+} // namespace test
+} // namespace inputhook
+
+#define TEST(name)                                                              \
+  static void name();                                                           \
+  static ::inputhook::test::Registration name##Registration(#name, name);       \
+  static void name()
+
+#define CHECK(condition)                                                        \
+  do {                                                                          \
+    if (!(condition)) {                                                         \
+      ::inputhook::test::Fail(__FILE__, __LINE__, #condition);                  \
+    }                                                                           \
+  } while (0)
+
+#define CHECK_EQ(actual, expected)                                              \
+  ::inputhook::test::CheckEqual((actual), (expected), #actual " == " #expected, \
+                                __FILE__, __LINE__)
+
+#define CHECK_NEAR(actual, expected, tolerance)                                 \
+  CHECK(std::fabs(static_cast<double>(actual) - static_cast<double>(expected)) <= (tolerance))
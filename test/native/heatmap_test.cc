@@ -0,0 +1,82 @@
+#include "../../src/common/heatmap.h"
+
+#include "harness.h"
+
+using inputhook::HeatmapAggregator;
+using inputhook::HeatmapOptions;
+using inputhook::InputEvent;
+
+namespace {
+
+void Enable(HeatmapAggregator& heatmap) {
+  HeatmapOptions options;
+  options.enabled = true;
+  options.columns = 2;
+  options.rows = 2;
+  options.width = 100;
+  options.height = 100;
+  heatmap.Configure(options);
+}
+
+InputEvent Move(double time, int32_t x, int32_t y) {
+  InputEvent event;
+  event.type = "mousemove";
+  event.time = time;
+  event.x = x;
+  event.y = y;
+  return event;
+}
+
+InputEvent RawMove(double time, double dx, double dy) {
+  InputEvent event;
+  event.type = "mousemove";
+  event.time = time;
+  event.deltaX = dx;
+  event.deltaY = dy;
+  return event;
+}
+
+} // namespace
+
+TEST(HeatmapCreditsDwellToPreviousCell) {
+  HeatmapAggregator heatmap;
+  Enable(heatmap);
+  heatmap.Process(Move(1000, 10, 10));
+  heatmap.Process(Move(1300, 90, 90));
+  heatmap.Process(Move(1400, 90, 90));
+  auto snapshot = heatmap.Snapshot(false);
+  CHECK_NEAR(snapshot.dwell[0], 300.0, 1e-9);
+  CHECK_NEAR(snapshot.dwell[3], 100.0, 1e-9);
+  CHECK_NEAR(snapshot.durationMs, 400.0, 1e-9);
+}
+
+TEST(HeatmapIgnoresDeltasOnceAbsolute) {
+  HeatmapAggregator heatmap;
+  Enable(heatmap);
+  heatmap.Process(Move(1000, 10, 10));
+  heatmap.Process(RawMove(1100, 80, 80));
+  InputEvent down;
+  down.type = "mousedown";
+  down.time = 1200;
+  down.button = 0;
+  heatmap.Process(down);
+  auto snapshot = heatmap.Snapshot(false);
+  CHECK_EQ(snapshot.clicks[0], 1u);
+  CHECK_NEAR(snapshot.dwell[0], 200.0, 1e-9);
+}
+
+TEST(HeatmapIntegratesDeltasFromScreenCentre) {
+  HeatmapAggregator heatmap;
+  Enable(heatmap);
+  heatmap.Process(RawMove(1000, -20, -20));
+  heatmap.Process(RawMove(1100, -500, 500));
+  InputEvent down;
+  down.type = "mousedown";
+  down.time = 1200;
+  down.button = 0;
+  heatmap.Process(down);
+  auto snapshot = heatmap.Snapshot(false);
+  CHECK_NEAR(snapshot.dwell[0], 100.0, 1e-9);
+  // Clamped to the bottom-left corner rather than running off screen.
+  CHECK_EQ(snapshot.clicks[2], 1u);
+}
@@ -0,0 +1,133 @@
+#include "../../src/common/hotkeys.h"
+
+#include "harness.h"
+
+using inputhook::HotkeyChord;
+using inputhook::HotkeyDefinition;
+using inputhook::HotkeyMatch;
+using inputhook::HotkeyMatcher;
+using inputhook::InputEvent;
+
+namespace {
+
+constexpr uint32_t kA = 0x04;
+constexpr uint32_t kC = 0x06;
+constexpr uint32_t kK = 0x0E;
+constexpr uint32_t kX = 0x1B;
+
+HotkeyChord Ctrl(std::vector<uint32_t> usages) {
+  HotkeyChord chord;
+  chord.modifiers.ctrl = true;
+  chord.usages = std::move(usages);
+  return chord;
+}
+
+InputEvent Key(const char* type, uint32_t usage, double time, bool ctrl = true) {
+  InputEvent event;
+  event.type = type;
+  event.time = time;
+  event.hidUsage = usage;
+  event.modifiers.ctrl = ctrl;
+  return event;
+}
+
+std::vector<HotkeyMatch> Feed(HotkeyMatcher& matcher, const InputEvent& event) {
+  std::vector<HotkeyMatch> matches;
+  matcher.Process(event, &matches);
+  return matches;
+}
+
+void Register(HotkeyMatcher& matcher) {
+  std::vector<HotkeyDefinition> definitions(2);
+  definitions[0].id = "kill";
+  definitions[0].sequence = {Ctrl({kK})};
+  definitions[1].id = "copy-chain";
+  definitions[1].sequence = {Ctrl({kK}), Ctrl({kC})};
+  definitions[1].sequenceTimeoutMs = 500;
+  std::string error;
+  CHECK(matcher.SetHotkeys(definitions, &error));
+}
+
+} // namespace
+
+TEST(HotkeyChordMatchesOncePerStroke) {
+  HotkeyMatcher matcher;
+  Register(matcher);
+  auto matches = Feed(matcher, Key("keydown", kK, 0));
+  CHECK_EQ(matches.size(), 1u);
+  CHECK(matches.size() == 1 && matches[0].id == "kill");
+  // Auto-repeat is not a new stroke.
+  CHECK_EQ(Feed(matcher, Key("keydown", kK, 30)).size(), 0u);
+  Feed(matcher, Key("keyup", kK, 60));
+  CHECK_EQ(Feed(matcher, Key("keydown", kK, 90)).size(), 1u);
+  // Modifiers must match exactly.
+  Feed(matcher, Key("keyup", kK, 120));
+  CHECK_EQ(Feed(matcher, Key("keydown", kK, 150, false)).size(), 0u);
+}
+
+TEST(HotkeySequenceWithinTimeout) {
+  HotkeyMatcher matcher;
+  Register(matcher);
+  Feed(matcher, Key("keydown", kK, 0));
+  Feed(matcher, Key("keyup", kK, 50));
+  auto matches = Feed(matcher, Key("keydown", kC, 300));
+  CHECK_EQ(matches.size(), 1u);
+  CHECK(matches.size() == 1 && matches[0].id == "copy-chain");
+  CHECK_EQ(matches.size() == 1 ? matches[0].time : 0.0, 300.0);
+}
+
+TEST(HotkeySequenceExpiresAndBreaks) {
+  HotkeyMatcher matcher;
+  Register(matcher);
+  Feed(matcher, Key("keydown", kK, 0));
+  Feed(matcher, Key("keyup", kK, 50));
+  CHECK_EQ(Feed(matcher, Key("keydown", kC, 900)).size(), 0u);
+  Feed(matcher, Key("keyup", kC, 950));
+
+  // A key no hotkey uses resets pending sequences.
+  Feed(matcher, Key("keydown", kK, 1000));
+  Feed(matcher, Key("keyup", kK, 1010));
+  Feed(matcher, Key("keydown", kX, 1020));
+  Feed(matcher, Key("keyup", kX, 1030));
+  CHECK_EQ(Feed(matcher, Key("keydown", kC, 1040)).size(), 0u);
+}
+
+TEST(HotkeyChordNeedsExactKeySet) {
+  HotkeyMatcher matcher;
+  std::vector<HotkeyDefinition> definitions(1);
+  definitions[0].id = "ak";
+  definitions[0].sequence = {Ctrl({kA, kK})};
+  std::string error;
+  CHECK(matcher.SetHotkeys(definitions, &error));
+  CHECK_EQ(Feed(matcher, Key("keydown", kA, 0)).size(), 0u);
+  CHECK_EQ(Feed(matcher, Key("keydown", kK, 10)).size(), 1u);
+  Feed(matcher, Key("keyup", kK, 20));
+  // Held A plus an extra C is not the chord.
+  CHECK_EQ(Feed(matcher, Key("keydown", kC, 30)).size(), 0u);
+}
+
+// A keyup lost while the hook could not see it (pause, lock, reconnect)
+// leaves the key held until Reset().
+TEST(HotkeyResetForgetsMissedKeyups) {
+  HotkeyMatcher matcher;
+  Register(matcher);
+  CHECK_EQ(Feed(matcher, Key("keydown", kA, 0)).size(), 0u);
+  CHECK_EQ(Feed(matcher, Key("keydown", kK, 10)).size(), 0u);
+  Feed(matcher, Key("keyup", kK, 20));
+  matcher.Reset();
+  CHECK_EQ(Feed(matcher, Key("keydown", kK, 30)).size(), 1u);
+}
+
+TEST(HotkeyRejectsInvalidDefinitions) {
+  HotkeyMatcher matcher;
+  std::vector<HotkeyDefinition> definitions(1);
+  definitions[0].id = "bad";
+  std::string error;
+  CHECK(!matcher.SetHotkeys(definitions, &error));
+  definitions[0].sequence = {Ctrl({0xE0})};
+  CHECK(!matcher.SetHotkeys(definitions, &error));
+  CHECK(error.find("invalid key usage") != std::string::npos);
+  definitions[0].sequence = {Ctrl({300})};
+  CHECK(!matcher.SetHotkeys(definitions, &error));
+  CHECK(matcher.Empty());
+}
@@ -0,0 +1,63 @@
+#include "../../src/common/keymap.h"
+
+#include "harness.h"
+
+using namespace inputhook::keymap;
+
+namespace {
+
+// `alias` names a native code that legitimately shares its usage with another.
+template <std::size_t Count>
+bool UsagesUnique(const KeyMapping (&mappings)[Count], uint16_t alias = 0xFFFF) {
+  for (std::size_t i = 0; i < Count; ++i) {
+    for (std::size_t j = i + 1; j < Count; ++j) {
+      if (mappings[i].usage == mappings[j].usage && mappings[i].native != alias &&
+          mappings[j].native != alias) {
+        std::fprintf(stderr, "  native %u and %u both map to usage 0x%02X\n",
+                     mappings[i].native, mappings[j].native, mappings[i].usage);
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+} // namespace
+
+// Every table describes physical keys, so no two native codes may claim the
+// same usage.
+TEST(KeymapUsagesAreUnique) {
+  CHECK(UsagesUnique(kEvdevMappings));
+  // Alt+PrintScreen arrives as the SysRq scan code 0x54.
+  CHECK(UsagesUnique(kScancodeMappings, 0x54));
+  CHECK(UsagesUnique(kMacMappings));
+}
+
+TEST(KeymapEvdevAndX11) {
+  CHECK_EQ(UsageFromEvdev(1), 0x29);    // KEY_ESC
+  CHECK_EQ(UsageFromEvdev(41), 0x35);   // KEY_GRAVE
+  CHECK_EQ(UsageFromEvdev(85), 0x94);   // KEY_ZENKAKUHANKAKU -> LANG5
+  CHECK_EQ(UsageFromEvdev(125), 0xE3);  // KEY_LEFTMETA
+  CHECK_EQ(UsageFromEvdev(84), kUsageNone);
+  CHECK_EQ(UsageFromEvdev(100000), kUsageNone);
+  CHECK_EQ(UsageFromXKeycode(38), 0x04);  // 'a' on evdev-based X servers
+  CHECK_EQ(UsageFromXKeycode(3), kUsageNone);
+}
+
+TEST(KeymapScancodes) {
+  CHECK_EQ(UsageFromScancode(0x1C, false), 0x28);  // Enter
+  CHECK_EQ(UsageFromScancode(0x1C, true), 0x58);   // Keypad Enter
+  CHECK_EQ(UsageFromScancode(0x45, false), 0x48);  // Pause
+  CHECK_EQ(UsageFromScancode(0x45, true), 0x53);   // NumLock
+  CHECK_EQ(UsageFromScancode(0x1D, true), 0xE4);   // Right Ctrl
+  CHECK_EQ(UsageFromScancode(0x37, true), 0x46);   // PrintScreen
+  CHECK_EQ(UsageFromScancode(0x54, false), 0x46);  // SysRq
+  CHECK_EQ(UsageFromScancode(0x200, false), kUsageNone);
+}
+
+TEST(KeymapMac) {
+  CHECK_EQ(UsageFromMacKeycode(0x00), 0x04);  // kVK_ANSI_A
+  CHECK_EQ(UsageFromMacKeycode(0x37), 0xE3);  // kVK_Command
+  CHECK_EQ(UsageFromMacKeycode(0x34), kUsageNone);
+  CHECK_EQ(UsageFromMacKeycode(0x80), kUsageNone);
+}
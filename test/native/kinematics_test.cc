@@ -0,0 +1,76 @@
+#include "../../src/common/kinematics.h"
+
+#include "harness.h"
+
+using inputhook::InputEvent;
+using inputhook::MouseKinematics;
+using inputhook::MouseStatsOptions;
+using inputhook::MouseStatsSnapshot;
+
+namespace {
+
+InputEvent Position(double time, int32_t x, int32_t y) {
+  InputEvent event;
+  event.type = "mousemove";
+  event.time = time;
+  event.x = x;
+  event.y = y;
+  return event;
+}
+
+// Raw X11 motion: deltas plus the position sampled for its batch.
+InputEvent Raw(double time, int32_t deltaX, int32_t deltaY, int32_t x, int32_t y) {
+  InputEvent event = Position(time, x, y);
+  event.deltaX = deltaX;
+  event.deltaY = deltaY;
+  return event;
+}
+
+void Enable(MouseKinematics& kinematics) {
+  MouseStatsOptions options;
+  options.enabled = true;
+  options.intervalMs = 0.0;
+  kinematics.Configure(options);
+}
+
+} // namespace
+
+TEST(KinematicsDifferencesPositions) {
+  MouseKinematics kinematics;
+  Enable(kinematics);
+  // The first position only anchors the pointer.
+  kinematics.Process(Position(1000, 0, 0), nullptr);
+  kinematics.Process(Position(1010, 30, 40), nullptr);
+  kinematics.Process(Position(1020, 60, 80), nullptr);
+
+  MouseStatsSnapshot snapshot = kinematics.Snapshot(1020, false);
+  CHECK_NEAR(snapshot.distance, 100.0, 1e-9);
+  CHECK_EQ(snapshot.episodes, 1u);
+  CHECK_NEAR(snapshot.moveTimeMs, 10.0, 1e-9);
+  CHECK_NEAR(snapshot.meanSpeed, 5000.0, 1e-6);
+  CHECK_NEAR(snapshot.maxSpeed, 5000.0, 1e-6);
+}
+
+// A batch of raw motion repeats one position; the deltas still count.
+TEST(KinematicsPrefersDeltasOverPosition) {
+  MouseKinematics kinematics;
+  Enable(kinematics);
+  kinematics.Process(Raw(1000, 3, 4, 100, 100), nullptr);
+  kinematics.Process(Raw(1010, 3, 4, 100, 100), nullptr);
+  kinematics.Process(Raw(1020, 3, 4, 100, 100), nullptr);
+
+  MouseStatsSnapshot snapshot = kinematics.Snapshot(1020, false);
+  CHECK_NEAR(snapshot.distance, 15.0, 1e-9);
+  CHECK_EQ(snapshot.episodes, 1u);
+  CHECK_NEAR(snapshot.moveTimeMs, 20.0, 1e-9);
+  CHECK_NEAR(snapshot.meanSpeed, 500.0, 1e-6);
+  CHECK_NEAR(snapshot.maxSpeed, 500.0, 1e-6);
+  CHECK_NEAR(snapshot.maxAccel, 0.0, 1e-6);
+  CHECK_EQ(snapshot.speedHistogram[2], 2u);
+
+  // Position-only motion continues from the last reported position.
+  kinematics.Process(Position(1030, 103, 104), nullptr);
+  snapshot = kinematics.Snapshot(1030, true);
+  CHECK_NEAR(snapshot.distance, 20.0, 1e-9);
+  CHECK_EQ(kinematics.Snapshot(1030, false).distance, 0.0);
+}
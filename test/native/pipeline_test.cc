@@ -0,0 +1,96 @@
+#include "../../src/common/pipeline.h"
+
+#include "harness.h"
+
+using inputhook::InputEvent;
+
+namespace {
+
+std::vector<InputEvent> g_collected;
+
+struct CollectStage : inputhook::UnbufferedStage {
+  template <typename Next>
+  void Process(InputEvent&& event, Next&&) {
+    g_collected.push_back(std::move(event));
+  }
+};
+
+using Plain = inputhook::Pipeline<inputhook::TypeFilterStage, CollectStage>;
+using Coalescing =
+    inputhook::Pipeline<inputhook::TypeFilterStage, inputhook::MotionCoalesceStage, CollectStage>;
+using Deduping =
+    inputhook::Pipeline<inputhook::TypeFilterStage, inputhook::DedupeStage, CollectStage>;
+
+InputEvent Motion(int32_t dx, int32_t dy) {
+  InputEvent event;
+  event.type = "mousemove";
+  event.deltaX = dx;
+  event.deltaY = dy;
+  return event;
+}
+
+InputEvent Key(const char* type, uint32_t keycode, double time) {
+  InputEvent event;
+  event.type = type;
+  event.keycode = keycode;
+  event.time = time;
+  return event;
+}
+
+} // namespace
+
+TEST(PipelineClassifiesTypeOnEntry) {
+  g_collected.clear();
+  Plain pipeline;
+  pipeline.Get<inputhook::TypeFilterStage>().SetMask(inputhook::kKeyDownBit);
+  pipeline.OnEvent(Key("keydown", 38, 1));
+  pipeline.OnEvent(Key("keyup", 38, 2));
+  pipeline.OnEvent(Motion(1, 1));
+  CHECK_EQ(g_collected.size(), 1u);
+  CHECK_EQ(g_collected[0].typeBit, static_cast<uint32_t>(inputhook::kKeyDownBit));
+}
+
+TEST(PipelineCoalescesUntilFlush) {
+  g_collected.clear();
+  Coalescing pipeline;
+  pipeline.OnEvent(Motion(1, 2));
+  pipeline.OnEvent(Motion(3, 4));
+  CHECK_EQ(g_collected.size(), 0u);
+  pipeline.OnEvent(Key("keydown", 38, 1));
+  CHECK_EQ(g_collected.size(), 2u);
+  CHECK_EQ(*g_collected[0].deltaX, 4);
+  CHECK_EQ(*g_collected[0].deltaY, 6);
+  pipeline.OnEvent(Motion(1, 1));
+  pipeline.Flush();
+  CHECK_EQ(g_collected.size(), 3u);
+}
+
+TEST(PipelineSwitchFlushesPreviousComposition) {
+  g_collected.clear();
+  inputhook::PipelineSwitch<Plain, Coalescing, Deduping> pipelines;
+  pipelines.Select<Coalescing>();
+  pipelines.OnEvent(Motion(1, 0));
+  pipelines.OnEvent(Motion(1, 0));
+  CHECK_EQ(g_collected.size(), 0u);
+  pipelines.Select<Deduping>();
+  pipelines.OnEvent(Key("keydown", 38, 5));
+  pipelines.OnEvent(Key("keydown", 38, 5));
+  // The held motion comes out before the first event of the new composition,
+  // and the repeated keydown is dropped.
+  CHECK_EQ(g_collected.size(), 2u);
+  CHECK_EQ(*g_collected[0].deltaX, 2);
+  CHECK(g_collected[1].type == "keydown");
+}
+
+TEST(PipelineSwitchFiltersEveryComposition) {
+  g_collected.clear();
+  inputhook::PipelineSwitch<Plain, Coalescing> pipelines;
+  pipelines.ForEach([](auto& pipeline) {
+    pipeline.template Get<inputhook::TypeFilterStage>().SetMask(inputhook::kKeyUpBit);
+  });
+  pipelines.OnEvent(Key("keydown", 38, 1));
+  pipelines.Select<Coalescing>();
+  pipelines.OnEvent(Key("keydown", 38, 2));
+  pipelines.OnEvent(Key("keyup", 38, 3));
+  CHECK_EQ(g_collected.size(), 1u);
+}
@@ -0,0 +1,121 @@
+#include "../../src/common/timeline.h"
+
+#include <cstdio>
+#include <filesystem>
+
+#include "harness.h"
+
+using inputhook::ActivityTimeline;
+using inputhook::InputEvent;
+using inputhook::TimelineOptions;
+using inputhook::TimelineRange;
+
+namespace {
+
+constexpr double kDay = 86400000.0;
+// 2024-01-01T00:00:00Z
+constexpr double kEpoch = 1704067200000.0;
+
+std::string TempPath(const char* name) {
+  auto path = std::filesystem::temp_directory_path() / name;
+  std::remove(path.string().c_str());
+  return path.string();
+}
+
+bool Open(ActivityTimeline& timeline, const std::string& path, uint32_t intervalMs) {
+  TimelineOptions options;
+  options.enabled = true;
+  options.path = path;
+  options.intervalMs = intervalMs;
+  std::string error;
+  return timeline.Configure(options, &error);
+}
+
+InputEvent At(const char* type, double time, uint16_t usage = 0) {
+  InputEvent event;
+  event.type = type;
+  event.time = time;
+  if (usage) {
+    event.hidUsage = usage;
+  }
+  return event;
+}
+
+} // namespace
+
+// A gap far longer than any segment, at the smallest interval, must not stop
+// recording or allocate the space in between.
+TEST(TimelineSkipsLongGaps) {
+  std::string path = TempPath("inputhook-timeline-gap.bin");
+  ActivityTimeline timeline;
+  CHECK(Open(timeline, path, 1000));
+  timeline.Process(At("mousedown", kEpoch));
+  timeline.Process(At("mousedown", kEpoch + 400 * kDay));
+  timeline.Process(At("mousedown", kEpoch + 400 * kDay + 1500));
+  // And the clock going back before the first event.
+  timeline.Process(At("wheel", kEpoch - 30 * kDay));
+  timeline.Close();
+  CHECK(std::filesystem::file_size(path) < 1024u * 1024u);
+
+  CHECK(Open(timeline, path, 0));
+  TimelineRange range;
+  std::string error;
+  CHECK(timeline.Query(kEpoch - 30 * kDay, kEpoch + 401 * kDay, kDay, 0, &range, &error));
+  CHECK_EQ(range.clicks.size(), 431u);
+  CHECK_EQ(range.wheel[0], 1u);
+  CHECK_EQ(range.clicks[30], 1u);
+  CHECK_EQ(range.clicks[430], 2u);
+  CHECK_EQ(range.active[430], 2u);
+  timeline.Close();
+  std::remove(path.c_str());
+}
+
+TEST(TimelineRollsUpDaysWithOffset) {
+  std::string path = TempPath("inputhook-timeline-days.bin");
+  ActivityTimeline timeline;
+  CHECK(Open(timeline, path, 60000));
+  // 23:30 UTC on Jan 1 and 00:30 UTC on Jan 2, with an autorepeat.
+  timeline.Process(At("keydown", kEpoch + 23.5 * 3600000, 4));
+  timeline.Process(At("keydown", kEpoch + 23.5 * 3600000 + 500, 4));
+  timeline.Process(At("keyup", kEpoch + 23.5 * 3600000 + 600, 4));
+  timeline.Process(At("keydown", kEpoch + 24.5 * 3600000, 4));
+
+  TimelineRange range;
+  std::string error;
+  CHECK(timeline.Query(kEpoch, kEpoch + 2 * kDay, kDay, 0, &range, &error));
+  CHECK_EQ(range.startMs, kEpoch);
+  CHECK_EQ(range.keys.size(), 2u);
+  CHECK_EQ(range.keys[0], 1u);
+  CHECK_EQ(range.keys[1], 1u);
+
+  // At UTC+2 both land on local Jan 2, which starts at 22:00 UTC on Jan 1.
+  CHECK(timeline.Query(kEpoch, kEpoch + 2 * kDay, kDay, 2 * 3600000, &range, &error));
+  CHECK_EQ(range.startMs, kEpoch - 2 * 3600000);
+  CHECK_EQ(range.keys[0], 0u);
+  CHECK_EQ(range.keys[1], 2u);
+  CHECK_EQ(range.active[1], 2u);
+
+  CHECK(!timeline.Query(kEpoch, kEpoch + kDay, kDay, 1000, &range, &error));
+  CHECK(!timeline.Query(kEpoch, kEpoch + kDay, 90000, 0, &range, &error));
+  timeline.Close();
+  std::remove(path.c_str());
+}
+
+TEST(TimelineKeepsIntervalAcrossReopen) {
+  std::string path = TempPath("inputhook-timeline-reopen.bin");
+  ActivityTimeline timeline;
+  CHECK(Open(timeline, path, 60000));
+  timeline.Process(At("mousemove", kEpoch + 1000));
+  timeline.Close();
+
+  CHECK(!Open(timeline, path, 1000));
+  CHECK(Open(timeline, path, 0));
+  CHECK_EQ(timeline.Options().intervalMs, 60000u);
+  TimelineRange range;
+  std::string error;
+  CHECK(timeline.Query(kEpoch, kEpoch + 60000, 60000, 0, &range, &error));
+  CHECK_EQ(range.moves.size(), 1u);
+  CHECK_EQ(range.moves[0], 1u);
+  timeline.Close();
+  std::remove(path.c_str());
+}
@@ -0,0 +1,87 @@
+#include "../../src/common/typing.h"
+
+#include "harness.h"
+
+using inputhook::InputEvent;
+using inputhook::TypingStats;
+using inputhook::TypingStatsOptions;
+using inputhook::TypingStatsSnapshot;
+
+namespace {
+
+InputEvent Key(const char* type, double time, uint32_t usage) {
+  InputEvent event;
+  event.type = type;
+  event.time = time;
+  event.hidUsage = usage;
+  return event;
+}
+
+void Stroke(TypingStats& stats, double time, uint32_t usage) {
+  stats.Process(Key("keydown", time, usage));
+  stats.Process(Key("keyup", time + 10, usage));
+}
+
+void Enable(TypingStats& stats, double windowMs) {
+  TypingStatsOptions options;
+  options.enabled = true;
+  options.windowMs = windowMs;
+  stats.Configure(options);
+}
+
+} // namespace
+
+TEST(TypingSplitsBurstsAtPauses) {
+  TypingStats stats;
+  Enable(stats, 60000);
+  Stroke(stats, 1000, 0x04);
+  Stroke(stats, 1100, 0x05);
+  Stroke(stats, 1300, 0x06);
+  Stroke(stats, 5000, 0x07);
+  Stroke(stats, 5050, 0x2A);
+
+  TypingStatsSnapshot snapshot = stats.Snapshot(5100);
+  CHECK_EQ(snapshot.keys, 5u);
+  CHECK_EQ(snapshot.backspaces, 1u);
+  CHECK_NEAR(snapshot.keysPerMinute, 5.0, 1e-9);
+  CHECK_NEAR(snapshot.meanIntervalMs, 350.0 / 3, 1e-9);
+  CHECK_EQ(snapshot.histogram[2], 1u);
+  CHECK_EQ(snapshot.histogram[4], 1u);
+  CHECK_EQ(snapshot.histogram[8], 1u);
+  CHECK_EQ(snapshot.bursts, 1u);
+  CHECK_NEAR(snapshot.meanBurstKeys, 3.0, 1e-9);
+  CHECK_NEAR(snapshot.meanBurstMs, 300.0, 1e-9);
+  CHECK_EQ(snapshot.currentBurstKeys, 2u);
+  CHECK_EQ(snapshot.pauses, 1u);
+  CHECK_NEAR(snapshot.pauseMs, 3700.0, 1e-9);
+
+  // Once the pause threshold passes, the open burst closes.
+  snapshot = stats.Snapshot(8000);
+  CHECK_EQ(snapshot.bursts, 2u);
+  CHECK_NEAR(snapshot.meanBurstKeys, 2.5, 1e-9);
+  CHECK_NEAR(snapshot.meanBurstMs, 175.0, 1e-9);
+  CHECK_EQ(snapshot.currentBurstKeys, 0u);
+}
+
+TEST(TypingSkipsAutorepeatAndModifiers) {
+  TypingStats stats;
+  Enable(stats, 1000);
+  stats.Process(Key("keydown", 1000, 0x04));
+  stats.Process(Key("keydown", 1030, 0x04));
+  stats.Process(Key("keydown", 1060, 0x04));
+  stats.Process(Key("keydown", 1070, 0xE1));
+  stats.Process(Key("keyup", 1080, 0x04));
+  stats.Process(Key("keydown", 1100, 0x04));
+  CHECK_EQ(stats.Snapshot(1100).keys, 2u);
+
+  // A key held across a missed release counts again after ResetKeys().
+  stats.Process(Key("keydown", 1200, 0x05));
+  stats.ResetKeys();
+  stats.Process(Key("keydown", 1300, 0x05));
+  CHECK_EQ(stats.Snapshot(1300).keys, 4u);
+
+  // Strokes older than the window fall out.
+  TypingStatsSnapshot snapshot = stats.Snapshot(2250);
+  CHECK_EQ(snapshot.keys, 1u);
+  CHECK_EQ(snapshot.histogram[4], 1u);
+}
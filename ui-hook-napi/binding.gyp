@@ -5,7 +5,10 @@
       'dependencies': ['libuiohook'],
       'sources': [
         'src/lib/addon.c',
+        'src/lib/event_queue.c',
+        'src/lib/keymap.c',
         'src/lib/napi_helpers.c',
+        'src/lib/post_sequence.c',
         'src/lib/uiohook_worker.c',
       ],
       'include_dirs': [
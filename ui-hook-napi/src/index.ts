@@ -6,6 +6,10 @@ interface AddonExports {
   start (cb: (e: any) => void): void
   stop (): void
   keyTap (key: number, type: KeyToggle): void
+  postSequence (records: Int32Array): Promise<void>
+  postSequenceSync (records: Int32Array): void
+  getStats (): UiohookStats
+  setEventMask (mask: number): void
 }
 
 enum KeyToggle {
@@ -14,6 +18,58 @@ enum KeyToggle {
   Up = 2
 }
 
+export enum SequenceAction {
+  KeyDown = 0,
+  KeyUp = 1,
+  KeyTap = 2,
+  MouseMove = 3,
+  MouseDown = 4,
+  MouseUp = 5,
+  MouseClick = 6,
+  Wheel = 7
+}
+
+export interface SequenceStep {
+  action: SequenceAction
+  /** keycode for key actions, button for mouse button actions, rotation for wheel */
+  code?: number
+  /** omit to leave the pointer where it is (required for MouseMove) */
+  x?: number
+  y?: number
+  /** milliseconds to wait after this step */
+  delay?: number
+}
+
+const SEQUENCE_STRIDE = 5
+/** x/y placeholder for "current pointer position", matches POST_SEQUENCE_NO_COORD */
+const SEQUENCE_NO_COORD = -2147483648
+
+export function packSequence (steps: SequenceStep[]): Int32Array {
+  const records = new Int32Array(steps.length * SEQUENCE_STRIDE)
+  steps.forEach((step, i) => {
+    const offset = i * SEQUENCE_STRIDE
+    records[offset] = step.action
+    records[offset + 1] = step.code ?? 0
+    records[offset + 2] = step.x ?? SEQUENCE_NO_COORD
+    records[offset + 3] = step.y ?? SEQUENCE_NO_COORD
+    records[offset + 4] = step.delay ?? 0
+  })
+  return records
+}
+
+export interface UiohookStats {
+  /** preallocated slots between the hook thread and JS */
+  capacity: number
+  /** events currently waiting for JS */
+  depth: number
+  highWater: number
+  queued: number
+  /** motion events replaced by a newer one while the queue was full */
+  coalesced: number
+  /** non-motion events lost because the queue was full */
+  dropped: number
+}
+
 export enum EventType {
   EVENT_KEY_PRESSED = 4,
   EVENT_KEY_RELEASED = 5,
@@ -32,6 +88,8 @@ export interface UiohookKeyboardEvent {
   metaKey: boolean
   shiftKey: boolean
   keycode: number
+  /** USB HID usage ID (Keyboard/Keypad page) of the physical key, 0 if unknown */
+  hidUsage: number
 }
 
 export interface UiohookMouseEvent {
@@ -211,9 +269,62 @@ declare interface UiohookNapi {
   on(event: 'wheel', listener: (e: UiohookWheelEvent) => void): this
 }
 
+// libuiohook reports drags separately; they are delivered as mousemove.
+const EVENT_MOUSE_DRAGGED = 10
+
+const LISTENED_TYPES: Record<string, number[]> = {
+  keydown: [EventType.EVENT_KEY_PRESSED],
+  keyup: [EventType.EVENT_KEY_RELEASED],
+  mousedown: [EventType.EVENT_MOUSE_PRESSED],
+  mouseup: [EventType.EVENT_MOUSE_RELEASED],
+  mousemove: [EventType.EVENT_MOUSE_MOVED, EVENT_MOUSE_DRAGGED],
+  click: [EventType.EVENT_MOUSE_CLICKED],
+  wheel: [EventType.EVENT_MOUSE_WHEEL]
+}
+
+const ALL_EVENTS_MASK = 0xFFFFFFFF
+
 class UiohookNapi extends EventEmitter {
+  private eventMask = ALL_EVENTS_MASK
+  private hasInputListeners = false
+
+  constructor () {
+    super()
+    // The native side drops event types nobody listens to on the hook
+    // thread, before they are queued or converted to JS objects.
+    this.on('newListener', (event: string | symbol) => this.updateEventMask(event))
+    this.on('removeListener', () => this.updateEventMask())
+    this.updateEventMask()
+  }
+
+  private updateEventMask (adding?: string | symbol) {
+    // 'newListener' fires before the listener is added.
+    const listened = (name: string) => name === adding || this.listenerCount(name) > 0
+
+    this.hasInputListeners = listened('input')
+    let mask = 0
+    if (this.hasInputListeners) {
+      mask = ALL_EVENTS_MASK
+    } else {
+      for (const name in LISTENED_TYPES) {
+        if (listened(name)) {
+          for (const type of LISTENED_TYPES[name]) {
+            mask |= 1 << type
+          }
+        }
+      }
+    }
+
+    if (mask !== this.eventMask) {
+      this.eventMask = mask
+      lib.setEventMask(mask >>> 0)
+    }
+  }
+
   private handler (e: UiohookKeyboardEvent | UiohookMouseEvent | UiohookWheelEvent) {
-    this.emit('input', e)
+    if (this.hasInputListeners) {
+      this.emit('input', e)
+    }
     switch (e.type) {
       case EventType.EVENT_KEY_PRESSED:
         this.emit('keydown', e)
@@ -247,24 +358,37 @@ class UiohookNapi extends EventEmitter {
     lib.stop()
   }
 
-  keyTap (key: number, modifiers: number[] = []) {
-    if (!modifiers.length) {
-      lib.keyTap(key, KeyToggle.Tap)
-      return
-    }
+  /** Event queue counters since the last `start()`. */
+  getStats (): UiohookStats {
+    return lib.getStats()
+  }
 
+  // Key posts go through the sequence queue so they never overtake a
+  // sequence that is still running.
+  keyTap (key: number, modifiers: number[] = []) {
+    const steps: SequenceStep[] = []
     for (const modKey of modifiers) {
-      lib.keyTap(modKey, KeyToggle.Down)
+      steps.push({ action: SequenceAction.KeyDown, code: modKey })
     }
-    lib.keyTap(key, KeyToggle.Tap)
+    steps.push({ action: SequenceAction.KeyTap, code: key })
     let i = modifiers.length
     while (i--) {
-      lib.keyTap(modifiers[i], KeyToggle.Up)
+      steps.push({ action: SequenceAction.KeyUp, code: modifiers[i] })
     }
+    lib.postSequenceSync(packSequence(steps))
+  }
+
+  /**
+   * Posts a batch of key and mouse actions from a native worker thread,
+   * honoring per-step delays. Accepts steps or records built by `packSequence`.
+   */
+  postSequence (steps: SequenceStep[] | Int32Array): Promise<void> {
+    return lib.postSequence(steps instanceof Int32Array ? steps : packSequence(steps))
   }
 
   keyToggle (key: number, toggle: 'down' | 'up') {
-    lib.keyTap(key, (toggle === 'down' ? KeyToggle.Down : KeyToggle.Up))
+    const action = toggle === 'down' ? SequenceAction.KeyDown : SequenceAction.KeyUp
+    lib.postSequenceSync(packSequence([{ action, code: key }]))
   }
 }
 
@@ -1,29 +1,51 @@
 #include <stdlib.h>
 #include <string.h>
 #include <node_api.h>
+#include <uv.h>
 #include <uiohook.h>
+#include "event_queue.h"
+#include "keymap.h"
 #include "napi_helpers.h"
+#include "post_sequence.h"
 #include "uiohook_worker.h"
 
 static napi_threadsafe_function threadsafe_fn = NULL;
 static bool is_worker_running = false;
 
+// Events handed to JS per batch, and per wakeup before yielding to the
+// event loop.
+#define DRAIN_BATCH 64
+#define DRAIN_LIMIT EVENT_QUEUE_CAPACITY
+
+// Events taken from the queue but not yet handed to JS. Only touched on the
+// JS thread.
+static uiohook_event pending_batch[DRAIN_BATCH];
+static size_t pending_next = 0;
+static size_t pending_count = 0;
+
+static void request_wakeup() {
+  napi_threadsafe_function tsfn = threadsafe_fn;
+  napi_status status = tsfn != NULL
+    ? napi_call_threadsafe_function(tsfn, NULL, napi_tsfn_nonblocking)
+    : napi_closing;
+  if (status == napi_closing) {
+    threadsafe_fn = NULL;
+  }
+  if (status != napi_ok) {
+    // Never fatal: the events stay queued (or are counted as dropped) and the
+    // next push asks again.
+    event_queue_cancel_wakeup();
+  }
+}
+
+// Runs on the libuiohook hook thread. Events go into the preallocated queue;
+// the threadsafe function is only used to wake JS when it is idle.
 void dispatch_proc(uiohook_event* const event) {
   if (threadsafe_fn == NULL) return;
 
-  uiohook_event* copied_event = malloc(sizeof(uiohook_event));
-  memcpy(copied_event, event, sizeof(uiohook_event));
-  if (copied_event->type == EVENT_MOUSE_DRAGGED) {
-    copied_event->type = EVENT_MOUSE_MOVED;
-  }
-
-  napi_status status = napi_call_threadsafe_function(threadsafe_fn, copied_event, napi_tsfn_nonblocking);
-  if (status == napi_closing) {
-    threadsafe_fn = NULL;
-    free(copied_event);
-    return;
+  if (event_queue_push(event)) {
+    request_wakeup();
   }
-  NAPI_FATAL_IF_FAILED(status, "dispatch_proc", "napi_call_threadsafe_function");
 }
 
 napi_value uiohook_to_js_event(napi_env env, uiohook_event* event) {
@@ -62,6 +84,10 @@ napi_value uiohook_to_js_event(napi_env env, uiohook_event* event) {
     status = napi_create_uint32(env, event->data.keyboard.keycode, &e_keycode);
     NAPI_FATAL_IF_FAILED(status, "uiohook_to_js_event", "napi_create_uint32");
 
+    napi_value e_hidUsage;
+    status = napi_create_uint32(env, keycode_to_hid_usage(event->data.keyboard.keycode), &e_hidUsage);
+    NAPI_FATAL_IF_FAILED(status, "uiohook_to_js_event", "napi_create_uint32");
+
     napi_property_descriptor descriptors[] = {
       { "type",     NULL, NULL, NULL, NULL, e_type,     napi_enumerable, NULL },
       { "time",     NULL, NULL, NULL, NULL, e_time,     napi_enumerable, NULL },
@@ -70,6 +96,7 @@ napi_value uiohook_to_js_event(napi_env env, uiohook_event* event) {
       { "metaKey",  NULL, NULL, NULL, NULL, e_metaKey,  napi_enumerable, NULL },
       { "shiftKey", NULL, NULL, NULL, NULL, e_shiftKey, napi_enumerable, NULL },
       { "keycode",  NULL, NULL, NULL, NULL, e_keycode,  napi_enumerable, NULL },
+      { "hidUsage", NULL, NULL, NULL, NULL, e_hidUsage, napi_enumerable, NULL },
     };
     status = napi_define_properties(env, event_obj, sizeof(descriptors) / sizeof(descriptors[0]), descriptors);
     NAPI_FATAL_IF_FAILED(status, "uiohook_to_js_event", "napi_define_properties");
@@ -155,26 +182,45 @@ napi_value uiohook_to_js_event(napi_env env, uiohook_event* event) {
   return NULL; // never
 }
 
-void tsfn_to_js_proxy(napi_env env, napi_value js_callback, void* context, void* _event) {
-  uiohook_event* event = (uiohook_event*)_event;
-
+void tsfn_to_js_proxy(napi_env env, napi_value js_callback, void* context, void* data) {
   if (env == NULL || js_callback == NULL || is_worker_running == false) {
-    free(event);
     return;
   }
 
   napi_status status;
 
-  napi_value event_obj = uiohook_to_js_event(env, event);
-
   napi_value global;
   status = napi_get_global(env, &global);
   NAPI_FATAL_IF_FAILED(status, "tsfn_to_js_proxy", "napi_get_global");
 
-  status = napi_call_function(env, global, js_callback, 1, &event_obj, NULL);
-  NAPI_FATAL_IF_FAILED(status, "tsfn_to_js_proxy", "napi_call_function");
-
-  free(event);
+  size_t delivered = 0;
+  for (;;) {
+    if (pending_next == pending_count) {
+      pending_next = 0;
+      pending_count = event_queue_pop(pending_batch, DRAIN_BATCH);
+      if (pending_count == 0) {
+        return;
+      }
+    }
+    if (delivered >= DRAIN_LIMIT) {
+      request_wakeup();
+      return;
+    }
+
+    uiohook_event* event = &pending_batch[pending_next++];
+    if (event->type == EVENT_MOUSE_DRAGGED) {
+      event->type = EVENT_MOUSE_MOVED;
+    }
+    napi_value event_obj = uiohook_to_js_event(env, event);
+    status = napi_call_function(env, global, js_callback, 1, &event_obj, NULL);
+    delivered++;
+    if (status != napi_ok) {
+      // A listener threw. It surfaces once we return; the rest of the batch
+      // stays in pending_batch and goes first on the next turn.
+      request_wakeup();
+      return;
+    }
+  }
 }
 
 napi_value AddonStart(napi_env env, napi_callback_info info) {
@@ -190,6 +236,10 @@ napi_value AddonStart(napi_env env, napi_callback_info info) {
 
   napi_value cb = info_argv[0];
 
+  event_queue_reset();
+  pending_next = 0;
+  pending_count = 0;
+
   napi_value async_resource_name;
   status = napi_create_string_utf8(env, "UIOHOOK_NAPI", NAPI_AUTO_LENGTH, &async_resource_name);
   NAPI_THROW_IF_FAILED(env, status, NULL);
@@ -264,12 +314,54 @@ napi_value AddonStop(napi_env env, napi_callback_info info) {
   }
 }
 
-void AddonCleanUp (void* arg) {
-  if (is_worker_running) {
-    uiohook_worker_stop();
+napi_value AddonSetEventMask(napi_env env, napi_callback_info info) {
+  napi_status status;
+
+  size_t info_argc = 1;
+  napi_value info_argv[1];
+  status = napi_get_cb_info(env, info, &info_argc, info_argv, NULL, NULL);
+  NAPI_THROW_IF_FAILED(env, status, NULL);
+
+  uint32_t mask;
+  status = napi_get_value_uint32(env, info_argv[0], &mask);
+  NAPI_THROW_IF_FAILED(env, status, NULL);
+
+  if (uiohook_worker_set_event_mask(mask) != UIOHOOK_SUCCESS && is_worker_running) {
+    is_worker_running = false;
+    napi_release_threadsafe_function(threadsafe_fn, napi_tsfn_release);
+    threadsafe_fn = NULL;
+    NAPI_THROW(env, "UIOHOOK_FAILURE", "Failed to restart the hook to record pointer motion.", NULL);
+  }
+  return NULL;
+}
+
+static napi_status set_counter(napi_env env, napi_value obj, const char* name, double value) {
+  napi_value js_value;
+  napi_status status = napi_create_double(env, value, &js_value);
+  if (status != napi_ok) return status;
+  return napi_set_named_property(env, obj, name, js_value);
+}
+
+napi_value AddonGetStats(napi_env env, napi_callback_info info) {
+  event_queue_stats stats;
+  event_queue_get_stats(&stats);
+
+  napi_value result;
+  napi_status status = napi_create_object(env, &result);
+  NAPI_THROW_IF_FAILED(env, status, NULL);
+
+  if (set_counter(env, result, "capacity", EVENT_QUEUE_CAPACITY) != napi_ok ||
+      set_counter(env, result, "depth", stats.depth) != napi_ok ||
+      set_counter(env, result, "highWater", stats.high_water) != napi_ok ||
+      set_counter(env, result, "queued", (double)stats.queued) != napi_ok ||
+      set_counter(env, result, "coalesced", (double)stats.coalesced) != napi_ok ||
+      set_counter(env, result, "dropped", (double)stats.dropped) != napi_ok) {
+    NAPI_THROW(env, "UIOHOOK_FAILURE", "Failed to build stats object.", NULL);
   }
+  return result;
 }
 
+
 typedef enum {
   key_tap,
   key_down,
@@ -311,6 +403,282 @@ napi_value AddonKeyTap (napi_env env, napi_callback_info info) {
   return NULL;
 }
 
+typedef struct post_sequence_job {
+  // NULL for sequences queued by postSequenceSync, which nobody awaits.
+  napi_deferred deferred;
+  int32_t* records;
+  size_t count;
+  struct post_sequence_job* next;
+} post_sequence_job;
+
+// Sequences run one at a time, in the order they were posted, on a thread of
+// their own: their delays would otherwise hold a libuv threadpool slot for
+// the whole sequence and starve fs, dns and crypto work. Finished jobs go
+// back to the JS thread through sequence_done_fn to settle their promises.
+static uv_mutex_t sequence_mutex;
+static uv_cond_t sequence_cond;
+static uv_thread_t sequence_thread;
+static napi_threadsafe_function sequence_done_fn = NULL;
+// Guarded by sequence_mutex.
+static bool sequence_stopping = false;
+static post_sequence_job* sequence_head = NULL;
+static post_sequence_job* sequence_tail = NULL;
+static post_sequence_job* sequence_done_head = NULL;
+static post_sequence_job* sequence_done_tail = NULL;
+// Posted but not yet settled; only touched on the JS thread.
+static size_t sequence_pending = 0;
+
+static napi_status read_sequence_arg(napi_env env, napi_callback_info info, int32_t** records, size_t* count) {
+  napi_status status;
+
+  size_t info_argc = 1;
+  napi_value info_argv[1];
+  status = napi_get_cb_info(env, info, &info_argc, info_argv, NULL, NULL);
+  if (status != napi_ok) return status;
+
+  bool is_typedarray = false;
+  if (info_argc < 1 || napi_is_typedarray(env, info_argv[0], &is_typedarray) != napi_ok || !is_typedarray) {
+    return napi_invalid_arg;
+  }
+
+  napi_typedarray_type type;
+  size_t length;
+  void* data;
+  status = napi_get_typedarray_info(env, info_argv[0], &type, &length, &data, NULL, NULL);
+  if (status != napi_ok) return status;
+  if (type != napi_int32_array || length % POST_SEQUENCE_STRIDE != 0) {
+    return napi_invalid_arg;
+  }
+
+  *records = (int32_t*)data;
+  *count = length / POST_SEQUENCE_STRIDE;
+  if (post_sequence_validate(*records, *count) >= 0) {
+    return napi_invalid_arg;
+  }
+  return napi_ok;
+}
+
+static void post_sequence_free(post_sequence_job* job) {
+  while (job != NULL) {
+    post_sequence_job* next = job->next;
+    free(job->records);
+    free(job);
+    job = next;
+  }
+}
+
+static bool post_sequence_sleep(unsigned int delay_ms) {
+  uv_sleep(delay_ms);
+  return true;
+}
+
+// Sleeps on the sequence thread, cut short when the addon is unloaded.
+static bool post_sequence_wait(unsigned int delay_ms) {
+  uint64_t deadline = uv_hrtime() + (uint64_t)delay_ms * 1000000;
+  uv_mutex_lock(&sequence_mutex);
+  while (!sequence_stopping) {
+    uint64_t now = uv_hrtime();
+    if (now >= deadline) {
+      break;
+    }
+    uv_cond_timedwait(&sequence_cond, &sequence_mutex, deadline - now);
+  }
+  bool keep_going = !sequence_stopping;
+  uv_mutex_unlock(&sequence_mutex);
+  return keep_going;
+}
+
+static void post_sequence_thread(void* arg) {
+  uv_mutex_lock(&sequence_mutex);
+  while (true) {
+    while (sequence_head == NULL && !sequence_stopping) {
+      uv_cond_wait(&sequence_cond, &sequence_mutex);
+    }
+    if (sequence_stopping) {
+      break;
+    }
+    post_sequence_job* job = sequence_head;
+    sequence_head = job->next;
+    if (sequence_head == NULL) {
+      sequence_tail = NULL;
+    }
+    job->next = NULL;
+    uv_mutex_unlock(&sequence_mutex);
+
+    post_sequence_run(job->records, job->count, post_sequence_wait);
+
+    uv_mutex_lock(&sequence_mutex);
+    if (sequence_done_tail != NULL) {
+      sequence_done_tail->next = job;
+    } else {
+      sequence_done_head = job;
+    }
+    sequence_done_tail = job;
+    napi_call_threadsafe_function(sequence_done_fn, NULL, napi_tsfn_nonblocking);
+  }
+  uv_mutex_unlock(&sequence_mutex);
+}
+
+static void post_sequence_settle(napi_env env, napi_value js_cb, void* context, void* data) {
+  if (env == NULL) {
+    // Unloading; post_sequence_stop() frees the jobs.
+    return;
+  }
+  uv_mutex_lock(&sequence_mutex);
+  post_sequence_job* job = sequence_done_head;
+  sequence_done_head = NULL;
+  sequence_done_tail = NULL;
+  uv_mutex_unlock(&sequence_mutex);
+
+  for (post_sequence_job* next; job != NULL; job = next) {
+    next = job->next;
+    job->next = NULL;
+    if (job->deferred != NULL) {
+      napi_value undefined;
+      NAPI_FATAL_IF_FAILED(napi_get_undefined(env, &undefined), "post_sequence_settle", "napi_get_undefined");
+      NAPI_FATAL_IF_FAILED(napi_resolve_deferred(env, job->deferred, undefined), "post_sequence_settle", "napi_resolve_deferred");
+    }
+    post_sequence_free(job);
+    // An idle queue must not keep the process alive.
+    if (--sequence_pending == 0) {
+      napi_unref_threadsafe_function(env, sequence_done_fn);
+    }
+  }
+}
+
+// Starts the sequence thread on first use.
+static napi_status post_sequence_start(napi_env env) {
+  if (sequence_done_fn != NULL) {
+    return napi_ok;
+  }
+  napi_value async_resource_name;
+  napi_status status = napi_create_string_utf8(env, "UIOHOOK_NAPI_POST_SEQUENCE", NAPI_AUTO_LENGTH, &async_resource_name);
+  if (status == napi_ok) {
+    status = napi_create_threadsafe_function(env, NULL, NULL, async_resource_name, 0, 1, NULL, NULL, NULL, post_sequence_settle, &sequence_done_fn);
+  }
+  if (status != napi_ok) {
+    return status;
+  }
+  napi_unref_threadsafe_function(env, sequence_done_fn);
+
+  uv_mutex_init(&sequence_mutex);
+  uv_cond_init(&sequence_cond);
+  sequence_stopping = false;
+  if (uv_thread_create(&sequence_thread, post_sequence_thread, NULL) != 0) {
+    uv_cond_destroy(&sequence_cond);
+    uv_mutex_destroy(&sequence_mutex);
+    napi_release_threadsafe_function(sequence_done_fn, napi_tsfn_abort);
+    sequence_done_fn = NULL;
+    return napi_generic_failure;
+  }
+  return napi_ok;
+}
+
+// Abandons queued sequences and joins the thread; a running one stops at its
+// next delay.
+static void post_sequence_stop() {
+  if (sequence_done_fn == NULL) {
+    return;
+  }
+  uv_mutex_lock(&sequence_mutex);
+  sequence_stopping = true;
+  uv_cond_signal(&sequence_cond);
+  uv_mutex_unlock(&sequence_mutex);
+  uv_thread_join(&sequence_thread);
+
+  post_sequence_free(sequence_head);
+  post_sequence_free(sequence_done_head);
+  sequence_head = sequence_tail = NULL;
+  sequence_done_head = sequence_done_tail = NULL;
+  sequence_pending = 0;
+  uv_cond_destroy(&sequence_cond);
+  uv_mutex_destroy(&sequence_mutex);
+  napi_release_threadsafe_function(sequence_done_fn, napi_tsfn_abort);
+  sequence_done_fn = NULL;
+}
+
+// Copies the records, since the JS buffer may be reused as soon as we return,
+// and hands the job to the sequence thread. Throws and frees the job on
+// failure.
+static napi_status post_sequence_enqueue(napi_env env, const int32_t* records, size_t count, napi_value* promise) {
+  napi_status status;
+
+  post_sequence_job* job = calloc(1, sizeof(post_sequence_job));
+  size_t byte_length = count * POST_SEQUENCE_STRIDE * sizeof(int32_t);
+  if (job != NULL) {
+    job->records = malloc(byte_length > 0 ? byte_length : 1);
+  }
+  if (job == NULL || job->records == NULL) {
+    free(job);
+    NAPI_THROW(env, "UIOHOOK_ERROR_OUT_OF_MEMORY", "Failed to allocate memory.", napi_generic_failure);
+  }
+  memcpy(job->records, records, byte_length);
+  job->count = count;
+
+  status = post_sequence_start(env);
+  if (status == napi_ok && promise != NULL) {
+    status = napi_create_promise(env, &job->deferred, promise);
+  }
+  if (status != napi_ok) {
+    napi_value error = error_create(env);
+    post_sequence_free(job);
+    NAPI_FATAL_IF_FAILED(napi_throw(env, error), "post_sequence_enqueue", "napi_throw");
+    return status;
+  }
+
+  if (sequence_pending++ == 0) {
+    napi_ref_threadsafe_function(env, sequence_done_fn);
+  }
+  uv_mutex_lock(&sequence_mutex);
+  if (sequence_tail != NULL) {
+    sequence_tail->next = job;
+  } else {
+    sequence_head = job;
+  }
+  sequence_tail = job;
+  uv_cond_signal(&sequence_cond);
+  uv_mutex_unlock(&sequence_mutex);
+  return napi_ok;
+}
+
+napi_value AddonPostSequence (napi_env env, napi_callback_info info) {
+  int32_t* records;
+  size_t count;
+  if (read_sequence_arg(env, info, &records, &count) != napi_ok) {
+    NAPI_THROW(env, "ERR_INVALID_ARG_VALUE", "Expected an Int32Array of packed sequence records.", NULL);
+  }
+
+  napi_value promise;
+  if (post_sequence_enqueue(env, records, count, &promise) != napi_ok) {
+    return NULL;
+  }
+  return promise;
+}
+
+// Posts right away when no sequence is running; otherwise queues behind the
+// running ones instead of waiting out their delays on the JS thread.
+napi_value AddonPostSequenceSync (napi_env env, napi_callback_info info) {
+  int32_t* records;
+  size_t count;
+  if (read_sequence_arg(env, info, &records, &count) != napi_ok) {
+    NAPI_THROW(env, "ERR_INVALID_ARG_VALUE", "Expected an Int32Array of packed sequence records.", NULL);
+  }
+
+  if (sequence_pending == 0) {
+    post_sequence_run(records, count, post_sequence_sleep);
+  } else {
+    post_sequence_enqueue(env, records, count, NULL);
+  }
+  return NULL;
+}
+
+void AddonCleanUp (void* arg) {
+  if (is_worker_running) {
+    uiohook_worker_stop();
+  }
+  post_sequence_stop();
+}
+
 NAPI_MODULE_INIT() {
   napi_status status;
   napi_value export_fn;
@@ -330,6 +698,26 @@ NAPI_MODULE_INIT() {
   status = napi_set_named_property(env, exports, "keyTap", export_fn);
   NAPI_FATAL_IF_FAILED(status, "NAPI_MODULE_INIT", "napi_set_named_property");
 
+  status = napi_create_function(env, NULL, 0, AddonPostSequence, NULL, &export_fn);
+  NAPI_FATAL_IF_FAILED(status, "NAPI_MODULE_INIT", "napi_create_function");
+  status = napi_set_named_property(env, exports, "postSequence", export_fn);
+  NAPI_FATAL_IF_FAILED(status, "NAPI_MODULE_INIT", "napi_set_named_property");
+
+  status = napi_create_function(env, NULL, 0, AddonPostSequenceSync, NULL, &export_fn);
+  NAPI_FATAL_IF_FAILED(status, "NAPI_MODULE_INIT", "napi_create_function");
+  status = napi_set_named_property(env, exports, "postSequenceSync", export_fn);
+  NAPI_FATAL_IF_FAILED(status, "NAPI_MODULE_INIT", "napi_set_named_property");
+
+  status = napi_create_function(env, NULL, 0, AddonSetEventMask, NULL, &export_fn);
+  NAPI_FATAL_IF_FAILED(status, "NAPI_MODULE_INIT", "napi_create_function");
+  status = napi_set_named_property(env, exports, "setEventMask", export_fn);
+  NAPI_FATAL_IF_FAILED(status, "NAPI_MODULE_INIT", "napi_set_named_property");
+
+  status = napi_create_function(env, NULL, 0, AddonGetStats, NULL, &export_fn);
+  NAPI_FATAL_IF_FAILED(status, "NAPI_MODULE_INIT", "napi_create_function");
+  status = napi_set_named_property(env, exports, "getStats", export_fn);
+  NAPI_FATAL_IF_FAILED(status, "NAPI_MODULE_INIT", "napi_set_named_property");
+
   status = napi_add_env_cleanup_hook(env, AddonCleanUp, NULL);
   NAPI_FATAL_IF_FAILED(status, "NAPI_MODULE_INIT", "napi_add_env_cleanup_hook");
 
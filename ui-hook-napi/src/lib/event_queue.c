@@ -0,0 +1,172 @@
+#include <string.h>
+#include "event_queue.h"
+
+// The hook thread runs at real-time priority and the OS disables the hook
+// when it stalls, so it must never wait on the JS thread: a lock the JS
+// thread holds while copying out a batch is a priority inversion. The queue
+// is a single-producer/single-consumer ring instead; each side only writes
+// its own index, and pushing is a bounded copy with no allocation and no
+// waiting.
+#ifdef _MSC_VER
+#include <intrin.h>
+typedef volatile __int64 queue_word;
+#define QUEUE_LOAD(p) _InterlockedCompareExchange64((p), 0, 0)
+#define QUEUE_STORE(p, v) ((void)_InterlockedExchange64((p), (v)))
+#define QUEUE_EXCHANGE(p, v) _InterlockedExchange64((p), (v))
+#define QUEUE_ADD(p, v) ((void)_InterlockedExchangeAdd64((p), (v)))
+#else
+typedef int64_t queue_word;
+#define QUEUE_LOAD(p) __atomic_load_n((p), __ATOMIC_SEQ_CST)
+#define QUEUE_STORE(p, v) __atomic_store_n((p), (v), __ATOMIC_SEQ_CST)
+#define QUEUE_EXCHANGE(p, v) __atomic_exchange_n((p), (v), __ATOMIC_SEQ_CST)
+#define QUEUE_ADD(p, v) ((void)__atomic_fetch_add((p), (v), __ATOMIC_SEQ_CST))
+#endif
+
+#if (EVENT_QUEUE_CAPACITY & (EVENT_QUEUE_CAPACITY - 1)) != 0
+#error "EVENT_QUEUE_CAPACITY must be a power of two"
+#endif
+#define QUEUE_MASK (EVENT_QUEUE_CAPACITY - 1)
+
+static uiohook_event slots[EVENT_QUEUE_CAPACITY];
+// Free-running counters: the consumer advances head, the producer tail.
+static queue_word head = 0;
+static queue_word tail = 0;
+static queue_word wakeup_pending = 0;
+
+// Motion that arrives while the ring is full goes to a triple buffer, so the
+// latest position survives without the producer touching a slot the
+// consumer may be reading. The producer writes motion_back, the consumer
+// reads motion_front, and they swap through the shared middle index;
+// MOTION_FRESH marks a middle buffer the consumer has not taken yet. Once the
+// ring has room again the producer takes a waiting one back and enqueues it
+// ahead of the next event, so nothing newer overtakes it.
+#define MOTION_FRESH 4
+static uiohook_event motion_buffers[3];
+static int motion_back = 0;
+static int motion_front = 2;
+static queue_word motion_middle = 1;
+
+static queue_word queued = 0;
+static queue_word coalesced = 0;
+static queue_word dropped = 0;
+static queue_word high_water = 0;
+
+static bool is_motion(event_type type) {
+  return type == EVENT_MOUSE_MOVED || type == EVENT_MOUSE_DRAGGED;
+}
+
+void event_queue_reset() {
+  QUEUE_STORE(&head, 0);
+  QUEUE_STORE(&tail, 0);
+  QUEUE_STORE(&wakeup_pending, 0);
+  motion_back = 0;
+  motion_front = 2;
+  QUEUE_STORE(&motion_middle, 1);
+  QUEUE_STORE(&queued, 0);
+  QUEUE_STORE(&coalesced, 0);
+  QUEUE_STORE(&dropped, 0);
+  QUEUE_STORE(&high_water, 0);
+}
+
+static bool request_wakeup() {
+  return QUEUE_EXCHANGE(&wakeup_pending, 1) == 0;
+}
+
+static void note_depth(queue_word depth) {
+  if (depth > QUEUE_LOAD(&high_water)) {
+    QUEUE_STORE(&high_water, depth);
+  }
+}
+
+bool event_queue_push(const uiohook_event* event) {
+  queue_word position = QUEUE_LOAD(&tail);
+  queue_word depth = position - QUEUE_LOAD(&head);
+
+  if (depth < EVENT_QUEUE_CAPACITY && (QUEUE_LOAD(&motion_middle) & MOTION_FRESH)) {
+    // The consumer may take it at the same time; whoever swaps first owns it.
+    queue_word previous = QUEUE_EXCHANGE(&motion_middle, motion_back);
+    motion_back = (int)(previous & ~MOTION_FRESH);
+    if (previous & MOTION_FRESH) {
+      // Already counted as queued when it overflowed.
+      memcpy(&slots[position & QUEUE_MASK], &motion_buffers[motion_back], sizeof(uiohook_event));
+      QUEUE_STORE(&tail, ++position);
+      note_depth(++depth);
+    }
+  }
+
+  if (depth == EVENT_QUEUE_CAPACITY) {
+    if (!is_motion(event->type)) {
+      QUEUE_ADD(&dropped, 1);
+      return false;
+    }
+    memcpy(&motion_buffers[motion_back], event, sizeof(uiohook_event));
+    queue_word previous = QUEUE_EXCHANGE(&motion_middle, motion_back | MOTION_FRESH);
+    motion_back = (int)(previous & ~MOTION_FRESH);
+    if (previous & MOTION_FRESH) {
+      // Only the latest pointer position matters to consumers.
+      QUEUE_ADD(&coalesced, 1);
+      return false;
+    }
+    QUEUE_ADD(&queued, 1);
+    return request_wakeup();
+  }
+
+  memcpy(&slots[position & QUEUE_MASK], event, sizeof(uiohook_event));
+  QUEUE_STORE(&tail, position + 1);
+  QUEUE_ADD(&queued, 1);
+  note_depth(depth + 1);
+  return request_wakeup();
+}
+
+static size_t take(uiohook_event* out, size_t max) {
+  queue_word position = QUEUE_LOAD(&head);
+  queue_word available = QUEUE_LOAD(&tail) - position;
+  size_t taken = (size_t)available < max ? (size_t)available : max;
+  for (size_t i = 0; i < taken; i++) {
+    memcpy(&out[i], &slots[(position + i) & QUEUE_MASK], sizeof(uiohook_event));
+  }
+  QUEUE_STORE(&head, position + (queue_word)taken);
+
+  // The overflow motion is newer than everything in the ring.
+  if (taken == 0 && max > 0 && (QUEUE_LOAD(&motion_middle) & MOTION_FRESH)) {
+    queue_word previous = QUEUE_EXCHANGE(&motion_middle, motion_front);
+    motion_front = (int)(previous & ~MOTION_FRESH);
+    memcpy(&out[0], &motion_buffers[motion_front], sizeof(uiohook_event));
+    taken = 1;
+  }
+  return taken;
+}
+
+size_t event_queue_pop(uiohook_event* out, size_t max) {
+  size_t taken = take(out, max);
+  if (taken > 0) {
+    return taken;
+  }
+
+  // Going idle. A push that lands between the empty check and clearing the
+  // flag saw it still set and skipped its wakeup, so look once more and
+  // stay the active consumer if something arrived.
+  QUEUE_STORE(&wakeup_pending, 0);
+  if (QUEUE_LOAD(&tail) != QUEUE_LOAD(&head) || (QUEUE_LOAD(&motion_middle) & MOTION_FRESH)) {
+    if (request_wakeup()) {
+      return take(out, max);
+    }
+  }
+  return 0;
+}
+
+void event_queue_cancel_wakeup() {
+  QUEUE_STORE(&wakeup_pending, 0);
+}
+
+void event_queue_get_stats(event_queue_stats* out) {
+  queue_word depth = QUEUE_LOAD(&tail) - QUEUE_LOAD(&head);
+  if (QUEUE_LOAD(&motion_middle) & MOTION_FRESH) {
+    depth++;
+  }
+  out->queued = (uint64_t)QUEUE_LOAD(&queued);
+  out->coalesced = (uint64_t)QUEUE_LOAD(&coalesced);
+  out->dropped = (uint64_t)QUEUE_LOAD(&dropped);
+  out->depth = (uint32_t)depth;
+  out->high_water = (uint32_t)QUEUE_LOAD(&high_water);
+}
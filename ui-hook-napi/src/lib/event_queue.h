@@ -0,0 +1,40 @@
+#ifndef ADDON_SRC_EVENT_QUEUE_H_
+#define ADDON_SRC_EVENT_QUEUE_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <uiohook.h>
+
+// Number of preallocated event slots between the hook thread and JS.
+#define EVENT_QUEUE_CAPACITY 2048
+
+typedef struct {
+  uint64_t queued;
+  uint64_t coalesced;
+  uint64_t dropped;
+  uint32_t depth;
+  uint32_t high_water;
+} event_queue_stats;
+
+// Clears queued events, counters and the pending wakeup. Only while the hook
+// thread is not running.
+void event_queue_reset();
+
+// Hook thread only. Copies `event` into the slab without locking or
+// allocating. When the queue is full the latest motion event is kept in a
+// separate slot, replacing any motion already waiting there, and anything
+// else is dropped. Returns true when the consumer is idle and needs a wakeup.
+bool event_queue_push(const uiohook_event* event);
+
+// JS thread only. Moves up to `max` events into `out`. Returns 0 once the
+// queue is empty, at which point the consumer is considered idle again.
+size_t event_queue_pop(uiohook_event* out, size_t max);
+
+// Marks the consumer idle after a wakeup could not be delivered, so the next
+// push requests a new one.
+void event_queue_cancel_wakeup();
+
+void event_queue_get_stats(event_queue_stats* stats);
+
+#endif // !ADDON_SRC_EVENT_QUEUE_H_
@@ -0,0 +1,11 @@
+#ifndef ADDON_SRC_KEYMAP_H_
+#define ADDON_SRC_KEYMAP_H_
+
+#include <stdint.h>
+
+// Translates a libuiohook virtual keycode (VC_*) into the USB HID usage ID
+// of the physical key (Keyboard/Keypad page 0x07). Returns 0 when the key
+// has no mapping.
+uint16_t keycode_to_hid_usage(uint16_t keycode);
+
+#endif // !ADDON_SRC_KEYMAP_H_
@@ -0,0 +1,156 @@
+#include <stdbool.h>
+#include <string.h>
+#include <uiohook.h>
+#include "post_sequence.h"
+
+#if defined(_WIN32)
+#include <windows.h>
+#elif defined(__APPLE__)
+#include <ApplicationServices/ApplicationServices.h>
+#else
+#include <X11/Xlib.h>
+
+// Only used by the one sequence that runs at a time, so it needs no lock.
+static Display* pointer_display = NULL;
+#endif
+
+static bool query_pointer(int32_t* x, int32_t* y) {
+#if defined(_WIN32)
+  POINT point;
+  if (!GetCursorPos(&point)) {
+    return false;
+  }
+  *x = point.x;
+  *y = point.y;
+  return true;
+#elif defined(__APPLE__)
+  CGEventRef event = CGEventCreate(NULL);
+  if (event == NULL) {
+    return false;
+  }
+  CGPoint point = CGEventGetLocation(event);
+  CFRelease(event);
+  *x = (int32_t)point.x;
+  *y = (int32_t)point.y;
+  return true;
+#else
+  if (pointer_display == NULL) {
+    pointer_display = XOpenDisplay(NULL);
+    if (pointer_display == NULL) {
+      return false;
+    }
+  }
+  Window root, child;
+  int root_x, root_y, win_x, win_y;
+  unsigned int mask;
+  if (!XQueryPointer(pointer_display, DefaultRootWindow(pointer_display),
+                     &root, &child, &root_x, &root_y, &win_x, &win_y, &mask)) {
+    return false;
+  }
+  *x = root_x;
+  *y = root_y;
+  return true;
+#endif
+}
+
+// Fills in the current pointer position for records without coordinates.
+// libuiohook moves the pointer to the event's x/y when posting buttons and
+// wheel rotations, so passing 0 would warp it to the corner.
+static void resolve_position(const int32_t* record, int32_t* x, int32_t* y) {
+  *x = record[2];
+  *y = record[3];
+  if (*x != POST_SEQUENCE_NO_COORD && *y != POST_SEQUENCE_NO_COORD) {
+    return;
+  }
+  int32_t pointer_x = 0, pointer_y = 0;
+  query_pointer(&pointer_x, &pointer_y);
+  if (*x == POST_SEQUENCE_NO_COORD) *x = pointer_x;
+  if (*y == POST_SEQUENCE_NO_COORD) *y = pointer_y;
+}
+
+static void post_key(uint16_t keycode, event_type type) {
+  uiohook_event event;
+  memset(&event, 0, sizeof(event));
+  event.type = type;
+  event.data.keyboard.keycode = keycode;
+  hook_post_event(&event);
+}
+
+static void post_mouse(const int32_t* record, event_type type) {
+  int32_t x, y;
+  resolve_position(record, &x, &y);
+  uiohook_event event;
+  memset(&event, 0, sizeof(event));
+  event.type = type;
+  event.data.mouse.button = (uint16_t)record[1];
+  event.data.mouse.x = (int16_t)x;
+  event.data.mouse.y = (int16_t)y;
+  hook_post_event(&event);
+}
+
+static void post_wheel_event(const int32_t* record) {
+  int32_t x, y;
+  resolve_position(record, &x, &y);
+  uiohook_event event;
+  memset(&event, 0, sizeof(event));
+  event.type = EVENT_MOUSE_WHEEL;
+  event.data.wheel.type = WHEEL_UNIT_SCROLL;
+  event.data.wheel.amount = 3;
+  event.data.wheel.direction = WHEEL_VERTICAL_DIRECTION;
+  event.data.wheel.rotation = (int16_t)record[1];
+  event.data.wheel.x = (int16_t)x;
+  event.data.wheel.y = (int16_t)y;
+  hook_post_event(&event);
+}
+
+ptrdiff_t post_sequence_validate(const int32_t* records, size_t count) {
+  for (size_t i = 0; i < count; i++) {
+    const int32_t* record = records + i * POST_SEQUENCE_STRIDE;
+    if (record[0] < post_key_down || record[0] > post_wheel || record[4] < 0) {
+      return (ptrdiff_t)i;
+    }
+    if (record[0] == post_mouse_move &&
+        (record[2] == POST_SEQUENCE_NO_COORD || record[3] == POST_SEQUENCE_NO_COORD)) {
+      return (ptrdiff_t)i;
+    }
+  }
+  return -1;
+}
+
+void post_sequence_run(const int32_t* records, size_t count, post_sequence_wait_fn wait) {
+  for (size_t i = 0; i < count; i++) {
+    const int32_t* record = records + i * POST_SEQUENCE_STRIDE;
+    switch ((post_sequence_action)record[0]) {
+    case post_key_down:
+      post_key((uint16_t)record[1], EVENT_KEY_PRESSED);
+      break;
+    case post_key_up:
+      post_key((uint16_t)record[1], EVENT_KEY_RELEASED);
+      break;
+    case post_key_tap:
+      post_key((uint16_t)record[1], EVENT_KEY_PRESSED);
+      post_key((uint16_t)record[1], EVENT_KEY_RELEASED);
+      break;
+    case post_mouse_move:
+      post_mouse(record, EVENT_MOUSE_MOVED);
+      break;
+    case post_mouse_down:
+      post_mouse(record, EVENT_MOUSE_PRESSED);
+      break;
+    case post_mouse_up:
+      post_mouse(record, EVENT_MOUSE_RELEASED);
+      break;
+    case post_mouse_click:
+      post_mouse(record, EVENT_MOUSE_PRESSED);
+      post_mouse(record, EVENT_MOUSE_RELEASED);
+      break;
+    case post_wheel:
+      post_wheel_event(record);
+      break;
+    }
+
+    if (record[4] > 0 && !wait((unsigned int)record[4])) {
+      return;
+    }
+  }
+}
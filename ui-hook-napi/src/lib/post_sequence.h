@@ -0,0 +1,41 @@
+#ifndef ADDON_SRC_POST_SEQUENCE_H_
+#define ADDON_SRC_POST_SEQUENCE_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// A sequence is a packed array of int32 records, POST_SEQUENCE_STRIDE values
+// each: [action, code, x, y, delay_ms]. `code` is the keycode for key actions,
+// the button for mouse button actions and the rotation for wheel actions.
+// `delay_ms` is slept after the action has been posted.
+#define POST_SEQUENCE_STRIDE 5
+
+// x/y value meaning "wherever the pointer is": button and wheel actions leave
+// the pointer where it is instead of warping it. Moves require coordinates.
+#define POST_SEQUENCE_NO_COORD INT32_MIN
+
+typedef enum {
+  post_key_down = 0,
+  post_key_up = 1,
+  post_key_tap = 2,
+  post_mouse_move = 3,
+  post_mouse_down = 4,
+  post_mouse_up = 5,
+  post_mouse_click = 6,
+  post_wheel = 7
+} post_sequence_action;
+
+// Returns the index of the first invalid record, or -1 if all are valid.
+ptrdiff_t post_sequence_validate(const int32_t* records, size_t count);
+
+// Waits out a record's delay; returns false to abandon the rest of the
+// sequence.
+typedef bool (*post_sequence_wait_fn)(unsigned int delay_ms);
+
+// Posts every record in order, waiting between them. Not reentrant: callers
+// run one sequence at a time (addon.c queues them) so events never
+// interleave.
+void post_sequence_run(const int32_t* records, size_t count, post_sequence_wait_fn wait);
+
+#endif // !ADDON_SRC_POST_SEQUENCE_H_
@@ -21,6 +21,24 @@ static uv_cond_t hook_control_cond;
 
 static dispatcher_t user_dispatcher = NULL;
 
+// Written from the JS thread and read on the hook thread. A word-sized store
+// is atomic on every supported target, and a stale mask only affects the
+// event in flight.
+static volatile uint32_t user_event_mask = 0xFFFFFFFF;
+
+#define MOTION_EVENTS_MASK ((1u << EVENT_MOUSE_MOVED) | (1u << EVENT_MOUSE_DRAGGED))
+
+#if !defined(_WIN32) && !defined(__APPLE__)
+// Added by src/libuiohook.patch. The XRecord range is fixed once the hook
+// runs, so MotionNotify is only recorded when motion was wanted at start;
+// uiohook_worker_set_event_mask() restarts the hook to widen it.
+extern void hook_set_x11_record_motion(bool record);
+#define X11_RECORD_RANGE
+#endif
+
+static bool worker_running = false;
+static bool recording_motion = true;
+
 bool logger_proc(unsigned int level, const char* format, ...) {
   bool status = false;
 
@@ -72,7 +90,9 @@ void worker_dispatch_proc(uiohook_event* const event) {
   case EVENT_MOUSE_MOVED:
   case EVENT_MOUSE_DRAGGED:
   case EVENT_MOUSE_WHEEL: {
-    user_dispatcher(event);
+    if (user_event_mask & (1u << event->type)) {
+      user_dispatcher(event);
+    }
     break;
   }
 
@@ -171,9 +191,15 @@ int uiohook_worker_start(dispatcher_t dispatch_proc) {
 
   user_dispatcher = dispatch_proc;
 
+  recording_motion = (user_event_mask & MOTION_EVENTS_MASK) != 0;
+#ifdef X11_RECORD_RANGE
+  hook_set_x11_record_motion(recording_motion);
+#endif
+
   // Start the hook and block.
   // NOTE If EVENT_HOOK_ENABLED was delivered, the status will always succeed.
   int status = hook_enable();
+  worker_running = status == UIOHOOK_SUCCESS;
   if (status != UIOHOOK_SUCCESS) {
     // Close event handles for the thread hook.
     uv_mutex_destroy(&hook_running_mutex);
@@ -189,6 +215,7 @@ int uiohook_worker_stop() {
 
   if (status == UIOHOOK_SUCCESS) {
     uv_thread_join(&hook_thread);
+    worker_running = false;
 
     // Close event handles for the thread hook.
     uv_mutex_destroy(&hook_running_mutex);
@@ -198,3 +225,17 @@ int uiohook_worker_stop() {
 
   return status;
 }
+
+int uiohook_worker_set_event_mask(uint32_t mask) {
+  user_event_mask = mask;
+#ifdef X11_RECORD_RANGE
+  if (worker_running && !recording_motion && (mask & MOTION_EVENTS_MASK)) {
+    int status = uiohook_worker_stop();
+    if (status != UIOHOOK_SUCCESS) {
+      return status;
+    }
+    return uiohook_worker_start(user_dispatcher);
+  }
+#endif
+  return UIOHOOK_SUCCESS;
+}
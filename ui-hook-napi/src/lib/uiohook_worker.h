@@ -9,4 +9,11 @@ int uiohook_worker_start(dispatcher_t dispatch_proc);
 
 int uiohook_worker_stop();
 
+// Bit (1 << event_type) set for every event type the dispatcher wants;
+// others are discarded on the hook thread before reaching it. Defaults to
+// all types. On X11, pointer motion is not even recorded while the mask
+// excludes it at start; asking for it later restarts the hook, and a failed
+// restart is returned with the hook stopped.
+int uiohook_worker_set_event_mask(uint32_t mask);
+
 #endif // !ADDON_SRC_UIOHOOK_WORKER_H_